@@ -23,8 +23,38 @@ import matplotlib as mpl
 import numpy as np
 
 
+# Binary output (analysis_format: npy) => <name>.npy (+ <name>_offsets.npy for ragged rows)
+def npy_path(dir_path, file_name, suffix=""):
+    return os.path.join(dir_path, os.path.splitext(file_name)[0] + suffix + ".npy")
+
+
+# Use binary output if it exists and is not older than the txt output of the same name
+# (analysis_format changed between runs => both formats exist in dir_path)
+def use_npy(dir_path, file_name):
+    npy = npy_path(dir_path, file_name)
+    txt = os.path.join(dir_path, file_name)
+    if not os.path.exists(npy):
+        return False
+    return not os.path.exists(txt) or os.path.getmtime(npy) >= os.path.getmtime(txt)
+
+
+# Load ragged rows from flat values and offsets, padded with nan to the longest row
+def load_ragged(dir_path, file_name):
+    vals = np.load(npy_path(dir_path, file_name))
+    offs = np.load(npy_path(dir_path, file_name, "_offsets"))
+    lengths = np.diff(offs)
+    out = np.full((len(lengths), max(np.max(lengths, initial=0), 1)), np.nan)
+    for i in range(len(lengths)):
+        out[i, : lengths[i]] = vals[offs[i] : offs[i + 1]]
+    return out
+
+
 def load_file(dir_path, file_name, deli):
-    if os.path.exists(os.path.join(dir_path, file_name)):
+    if use_npy(dir_path, file_name):
+        if os.path.exists(npy_path(dir_path, file_name, "_offsets")):
+            return np.transpose(load_ragged(dir_path, file_name))
+        return np.transpose(np.load(npy_path(dir_path, file_name)))
+    elif os.path.exists(os.path.join(dir_path, file_name)):
         var = np.transpose(np.genfromtxt(os.path.join(dir_path, file_name), delimiter=deli))
         return var
     else:
@@ -32,7 +62,11 @@ def load_file(dir_path, file_name, deli):
 
 
 def load_file_man(dir_path, file_name, deli):
-    if os.path.exists(os.path.join(dir_path, file_name)):
+    if use_npy(dir_path, file_name):
+        if os.path.exists(npy_path(dir_path, file_name, "_offsets")):
+            return load_ragged(dir_path, file_name)
+        return np.atleast_2d(np.load(npy_path(dir_path, file_name)))
+    elif os.path.exists(os.path.join(dir_path, file_name)):
         out = []
         lengths = []
         with open(os.path.join(dir_path, file_name), "r") as file:
@@ -52,7 +86,9 @@ def load_file_man(dir_path, file_name, deli):
 
 
 def load_file_str(dir_path, file_name):
-    if os.path.exists(os.path.join(dir_path, file_name)):
+    if use_npy(dir_path, file_name):
+        return [code.decode() for code in np.load(npy_path(dir_path, file_name))]
+    elif os.path.exists(os.path.join(dir_path, file_name)):
         out = []
         with open(os.path.join(dir_path, file_name), "r") as file:
             for line in file:
@@ -0,0 +1,81 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "analysis.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*******************************************************************************
+ * Create synthetic source trajectory (random heading walk) and a noisy target
+ * trajectory with the same number of points
+ ********************************************************************************/
+void create_trajectories(
+  const size_t num_pts, lanelet::LineString3d & src, lanelet::LineString3d & target)
+{
+  std::mt19937 gen(42);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+  for (size_t i = 0; i < num_pts; ++i) {
+    heading += 0.05 * noise(gen);
+    x += std::cos(heading);
+    y += std::sin(heading);
+    src.push_back(lanelet::Point3d(lanelet::utils::getId(), x, y, 0.0));
+    target.push_back(
+      lanelet::Point3d(lanelet::utils::getId(), x + 2.0 * noise(gen), y + 2.0 * noise(gen), 0.0));
+  }
+}
+
+/************
+ * main
+ *************/
+int main(int argc, char ** argv)
+{
+  const size_t num_pts = (argc > 1) ? std::stoul(argv[1]) : 13000;
+  lanelet::LineString3d src(lanelet::utils::getId());
+  lanelet::LineString3d target(lanelet::utils::getId());
+  create_trajectories(num_pts, src, target);
+
+  canalysis analysis;
+  std::vector<double> diff_brute, diff_grid;
+  auto t0 = std::chrono::steady_clock::now();
+  analysis.calc_diff_brute(src, target, diff_brute);
+  auto t1 = std::chrono::steady_clock::now();
+  analysis.calc_diff(src, target, diff_grid);
+  auto t2 = std::chrono::steady_clock::now();
+
+  const bool identical =
+    diff_brute.size() == diff_grid.size() &&
+    std::memcmp(diff_brute.data(), diff_grid.data(), diff_brute.size() * sizeof(double)) == 0;
+  std::cout << "calc_diff with " << num_pts << " points:" << std::endl;
+  std::cout << "  brute force: " << std::chrono::duration<double>(t1 - t0).count() << " s"
+            << std::endl;
+  std::cout << "  grid:        " << std::chrono::duration<double>(t2 - t1).count() << " s"
+            << std::endl;
+  std::cout << "  bit-identical: " << (identical ? "yes" : "no") << std::endl;
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "utility.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+/*******************************************************************************
+ * Create synthetic polyline (random heading walk) of segments far away from the
+ * origin of the map frame (e.g. UTM-coordinates)
+ ********************************************************************************/
+lanelet::LineStrings3d create_pline(
+  const size_t num_seg, const Eigen::Vector2d & start, std::mt19937 & gen)
+{
+  std::normal_distribution<double> noise(0.0, 1.0);
+  lanelet::LineStrings3d pline;
+  lanelet::Point3d pt(lanelet::InvalId, start.x(), start.y(), 0.0);
+  double heading = 0.0;
+  for (size_t i = 0; i < num_seg; ++i) {
+    heading += 0.1 * noise(gen);
+    lanelet::Point3d pt_(
+      lanelet::InvalId, pt.x() + 5.0 * std::cos(heading), pt.y() + 5.0 * std::sin(heading), 0.0);
+    pline.push_back(lanelet::LineString3d(lanelet::InvalId, {pt, pt_}));
+    pt = pt_;
+  }
+  return pline;
+}
+
+/*****************************************************
+ * Distance of a point to the boundary of a polygon
+ ******************************************************/
+double dist_boundary(
+  const lanelet::BasicPoint2d * poly, const size_t n, const lanelet::BasicPoint2d & pt)
+{
+  double min = std::numeric_limits<double>::max();
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    const Eigen::Vector2d d = poly[i] - poly[j];
+    const double t = std::clamp((pt - poly[j]).dot(d) / d.squaredNorm(), 0.0, 1.0);
+    min = std::min(min, (pt - (poly[j] + t * d)).norm());
+  }
+  return min;
+}
+
+/************
+ * main
+ *************/
+int main(int argc, char ** argv)
+{
+  const size_t num_pts = (argc > 1) ? std::stoul(argv[1]) : 20000;
+  const double tol = 1e-3;
+  std::mt19937 gen(42);
+
+  // Polyline with buffers and local origin (center of the polyline)
+  const lanelet::LineStrings3d pline = create_pline(200, Eigen::Vector2d(691000.0, 5335000.0), gen);
+  Eigen::AlignedBox2d box;
+  for (const auto & ls : pline) {
+    box.extend(Eigen::Vector2d(ls.front().x(), ls.front().y()));
+    box.extend(Eigen::Vector2d(ls.back().x(), ls.back().y()));
+  }
+  const Eigen::Vector2d origin = box.center();
+
+  lanelet::BasicPoints2d buf;
+  buffer_polygons(pline, 2.5, 3.0, 0.5, buf);
+  std::vector<Eigen::Vector2f> buf_f;
+  for (const auto & pt : buf) {
+    buf_f.push_back((pt - origin).cast<float>());
+  }
+
+  // Query points around the polyline
+  std::uniform_real_distribution<double> ux(box.min().x() - 5.0, box.max().x() + 5.0);
+  std::uniform_real_distribution<double> uy(box.min().y() - 5.0, box.max().y() + 5.0);
+  lanelet::BasicPoints2d pts;
+  std::vector<Eigen::Vector2f> pts_f;
+  for (size_t i = 0; i < num_pts; ++i) {
+    pts.push_back(lanelet::BasicPoint2d(ux(gen), uy(gen)));
+    pts_f.push_back((pts.back() - origin).cast<float>());
+  }
+
+  /***************************************************************
+   * Buffer tests => differences only allowed on the boundary
+   ****************************************************************/
+  std::vector<char> in_d(num_pts, 0), in_f(num_pts, 0);
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_pts; ++i) {
+    for (size_t k = 0; k < buf.size() && !in_d[i]; k += buffer_points) {
+      in_d[i] = inside_polygon(&buf[k], buffer_points, pts[i]);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_pts; ++i) {
+    for (size_t k = 0; k < buf_f.size() && !in_f[i]; k += buffer_points) {
+      in_f[i] = inside_polygon(&buf_f[k], buffer_points, pts_f[i]);
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  size_t diff_buf = 0;
+  for (size_t i = 0; i < num_pts; ++i) {
+    if (in_d[i] != in_f[i]) {
+      double d = std::numeric_limits<double>::max();
+      for (size_t k = 0; k < buf.size(); k += buffer_points) {
+        d = std::min(d, dist_boundary(&buf[k], buffer_points, pts[i]));
+      }
+      diff_buf += (d > tol) ? 1 : 0;
+    }
+  }
+
+  /*****************************************************
+   * Chamfer distance between two polylines
+   ******************************************************/
+  const lanelet::LineStrings3d pline_2 =
+    create_pline(200, Eigen::Vector2d(691001.0, 5335001.5), gen);
+  lanelet::BasicPoints2d pts_1, pts_2;
+  std::vector<Eigen::Vector2f> pts_1f, pts_2f;
+  for (const auto & ls : pline) {
+    pts_1.push_back(lanelet::utils::to2D(ls.front().basicPoint()));
+    pts_1f.push_back((pts_1.back() - origin).cast<float>());
+  }
+  for (const auto & ls : pline_2) {
+    pts_2.push_back(lanelet::utils::to2D(ls.front().basicPoint()));
+    pts_2f.push_back((pts_2.back() - origin).cast<float>());
+  }
+  const double cd = closest_sum(pts_1, pts_2) / pts_1.size();
+  const double cd_f = closest_sum(pts_1f, pts_2f) / pts_1f.size();
+
+  /*****************************************************
+   * Point cloud transformation (rubber-sheeting)
+   ******************************************************/
+  // Small rotation/scaling around a point of the tile and shift by a few metres
+  const double angle = 0.5 * std::atan(1.0) * 4 / 180.0;
+  const Eigen::Vector2d center = origin + Eigen::Vector2d(30.0, -20.0);
+  Eigen::Matrix3d trans = Eigen::Matrix3d::Identity();
+  trans.block<2, 2>(0, 0) = 1.001 * Eigen::Rotation2Dd(angle).toRotationMatrix();
+  trans.block<2, 1>(0, 2) = center - trans.block<2, 2>(0, 0) * center + Eigen::Vector2d(2.0, -1.5);
+  const Eigen::Matrix3f trans_f = local_transform<float>(trans, origin);
+  double diff_trans = 0.0;
+  for (size_t i = 0; i < num_pts; ++i) {
+    const Eigen::Vector3d pt = trans * Eigen::Vector3d(pts[i].x(), pts[i].y(), 1.0);
+    const Eigen::Vector3f pt_f = trans_f * Eigen::Vector3f(pts_f[i].x(), pts_f[i].y(), 1.0f);
+    diff_trans = std::max(
+      diff_trans, (pt.head<2>() - (origin + pt_f.head<2>().cast<double>())).norm());
+  }
+
+  const bool accurate = diff_buf == 0 && std::abs(cd - cd_f) < tol && diff_trans < tol;
+  std::cout << "float32 geometry with " << num_pts << " points:" << std::endl;
+  std::cout << "  buffer tests double: " << std::chrono::duration<double>(t1 - t0).count()
+            << " s" << std::endl;
+  std::cout << "  buffer tests float:  " << std::chrono::duration<double>(t2 - t1).count()
+            << " s" << std::endl;
+  std::cout << "  buffer tests differing off the boundary: " << diff_buf << std::endl;
+  std::cout << "  chamfer distance error: " << std::abs(cd - cd_f) << " m" << std::endl;
+  std::cout << "  max. transformation error: " << diff_trans << " m" << std::endl;
+  std::cout << "  accurate to " << tol << " m: " << (accurate ? "yes" : "no") << std::endl;
+  return accurate ? 0 : 1;
+}
@@ -33,7 +33,14 @@
 #include <lanelet2_io/Io.h>
 #include <lanelet2_projection/UTM.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -41,113 +48,206 @@ class canalysis
 {
 public:
   canalysis();
+  ~canalysis();
+
+  /*************************************************************************
+   * Start background thread writing staged analysis data
+   * => at most <capacity> files are queued, staging blocks if queue full
+   **************************************************************************/
+  void start_writer(const size_t capacity);
+
+  /*****************************************************************************
+   * Wait until all staged analysis data is written and stop background thread
+   * => returns number of files written so far
+   ******************************************************************************/
+  size_t wait();
 
   /************************************************************************
-   * Calculate difference between aligned and rubber-sheeted trajectory
-   * and export everything into txt-files for python-visualization
+   * Calculate difference between master and aligned trajectory and
+   * stage trajectories for python-visualization
    *************************************************************************/
-  bool traj_matching(
+  bool traj_alignment(
     rclcpp::Node & node, const lanelet::ConstLineString3d & src,
     const lanelet::ConstLineString3d & target, const lanelet::ConstLineString3d & target_al,
+    std::vector<double> & diff_al);
+
+  /************************************************************************
+   * Calculate difference between master and rubber-sheeted trajectory and
+   * stage rubber-sheeting results for python-visualization
+   *************************************************************************/
+  bool traj_rubber_sheeting(
+    rclcpp::Node & node, const lanelet::ConstLineString3d & src,
     const lanelet::ConstLineString3d & target_rs, const lanelet::Areas & tri,
-    const std::vector<s_control_point> & cps, std::vector<double> & diff_al,
-    std::vector<double> & diff_rs);
-
-  /*************************************************************
-   * Export matching data in txt-files for python-visualization
-   **************************************************************/
-  bool matching(
-    rclcpp::Node & node, const std::vector<s_match> & matches, const lanelet::LineStrings3d & osm,
-    const lanelet::ConstLanelets & lls, std::vector<std::pair<lanelet::Id, std::string>> & ll_cols,
+    const std::vector<s_control_point> & cps, std::vector<double> & diff_rs);
+
+  /*******************************************************************
+   * Stage matches and openstreetmap-linestrings for python-visualization
+   ********************************************************************/
+  bool matching_results(
+    rclcpp::Node & node, const std::vector<s_match> & matches, const lanelet::LineStrings3d & osm);
+
+  /***************************************************************************
+   * Stage original (colored) and updated lanelets for python-visualization
+   ****************************************************************************/
+  bool matching_lanelets(
+    rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & ll_cols,
     const lanelet::ConstLanelets & lls_updated);
 
-private:
-  /***************************************************************
+  /***************************************************************************
    * Calculate difference between source & target trajectory
    * => vertical distance from target to source for each point
-   ****************************************************************/
+   * => segments of source indexed in a uniform grid, closest segment found
+   *    with a ring search around each point, points processed in parallel
+   * => bit-identical to calc_diff_brute (same distance kernel)
+   ****************************************************************************/
   void calc_diff(
     const lanelet::ConstLineString3d & src, const lanelet::ConstLineString3d & target,
     std::vector<double> & diff);
 
+  /***************************************************************
+   * Calculate difference between source & target trajectory
+   * => distance of each point to every segment (reference)
+   ****************************************************************/
+  void calc_diff_brute(
+    const lanelet::ConstLineString3d & src, const lanelet::ConstLineString3d & target,
+    std::vector<double> & diff);
+
+private:
+  /***************************************************************************
+   * Distance of a point to a segment of the source trajectory
+   * => minimum distance to the segment points for segments shorter than 1cm
+   ****************************************************************************/
+  double seg_dist(
+    const lanelet::ConstPoint3d & pt, const lanelet::ConstPoint3d & a,
+    const lanelet::ConstPoint3d & b);
+
   /*******************************************************************************
    * Create subdirectory in the desired output-directory if not existing so far
    ********************************************************************************/
   void create_output_dir(rclcpp::Node & node, const std::string & dir_path);
 
   /**************************************
-   * Write linestring to txt-file
+   * Write linestring to file
    ***************************************/
   void write_ls(
     rclcpp::Node & node, const lanelet::ConstLineString3d & ls, const std::string & dir_path,
     const std::string & file_name);
 
   /**************************************
-   * Write linestrings to txt-file
+   * Write linestrings to file
    ***************************************/
   void write_lss(
     rclcpp::Node & node, const lanelet::LineStrings3d & lss, const std::string & dir_path,
     const std::string & file_name);
 
   /***************************************
-   * Write double-vector to txt-file
+   * Write double-vector to file
    ****************************************/
   void write_double_vec(
     rclcpp::Node & node, const std::vector<double> & vec, const std::string & dir_path,
     const std::string & file_name);
 
   /********************************
-   * Write areas to txt-file
+   * Write areas to file
    *********************************/
   void write_areas(
     rclcpp::Node & node, const lanelet::Areas & areas, const std::string & dir_path,
     const std::string & file_name);
 
   /****************************************
-   * Write controlpoints to txt-file
+   * Write controlpoints to file
    *****************************************/
   void write_cp(
     rclcpp::Node & node, const std::vector<s_control_point> & cps, const std::string & dir_path,
     const std::string & file_name);
 
   /**********************************************************************************
-   * Write reference or target polyline or match connection of a match to txt-file
+   * Write reference or target polyline or match connection of a match to file
    ***********************************************************************************/
   void write_match_pline(
     rclcpp::Node & node, const std::vector<s_match> & matches, const std::string & dir_path,
     const std::string & file_name);
 
   /***********************************************
-   * Write buffers of a match to txt-file
+   * Write buffers of a match to file
    ************************************************/
   void write_match_areas(
     rclcpp::Node & node, const std::vector<s_match> & matches, const std::string & dir_path,
     const std::string & file_name);
 
   /***********************************************
-   * Write lanelets of a map to txt-file
+   * Write lanelets of a map to file
    ************************************************/
   void write_lanelets(
     rclcpp::Node & node, const lanelet::ConstLanelets & lls, const std::string & dir_path,
     const std::string & file_name);
 
   /***********************************************
-   * Write lanelets of a map to txt-file
+   * Write lanelets of a map in WGS84 to file
    ************************************************/
   void write_lanelets_WGS84(
     rclcpp::Node & node, const lanelet::ConstLanelets & lls, const std::string & dir_path,
     const std::string & file_name);
 
   /***********************************************
-   * Write colors of lanelets of a map to txt-file
+   * Write colors of lanelets of a map to file
    ************************************************/
   void write_lanelets_cols(
-    rclcpp::Node & node, const lanelet::ConstLanelets & lls,
-    std::vector<std::pair<lanelet::Id, std::string>> & ll_cols, const std::string & dir_path,
-    const std::string & file_name);
+    rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & ll_cols,
+    const std::string & dir_path, const std::string & file_name);
+
+  /**************************************************************************************
+   * Stage rows of values to be written to file
+   * => fixed row width (cols > 0) or ragged rows described by offsets (cols = 0)
+   * => txt: one row per line separated by spaces
+   * => npy: array of shape (rows, cols) or flat values + int64 offsets (<name>_offsets)
+   ***************************************************************************************/
+  void write_rows(
+    rclcpp::Node & node, std::vector<double> vals, std::vector<int64_t> offs, const size_t cols,
+    const int prec, const std::string & dir_path, const std::string & file_name);
+
+  /*********************************************************************************
+   * Write raw array to npy-file (format version 1.0, little-endian, C-order)
+   **********************************************************************************/
+  void write_npy(
+    const std::string & file_path, const std::string & descr, const std::vector<size_t> & shape,
+    const char * data, const size_t n_bytes);
+
+  /**************************************************************************
+   * Path of npy-file => file extension replaced by <suffix>.npy
+   ***************************************************************************/
+  std::string npy_path(const std::string & file_path, const std::string & suffix);
+
+  /*******************************************************
+   * Check if analysis output is written in binary format
+   ********************************************************/
+  bool binary(rclcpp::Node & node);
+
+  /**************************************************************************
+   * Queue job writing a file for the background thread
+   * => blocks while the queue is full
+   * => executed immediately if no background thread is running
+   ***************************************************************************/
+  void stage(std::function<void()> job);
+
+  /*************************************************************************
+   * Background thread: write staged files until stopped and queue drained
+   **************************************************************************/
+  void io_loop();
 
   /********************************************************************
    * Convert vector of linestrings to vector of constlinestrings
    *********************************************************************/
   lanelet::ConstLineStrings3d to_const(const lanelet::LineStrings3d & lss);
+
+  // Background writer (staged files, signalled on new job/stop and on free space in queue)
+  std::deque<std::function<void()>> jobs;
+  std::mutex jobs_mutex;
+  std::condition_variable cv_jobs;
+  std::condition_variable cv_space;
+  std::thread io_thread;
+  size_t capacity = 1;
+  bool running = false;
+  bool stop = false;
+  std::atomic<size_t> written{0};
 };
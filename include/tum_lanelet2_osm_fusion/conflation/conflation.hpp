@@ -34,7 +34,7 @@
 #include <utility>
 #include <vector>
 
-class cconflation
+class cconflation : public cprogress_reporter
 {
 public:
   cconflation();
@@ -44,6 +44,13 @@ public:
    *************************************************************************/
   bool remove_tags(lanelet::LaneletMapPtr & map_ptr);
 
+  /*****************************************************************************
+   * Remove tags and color codes transferred from OpenStreetMap from the lanelets
+   * of a region before it is re-conflated (incremental update)
+   * => tags of ways that were removed/changed in the meantime do not survive
+   ******************************************************************************/
+  bool clear_conflated_tags(lanelet::Lanelets & region, s_color_table & cols);
+
   /***********************************************************************************
    * Conflate information from OpenStreetMap into existing lanelet map:
    * -> map highway tag from osm to subtype and location tags in lanelet2
@@ -56,8 +63,8 @@ public:
    * common boundary) and lanes tag in osm
    ************************************************************************************/
   bool conflate_lanelet_OSM(
-    lanelet::LaneletMapPtr & map_ptr, std::vector<s_match> & matches,
-    std::vector<std::pair<lanelet::Id, std::string>> & cols, lanelet::ConstLanelets & deleted);
+    lanelet::LaneletMapPtr & map_ptr, std::vector<s_match> & matches, s_color_table & cols,
+    lanelet::ConstLanelets & deleted);
 
   /**********************************************************************************
    * Create new map with all elements from map_ptr (original map) except the
@@ -99,8 +106,7 @@ private:
    * no lanes tag = blue, no match = white)
    ************************************************************************************/
   void check_lanes(
-    const lanelet::LaneletMapPtr & map_ptr, s_match & match,
-    std::vector<std::pair<lanelet::Id, std::string>> & cols,
+    const lanelet::LaneletMapPtr & map_ptr, s_match & match, s_color_table & cols,
     const lanelet::ConstPoints3d & pts_change_lanes,
     const lanelet::ConstPoints3d & pts_change_shoulder, std::vector<std::string> & val_lanes,
     std::vector<std::string> & val_shoulder, lanelet::ConstLanelets & deleted);
@@ -168,12 +174,7 @@ private:
    * Remove attributes from a given point specified by the keys
    *******************************************************************/
   void remove_attributes(lanelet::Point3d & pt, const std::vector<std::string> & names);
-
-  /*****************************************************************************
-   * Check if a lanelet id is already present in the vector with color codes
-   ******************************************************************************/
-  bool used_Id(
-    std::vector<std::pair<lanelet::Id, std::string>> & cols, const lanelet::Lanelet & ll);
+  void remove_attributes(lanelet::Lanelet & ll, const std::vector<std::string> & names);
 
   /*********************************************
    * Check if a linestring was already used
@@ -215,8 +216,7 @@ private:
    ************************************************************************************/
   void set_color_code_dir(
     const std::string & key, const lanelet::LineString3d & seg,
-    const lanelet::LaneletMapPtr & map_ptr, const std::string & col_code,
-    std::vector<std::pair<lanelet::Id, std::string>> & cols);
+    const lanelet::LaneletMapPtr & map_ptr, const std::string & col_code, s_color_table & cols);
 
   /*****************************************************************************************
    * Get lanelet subtype and location from openstreetmap's highway tag (custom definition)
@@ -0,0 +1,92 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ==========================================
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ==========================================
+//
+//
+#pragma once
+//
+#include "matching.hpp"
+#include "utility.hpp"
+
+#include <Eigen/Geometry>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/Lanelet.h>
+#include <lanelet2_core/primitives/LineString.h>
+
+#include <string>
+#include <vector>
+
+class cincremental : public cprogress_reporter
+{
+public:
+  cincremental();
+
+  /***************************************************************************************
+   * Find the lanelets affected by changed openstreetmap-ways based on the match table
+   * => lanelets matched to a changed/deleted way
+   * => unmatched lanelets within update_margin of a changed way (potential new match)
+   ****************************************************************************************/
+  bool impacted_region(
+    rclcpp::Node & node, const std::vector<s_match_record> & table, const lanelet::Ids & ways,
+    const lanelet::LineStrings3d & osm, const lanelet::LaneletMapPtr & map_ptr,
+    lanelet::Lanelets & region);
+
+  /**************************************************************************************
+   * Find the lanelets inside the corridor of a new trajectory (corridor_width to each
+   * side) and complete their street cross-sections based on the match table
+   ***************************************************************************************/
+  bool corridor_region(
+    rclcpp::Node & node, const lanelet::ConstLineString3d & traj,
+    const std::vector<s_match_record> & table, const lanelet::LaneletMapPtr & map_ptr,
+    lanelet::Lanelets & region);
+
+  /*****************************************************************************************
+   * Collapse and match a region of the lanelet map against the openstreetmap-linestrings
+   * surrounding the region (bounding box extended by update_margin)
+   ******************************************************************************************/
+  bool rematch_region(
+    rclcpp::Node & node, const lanelet::Lanelets & region, const lanelet::LineStrings3d & osm,
+    lanelet::LineStrings3d & ll_coll, std::vector<s_match> & matches);
+
+  /*********************************************************************
+   * Create match table entries from the reference polylines of matches
+   **********************************************************************/
+  std::vector<s_match_record> match_records(const std::vector<s_match> & matches);
+
+  /***************************************************************************
+   * Replace entries of the match table that contain lanelets of the region
+   * with the entries of the new matches
+   ****************************************************************************/
+  void update_table(
+    std::vector<s_match_record> & table, const lanelet::Lanelets & region,
+    const std::vector<s_match> & matches);
+
+private:
+  /*****************************************************
+   * Get 2D bounding box of a lanelet or linestring
+   ******************************************************/
+  Eigen::AlignedBox2d bbox(const lanelet::ConstLanelet & ll);
+  Eigen::AlignedBox2d bbox(const lanelet::ConstLineString3d & ls);
+
+  /**********************************************************
+   * Add an id to a vector if it's not already contained
+   ***********************************************************/
+  void add_unique(lanelet::Ids & ids, const lanelet::Id & id);
+};
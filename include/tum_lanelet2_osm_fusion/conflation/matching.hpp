@@ -31,12 +31,215 @@
 #include <lanelet2_core/primitives/Lanelet.h>
 #include <lanelet2_core/primitives/LineString.h>
 
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-class cmatching
+// Scratch containers of the matching allocated from the per-polyline arena
+using scratch_pline = std::pmr::vector<lanelet::LineString3d>;
+using scratch_plines = std::pmr::vector<scratch_pline>;
+using scratch_points = std::pmr::vector<lanelet::BasicPoint2d>;
+using scratch_ids = std::pmr::vector<lanelet::Id>;
+
+/*****************************************************************************************
+ * Struct to represent the linestring segments (2 points) of a network as compact table
+ * => points and segments as structure of arrays (points unique by id)
+ * => attributes are referenced by the parent linestring and only copied if a segment is
+ *    materialized as linestring (e.g. as part of a polyline or a match candidate)
+ * => only read during matching (see s_seg_view) => can be shared by parallel matchings
+ ******************************************************************************************/
+struct s_seg_table
 {
+public:
+  size_t size() const;
+  // Add point (if not added yet) and return its index
+  uint32_t add_point(const lanelet::Point3d & pt);
+  // Add segment between two points of a parent linestring
+  void add_segment(const uint32_t p0, const uint32_t p1, const uint32_t parent, const bool attr);
+  // 2D-coordinates of a point
+  lanelet::BasicPoint2d pt2d(const uint32_t p) const;
+  // Set float32 coordinates of all points relative to a local origin
+  void localize(const Eigen::Vector2d & origin);
+  // Local float32 2D-coordinates of a point (see localize)
+  Eigen::Vector2f pt2f(const uint32_t p) const;
+  // Create segment as linestring
+  lanelet::LineString3d segment(const size_t i) const;
+  // Id of the parent linestring of a segment by the segment id
+  lanelet::Id parent_id(const lanelet::Id seg_id) const;
+  // Direction of a segment [rad]
+  double heading(const size_t i) const;
+  // Build point -> segment adjacency (see pt_seg)
+  void index_points();
+  // Build heading-binned spatial index of the segments (bins = 0: no index)
+  void index_headings(const double cell, const size_t bins);
+  // Cell of a coordinate in the index
+  int64_t cell_ind(const double v) const;
+  // Heading bin of a direction [rad] in the index
+  size_t heading_bin(const double heading) const;
+  // Key of a cell and heading bin in the index
+  int64_t index_key(const int64_t ix, const int64_t iy, const size_t bin) const;
+
+  // Points
+  std::vector<double> x;                             // x-coordinates
+  std::vector<double> y;                             // y-coordinates
+  std::vector<double> z;                             // z-coordinates
+  std::vector<float> xf;                             // Local x-coordinates (float32)
+  std::vector<float> yf;                             // Local y-coordinates (float32)
+  std::vector<lanelet::Point3d> pts;                 // Point primitives
+  std::unordered_map<lanelet::Id, uint32_t> pt_ind;  // Point id -> point index
+  Eigen::Vector2d origin = Eigen::Vector2d::Zero();  // Local origin (see localize)
+
+  // Segments
+  std::vector<uint32_t> p0;                           // Index of first point
+  std::vector<uint32_t> p1;                           // Index of second point
+  std::vector<uint32_t> parent;                       // Index of parent linestring
+  std::vector<lanelet::Id> id;                        // Segment id
+  std::vector<uint8_t> attr;                          // Attributes of parent apply
+  lanelet::LineStrings3d parents;                     // Parent linestrings
+  std::unordered_map<lanelet::Id, uint32_t> seg_ind;  // Segment id -> segment index
+
+  // Point -> segment adjacency (compressed rows, see index_points)
+  std::vector<uint32_t> pt_seg_off;  // Point index -> first entry in pt_seg (points + 1)
+  std::vector<uint32_t> pt_seg;      // Segments starting or ending at a point (ascending)
+
+  // Heading-binned spatial index (see index_headings)
+  double cell = 0.0;                                         // Cell size [m]
+  size_t bins = 0;                                           // Heading bins (0: no index)
+  std::unordered_map<int64_t, std::vector<uint32_t>> index;  // Cell and heading bin -> segments
+};
+
+/************************************************************************************
+ * Struct to represent the segments of a shared segment table during one matching
+ * => segments are materialized (and modified, e.g. tags) per matching only
+ *************************************************************************************/
+struct s_seg_view
+{
+public:
+  explicit s_seg_view(const s_seg_table & table);
+  size_t size() const;
+  // Segment as linestring (created once per matching, afterwards shared)
+  lanelet::LineString3d segment(const size_t i);
+
+  const s_seg_table & t;  // Shared segment table
+
+private:
+  std::vector<std::optional<lanelet::LineString3d>> lss;  // Materialized segments
+};
+
+/*********************************************************
+ * Struct to represent the initial buffer parameters
+ **********************************************************/
+struct s_buffer_params
+{
+  double V;    // [m] Size in vertical direction
+  double P;    // [m] Size in longitudinal direction
+  double rad;  // [m] Radius on the corners
+};
+
+/*****************************************************************************************
+ * Struct to represent a scoring profile of match candidates
+ * => enabled geometric similarity measures, their limits (normalizing values) and weights
+ ******************************************************************************************/
+struct s_score_profile
+{
+  bool use_angle;      // Angle difference between first and last point of polylines
+  bool use_length;     // Length difference
+  bool use_chord;      // Chord difference
+  bool use_poly;       // Polygon area between polylines / sum of their lengths
+  bool use_frechet;    // Discrete Frechet distance
+  double lim_angle;    // [°] Limits/normalizing values
+  double lim_length;   // [m]
+  double lim_chord;    // [m]
+  double lim_poly;     // [m]
+  double lim_frechet;  // [m]
+  double w_angle;      // Weights
+  double w_len;
+  double w_chord;
+  double w_poly;
+  double w_frechet;
+};
+
+// Fixed profiles => motorway: long straight roads (no polygon area), urban: all measures
+// except the Frechet distance
+inline constexpr s_score_profile profile_motorway{
+  true, true, true, false, false, 10.0, 30.0, 25.0, 10.0, 0.0, 0.4, 0.2, 0.4, 0.0, 0.0};
+inline constexpr s_score_profile profile_urban{
+  true, true, true, true, false, 20.0, 20.0, 15.0, 10.0, 0.0, 0.35, 0.2, 0.35, 0.1, 0.0};
+
+/****************************************************************************************
+ * Scoring policy with a profile fixed at compile time
+ * => disabled measures and constant weights/limits are resolved by the compiler
+ *****************************************************************************************/
+template <const s_score_profile & P>
+struct s_fixed_scoring
+{
+  static constexpr const s_score_profile & profile() { return P; }
+};
+
+/**************************************************************************
+ * Scoring policy with a profile from the parameter file (all measures)
+ ***************************************************************************/
+struct s_param_scoring
+{
+public:
+  explicit s_param_scoring(rclcpp::Node & node);
+  explicit s_param_scoring(const s_score_profile & profile);
+  const s_score_profile & profile() const;
+
+private:
+  s_score_profile p;
+};
+
+/*********************************************************************************
+ * Struct to represent the geometric similarity measures of a candidate to the
+ * reference polyline (0 if disabled)
+ **********************************************************************************/
+struct s_measures
+{
+  double d_ang = 0.0;
+  double d_len = 0.0;
+  double d_chord = 0.0;
+  double d_poly = 0.0;
+  double d_frechet = 0.0;
+};
+
+/*********************************************************************************
+ * Struct to count the evaluations of geometric similarity measures of candidates
+ * (see select_candidate)
+ **********************************************************************************/
+struct s_eval_stats
+{
+  size_t plines = 0;      // Searched reference polylines
+  size_t outside = 0;     // Reference polylines without search (no coarse match, see s_corridors)
+  size_t segments = 0;    // Target segments tested against the buffers
+  size_t candidates = 0;  // Evaluated candidates
+  size_t measures = 0;    // Calculated measures
+  size_t skipped = 0;     // Measures skipped (candidate rejected or pruned)
+  size_t rejected = 0;    // Candidates rejected by a limit
+  size_t pruned = 0;      // Candidates pruned (score bound can't beat the best candidate)
+};
+
+/*****************************************************************************************
+ * Struct to represent the corridors of the coarse matches of the coarse-to-fine algorithm
+ * => the candidate search of a reference polyline is restricted to the target segments
+ *    inside the corridors of the coarse matches of its source linestrings
+ ******************************************************************************************/
+struct s_corridors
+{
+  std::unordered_map<lanelet::Id, std::vector<uint32_t>> src;  // Source linestring -> matches
+  std::vector<std::vector<uint32_t>> target;  // Target segment -> matches (sorted)
+};
+
+class cmatching : public cprogress_reporter
+{
+  // Unit tests of private steps of the matching (see test/test_matching.cpp)
+  friend struct s_matching_test;
+
 public:
   cmatching();
 
@@ -45,6 +248,7 @@ public:
    * of detail of openstreetmap-data
    *************************************************************************/
   bool collapse_ll_map(const lanelet::LaneletMapPtr & map_ptr, lanelet::LineStrings3d & ls_col);
+  bool collapse_ll_map(const lanelet::Lanelets & lls, lanelet::LineStrings3d & ls_col);
 
   /*****************************************************************************************
    * Apply buffer-growing map-matching-algorithm
@@ -53,9 +257,117 @@ public:
    ******************************************************************************************/
   bool buffer_growing(
     rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+    std::vector<s_match> & matches, const bool verbose = true);
+
+  /****************************************************************************************
+   * Split vector of linestrings with plines into vector of segments (copy attributes)
+   * => independent of buffer and scoring parameters (can be shared by multiple matchings)
+   *****************************************************************************************/
+  s_seg_table split_lss(rclcpp::Node & node, lanelet::LineStrings3d & lss);
+  s_seg_table split_lss(const lanelet::LineStrings3d & lss, const double seg_len);
+
+  /****************************************************************************************
+   * Split linestrings of the target dataset into segments (see split_lss) and set their
+   * float32 coordinates relative to the center of the segments (if selected)
+   *****************************************************************************************/
+  s_seg_table split_target(rclcpp::Node & node, lanelet::LineStrings3d & target);
+
+  /*****************************************************************************************
+   * Reuse the split and indexed target dataset of previous matchings (e.g. of a cached
+   * openstreetmap-excerpt, see split_target)
+   * => empty table is filled by the next matching, nullptr: split target for every matching
+   * => only valid as long as the target dataset and the matching parameters are unchanged
+   ******************************************************************************************/
+  void set_target_cache(const std::shared_ptr<s_seg_table> & cache);
+
+  /*****************************************************************************************
+   * Apply buffer-growing map-matching-algorithm on segment tables with the given buffer
+   * parameters and scoring profile
+   * => tables are only read (matchings with multiple parameter sets may run in parallel)
+   ******************************************************************************************/
+  bool match_segments(
+    rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+    const s_buffer_params & buffer, const s_score_profile & profile,
     std::vector<s_match> & matches);
 
+  /*****************************************************************************************
+   * Apply buffer-growing map-matching-algorithm on segment tables with the given buffer
+   * parameters and a scoring profile by name (see match_profile)
+   ******************************************************************************************/
+  bool match_segments(
+    rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+    const s_buffer_params & buffer, const std::string & profile, std::vector<s_match> & matches);
+
+  /*****************************************************
+   * Output matching statistics to the command window
+   ******************************************************/
+  void print_stats(rclcpp::Node & node, const std::vector<s_match> & matches);
+
+  /*****************************************************************
+   * Output evaluations of candidate measures to the command window
+   ******************************************************************/
+  void print_eval_stats(const s_eval_stats & eval);
+
 private:
+  /*****************************************************************************************
+   * Apply buffer-growing map-matching-algorithm at full resolution (seg_len)
+   ******************************************************************************************/
+  bool flat_matching(
+    rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+    std::vector<s_match> & matches);
+
+  /*****************************************************************************************
+   * Apply buffer-growing map-matching-algorithm coarse-to-fine
+   * => match Douglas-Peucker-simplified linestrings with coarse buffers first
+   * => full resolution matching of a reference polyline only on target segments inside the
+   *    corridors of the coarse matches of its source linestrings (no search without)
+   ******************************************************************************************/
+  bool coarse_to_fine(
+    rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+    std::vector<s_match> & matches);
+
+  /*****************************************************************************************
+   * Split and prepare the target dataset (see split_target) or reuse the table of the
+   * target cache (see set_target_cache)
+   ******************************************************************************************/
+  std::shared_ptr<const s_seg_table> target_table(
+    rclcpp::Node & node, lanelet::LineStrings3d & target);
+
+  /*****************************************************************************
+   * Simplify linestrings with Douglas-Peucker (2D)
+   * => original points (ids) and attributes are kept to preserve connectivity
+   ******************************************************************************/
+  lanelet::LineStrings3d simplify_lss(const lanelet::LineStrings3d & lss, const double tol);
+
+  /*****************************************************************************************
+   * Set float32 coordinates of target segments relative to their center (if selected) and
+   * build their heading-binned spatial index
+   ******************************************************************************************/
+  void prepare_target(rclcpp::Node & node, s_seg_table & target_seg);
+
+  /*****************************************************************************************
+   * Get segments of a table inside the corridors (given width to each side) around the
+   * target polylines of matches
+   * => matches of each kept segment whose corridor contains it in seg_matches
+   ******************************************************************************************/
+  s_seg_table corridor_segments(
+    const s_seg_table & seg, const std::vector<s_match> & matches, const double corridor,
+    std::vector<std::vector<uint32_t>> & seg_matches);
+
+  /*****************************************************************************
+   * Check if two matches were matched to the same openstreetmap-linestrings
+   ******************************************************************************/
+  bool same_target(const s_match & match_1, const s_match & match_2);
+
+  /*****************************************************************************************
+   * Apply buffer-growing map-matching-algorithm on segment tables with the given scoring
+   * policy
+   ******************************************************************************************/
+  template <typename ScoringT>
+  bool match_segments(
+    rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+    const s_buffer_params & buffer, std::vector<s_match> & matches, const ScoringT & scoring);
+
   /********************************************
    * Get centerline of a part of the street
    *********************************************/
@@ -69,58 +381,53 @@ private:
     const lanelet::Lanelets & lls, lanelet::LineStrings3d & lss,
     std::vector<std::pair<lanelet::Id, lanelet::Id>> & conn, lanelet::LineString3d & ls);
 
-  /****************************************************************************************
-   * Split vector of linestrings with plines into vector of segments (copy attributes)
-   *****************************************************************************************/
-  lanelet::LineStrings3d split_lss(rclcpp::Node & node, lanelet::LineStrings3d & lss);
-
   /*************************************************************************
    * Instantiate a polyline consisting of linestring segments with 2 points
    **************************************************************************/
   lanelet::LineStrings3d init_pline(
-    rclcpp::Node & node, const lanelet::LineString3d & ls, lanelet::LineStrings3d & lss,
-    lanelet::Ids & ids);
-
-  /*******************************************************************************
-   * Initialize buffers around each line segment based on the given parameters
-   ********************************************************************************/
-  lanelet::Areas create_buffer(
-    const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
-    const double rad);
+    rclcpp::Node & node, const lanelet::LineString3d & ls, s_seg_view & lss, lanelet::Ids & ids);
 
   /***********************************************************************
    * Find all line segments inside given buffers and return as candidates
    ************************************************************************/
-  std::vector<lanelet::LineStrings3d> matching_candidates(
-    const lanelet::LineStrings3d & ref_pline, const lanelet::Areas & buffers,
-    lanelet::LineStrings3d & lss);
+  scratch_plines matching_candidates(
+    const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers, s_seg_view & lss);
 
-  /************************************************************************
-   * Exclude match candidates if one of their geometric measures to
-   * the reference polyline exceeds the limits
-   *************************************************************************/
-  std::vector<lanelet::LineStrings3d> exclude_candidates(
-    rclcpp::Node & node, const lanelet::LineStrings3d & ref,
-    const std::vector<lanelet::LineStrings3d> & candidates);
-
-  /**********************************************************************
-   * Select the best match candidate out of multiple ones by a
-   * weighted score of geo-similarity measures
-   ***********************************************************************/
-  lanelet::LineStrings3d select_candidate(
-    rclcpp::Node & node, const lanelet::LineStrings3d & ref,
-    const std::vector<lanelet::LineStrings3d> & candidates);
+  /******************************************************************************************
+   * Get segments of the heading-binned index inside the cells of the buffers
+   * => lossless: superset of the segments inside the buffers (same candidates as testing all
+   *    segments), ordered as the scan of all segments
+   * => heading filter: only segments with a direction compatible with the corresponding
+   *    reference segment (either orientation)
+   *******************************************************************************************/
+  void heading_segments(
+    const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers,
+    const s_seg_table & seg, std::pmr::vector<uint32_t> & sel);
+
+  /******************************************************************************************
+   * Select the best match candidate by a weighted score of geo-similarity measures with a
+   * bounded search (returns false if all candidates exceed a limit)
+   * => measures are calculated from cheap to expensive, a candidate is rejected as soon as a
+   *    measure exceeds its limit and pruned as soon as the upper bound of its score can't
+   *    beat the best candidate so far (same selection as scoring all candidates)
+   *******************************************************************************************/
+  template <typename ScoringT>
+  bool select_candidate(
+    const lanelet::LineStrings3d & ref, const scratch_plines & candidates, size_t & ind,
+    s_measures & measures, const ScoringT & scoring);
 
   /*****************************************************************************
-   * Set geosimilarity measures for later evaluation of matching result
+   * Weighted score of the enabled geometric similarity measures
    ******************************************************************************/
-  void calc_geo_measures(rclcpp::Node & node, s_match & match);
+  template <typename ScoringT>
+  double geo_score(const s_measures & m, const ScoringT & scoring);
 
   /*****************************************************************************
-   * Calculate matching rate
-   * => all reference lines for which a match was returned after the algorithm
+   * Set geosimilarity measures for later evaluation of matching result
+   * => measures of the matched candidate (all 0 if unmatched)
    ******************************************************************************/
-  std::vector<double> matching_stats(rclcpp::Node & node, const std::vector<s_match> & matches);
+  template <typename ScoringT>
+  void calc_geo_measures(s_match & match, const s_measures & m, const ScoringT & scoring);
 
   /******************************************************************************************
    * Connect centerlines of adjacent lanelets based on the following/previous lanelets in
@@ -136,7 +443,7 @@ private:
    * segment is below the given limit
    *******************************************************************************************/
   void extend_ref_pline(
-    lanelet::LineStrings3d & pline, lanelet::LineStrings3d & lss, const double angle_lim,
+    lanelet::LineStrings3d & pline, s_seg_view & lss, const double angle_lim,
     lanelet::Ids & ids, const std::string & direction);
 
   /******************************************************************************
@@ -144,15 +451,18 @@ private:
    * as long as they are inside the buffers and add them as match candidates
    *******************************************************************************/
   void extend_candidates(
-    std::vector<lanelet::LineStrings3d> & candidates, lanelet::LineStrings3d & pline,
-    lanelet::LineStrings3d & lss, const lanelet::LineStrings3d & ref_pline,
-    const lanelet::Areas & buffers, lanelet::Ids & ids, const std::string & direction);
+    scratch_plines & candidates, scratch_pline & pline, s_seg_view & lss,
+    const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers, scratch_ids & ids,
+    const std::string & direction);
 
   /******************************************************
    * Check if a lanelet or linestring was already used
    *******************************************************/
   bool used_Id(const lanelet::Ids & ids, const lanelet::ConstLanelet & ll);
-  bool used_Id(const lanelet::Ids & ids, const lanelet::ConstLineString3d & ls);
+  template <typename IdsT>
+  bool used_Id(const IdsT & ids, const lanelet::ConstLineString3d & ls);
+  template <typename IdsT>
+  bool used_Id(const IdsT & ids, const lanelet::Id id);
 
   /*********************************************
    * Get lanelets of a given map
@@ -179,10 +489,11 @@ private:
   /***************************************************************************
    * Find all linestrings that are connected to either the first or second
    * point of another linestring
+   * => segments at the point from the point -> segment adjacency of the table
    ****************************************************************************/
+  template <typename LineStringsT>
   void find_ls_from_point(
-    lanelet::LineStrings3d & ls_pt, lanelet::LineStrings3d & lss, const lanelet::LineString3d & src,
-    const int pos);
+    LineStringsT & ls_pt, s_seg_view & lss, const lanelet::LineString3d & src, const int pos);
 
   /**************************************************************
    * Connect two linestrings based on their orientation
@@ -202,28 +513,39 @@ private:
    * Check if a linestring segment is inside the buffers
    * => check if first && second point is inside buffers
    ***********************************************************/
-  bool ls_inside_buffer(const lanelet::Areas & buf, const lanelet::LineString3d & ls);
+  bool ls_inside_buffer(const scratch_points & buf, const lanelet::LineString3d & ls);
+  template <typename PointsT, typename PointT>
+  bool ls_inside_buffer(const PointsT & buf, const PointT & first, const PointT & second);
 
   /**************************************************************
    * Calculate angle between first and last point of a polyline
    ***************************************************************/
-  double angle_diff_pline(const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2);
+  template <typename PlineT1, typename PlineT2>
+  double angle_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2);
 
   /**************************************************************
    * Calculate length difference between two polylines
    ***************************************************************/
-  double len_diff_pline(const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2);
+  template <typename PlineT1, typename PlineT2>
+  double len_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2);
 
   /**************************************************************
    * Calculate chord difference between two polylines
    ***************************************************************/
-  double chord_diff_pline(const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2);
+  template <typename PlineT1, typename PlineT2>
+  double chord_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2);
 
   /************************************************************************************
    * Calculate quotient of area enclosed by two polylines and the sum of their lengths
    *************************************************************************************/
-  double poly_area_diff_pline(
-    const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2);
+  template <typename PlineT1, typename PlineT2>
+  double poly_area_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2);
+
+  /***********************************************************************
+   * Calculate length of a polyline (consisting of linestring segments)
+   ************************************************************************/
+  template <typename PlineT>
+  double pline_length(const PlineT & pline);
 
   /******************************************************
    * Calculate angle between two linestring segments
@@ -236,10 +558,23 @@ private:
    ********************************************************************/
   double chamfer_distance(const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2);
 
-  /*****************************************
-   * Create rotation matrix from angle
-   ******************************************/
-  Eigen::Matrix2d rot(double angle);
+  /*******************************************************************************
+   * Get points of the connected linestring from segments (see ls_seg2string)
+   * relative to the local origin
+   ********************************************************************************/
+  template <typename PointT, typename PlineT>
+  std::pmr::vector<PointT> pline_points(const PlineT & pline);
+
+  /******************************************************************************************
+   * Calculate discrete Frechet distance between two polylines
+   * => second polyline oriented like the first one (openstreetmap-ways are undirected)
+   * => couplings restricted to a band of frechet_band points around the diagonal (0: none)
+   * => abandoned as soon as all couplings of a point exceed thr (returns this lower bound)
+   *******************************************************************************************/
+  template <typename PlineT1, typename PlineT2>
+  double frechet_distance(const PlineT1 & ls1, const PlineT2 & ls2, const double thr);
+  template <typename PointsT>
+  double frechet_rows(const PointsT & pts1, const PointsT & pts2, const double thr);
 
   /**********************************************
    * Set the z-coordinate of a linestring to 0
@@ -249,10 +584,37 @@ private:
   /*******************************************************************
    * Convert vector of linestring segments to a single linestring
    ********************************************************************/
-  lanelet::LineString3d ls_seg2string(const lanelet::LineStrings3d & ls);
+  template <typename PlineT>
+  lanelet::LineString3d ls_seg2string(const PlineT & ls);
 
   /**********************************************************
    * Swap forward/backward in attributes of a linestring
    ***********************************************************/
   void swap_tags(lanelet::LineString3d & ls);
+
+  // Evaluations of candidate measures (reset by buffer_growing)
+  s_eval_stats eval_stats;
+
+  // Scratch memory of the matching (released for every reference polyline)
+  s_arena arena;
+
+  // Float32 geometry relative to a local origin (buffer tests, chamfer distance)
+  bool float_geometry = false;
+  Eigen::Vector2d origin = Eigen::Vector2d::Zero();
+
+  // Band of the discrete Frechet distance around the diagonal (0: no band)
+  size_t frechet_band = 0;
+
+  // Only target segments with a compatible direction seed candidates (heading-binned index)
+  bool heading_filter = false;
+  // [rad] Tolerance of the direction of target segments in the heading filter
+  double heading_tol = 0.0;
+
+  // Corridors of the coarse matches during the fine level of coarse_to_fine (else nullptr)
+  // => coarse matches of the current reference polyline (sorted)
+  const s_corridors * corridors = nullptr;
+  std::vector<uint32_t> pline_corridors;
+
+  // Split and indexed target dataset shared between matchings (see set_target_cache)
+  std::shared_ptr<s_seg_table> target_cache;
 };
@@ -0,0 +1,82 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ==========================================
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ==========================================
+//
+//
+#pragma once
+//
+#include "matching.hpp"
+#include "utility.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/LineString.h>
+
+#include <string>
+#include <vector>
+
+/*****************************************************************
+ * Struct to represent a road class of the openstreetmap-network
+ ******************************************************************/
+struct s_road_class
+{
+  std::string name;              // Name of the class (motorway, highway, road)
+  lanelet::LineStrings3d osm;    // OSM-linestrings of the class
+  s_buffer_params buffer;        // Initial buffer parameters of the class
+  std::string profile;           // Scoring profile of the class (see match_profile)
+  std::vector<s_match> matches;  // Matches of all reference polylines against the class
+  bool valid = false;            // Matching of the class finished
+};
+
+class cpartition : public cprogress_reporter
+{
+  // Unit tests of private steps of the partitioned matching (see test/test_partition.cpp)
+  friend struct s_partition_test;
+
+public:
+  cpartition();
+
+  /*****************************************************************************************
+   * Match the reference linestrings against every road class of the openstreetmap-network
+   * in parallel with class-specific buffer parameters and scoring profiles
+   * => reference polylines claimed by multiple classes are assigned to the match with the
+   *    smallest discrete Frechet distance (comparable across the class-specific profiles)
+   ******************************************************************************************/
+  bool partitioned_matching(
+    rclcpp::Node & node, lanelet::LineStrings3d & src, const lanelet::LineStrings3d & osm,
+    const lanelet::ConstLineStrings3d & motorways, const lanelet::ConstLineStrings3d & highways,
+    const lanelet::ConstLineStrings3d & roads, std::vector<s_match> & matches);
+
+private:
+  /************************************************************************
+   * Create road class with the openstreetmap-linestrings contained in
+   * its (const) linestrings and its parameters from the parameter file
+   *************************************************************************/
+  s_road_class create_class(
+    rclcpp::Node & node, const std::string & name, const lanelet::LineStrings3d & osm,
+    const lanelet::ConstLineStrings3d & class_lss);
+
+  /**************************************************************************
+   * Merge matches of the road classes
+   * => reference polylines are the same for all classes (same segments)
+   * => polylines matched in multiple classes keep the match with the smallest
+   *    discrete Frechet distance (first class on a tie: motorway, highway, road)
+   ***************************************************************************/
+  bool merge_classes(const std::vector<s_road_class> & classes, std::vector<s_match> & matches);
+};
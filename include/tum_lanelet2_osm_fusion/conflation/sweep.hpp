@@ -0,0 +1,80 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ==========================================
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ==========================================
+//
+//
+#pragma once
+//
+#include "matching.hpp"
+#include "utility.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/LineString.h>
+
+#include <string>
+#include <vector>
+
+/****************************************************
+ * Struct to represent a parameter set of a sweep
+ *****************************************************/
+struct s_sweep_set
+{
+  s_buffer_params buffer;   // Initial buffer parameters
+  s_score_profile profile;  // Limits and weights of the scoring (all measures)
+};
+
+class csweep : public cprogress_reporter
+{
+public:
+  csweep();
+
+  /*****************************************************************************************
+   * Read parameter sets from a sweep file with lines "param value_1 value_2 ..."
+   * => grid: all combinations of the values, list: i-th values of all lines form set i
+   * => parameters not contained in the file keep the values of the parameter file
+   ******************************************************************************************/
+  bool read_sets(
+    rclcpp::Node & node, const std::string & sweep_path, std::vector<s_sweep_set> & sets);
+
+  /*****************************************************************************************
+   * Collapse the lanelet map and split both networks once and match all parameter sets in
+   * parallel against the shared segment tables
+   * => matching statistics (see cmatching::matching_stats) per set in the order of sets
+   ******************************************************************************************/
+  bool sweep(
+    rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr, const lanelet::LineStrings3d & osm,
+    const std::vector<s_sweep_set> & sets, std::vector<std::vector<double>> & stats);
+
+  /************************************************************************
+   * Write parameter sets and their matching statistics as table in the
+   * format (header line with the column names):
+   * "set buffer_V ... w_frechet n_plines mean_len ... d_frechet\n"
+   *************************************************************************/
+  bool write_table(
+    rclcpp::Node & node, const std::string & table_path, const std::vector<s_sweep_set> & sets,
+    const std::vector<std::vector<double>> & stats);
+
+private:
+  /**************************************************************
+   * Get value of a parameter set by the name of the parameter
+   * => nullptr if the parameter can't be swept
+   ***************************************************************/
+  double * set_value(s_sweep_set & set, const std::string & name);
+};
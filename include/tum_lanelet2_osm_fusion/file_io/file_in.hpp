@@ -19,6 +19,8 @@
 //
 //
 #pragma once
+//
+#include "utility.hpp"
 
 #include <lanelet2_extension/projection/mgrs_projector.hpp>
 #include <rclcpp/rclcpp.hpp>
@@ -65,5 +67,21 @@ public:
    **************************************************************************************/
   bool download_osm_file(rclcpp::Node & node, const std::string & file_path);
 
+  /************************************************************************
+   * Read match table of a previous run in the format:
+   * "ll_id_1 ll_id_2 ... ; osm_id_1 osm_id_2 ...\n"
+   *************************************************************************/
+  bool read_match_table(
+    rclcpp::Node & node, const std::string & table_path, std::vector<s_match_record> & table);
+
+  /***************************************************************************************
+   * Apply an OsmChange-diff (.osc) to an openstreetmap-excerpt (.osm) and write the
+   * updated excerpt to out_path (input excerpt is kept)
+   * => return ids of all created/modified/deleted ways and of ways with modified nodes
+   ****************************************************************************************/
+  bool apply_osm_change(
+    rclcpp::Node & node, const std::string & osm_path, const std::string & osc_path,
+    const std::string & out_path, lanelet::Ids & ways);
+
 private:
 };
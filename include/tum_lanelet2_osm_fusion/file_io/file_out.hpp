@@ -19,6 +19,8 @@
 //
 //
 #pragma once
+//
+#include "utility.hpp"
 
 #include <lanelet2_extension/projection/mgrs_projector.hpp>
 #include <rclcpp/rclcpp.hpp>
@@ -42,5 +44,13 @@ public:
     rclcpp::Node & node, const std::string & out_path, const std::string & proj_type,
     const lanelet::LaneletMapPtr & map_ptr);
 
+  /************************************************************************
+   * Write match table for incremental updates in the format:
+   * "ll_id_1 ll_id_2 ... ; osm_id_1 osm_id_2 ...\n"
+   *************************************************************************/
+  bool write_match_table(
+    rclcpp::Node & node, const std::string & table_path,
+    const std::vector<s_match_record> & table);
+
 private:
 };
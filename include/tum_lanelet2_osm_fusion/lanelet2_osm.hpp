@@ -26,28 +26,139 @@
 #include "extract_network.hpp"
 #include "file_in.hpp"
 #include "file_out.hpp"
+#include "incremental.hpp"
 #include "matching.hpp"
 #include "messages.hpp"
 #include "param.hpp"
+#include "partition.hpp"
 #include "rubber_sheeting.hpp"
+#include "sweep.hpp"
+#include "tiling.hpp"
 
+#include <lanelet2_extension/utility/message_conversion.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <tum_lanelet2_osm_fusion/msg/compressed_map_bin.hpp>
+#include <tum_lanelet2_osm_fusion/msg/progress.hpp>
+#include <tum_lanelet2_osm_fusion/srv/fuse_trajectory.hpp>
 
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+#include <std_srvs/srv/trigger.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+/***************************************************************************
+ * Struct to represent a marker topic whose markerarray is generated on
+ * demand (subscribers or explicit request) and cached until data changes
+ ****************************************************************************/
+struct s_marker_topic
+{
+  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pub;
+  visualization_msgs::msg::MarkerArray * msg;  // Message member to be filled by build
+  std::function<void()> build;                 // Generation of the markerarray
+  bool dirty = false;                          // Data changed since last generation
+  size_t subs = 0;                             // Subscribers at last check
+};
+
+/****************************************************************************
+ * Struct to represent an openstreetmap-excerpt kept in memory (service mode)
+ * => split and indexed target segments are reused by the matching if the
+ *    excerpt is not transformed (see cmatching::set_target_cache)
+ *****************************************************************************/
+struct s_osm_excerpt
+{
+  autoware_auto_mapping_msgs::msg::HADMapBin map;  // Excerpt as binary map
+  std::shared_ptr<s_seg_table> seg = std::make_shared<s_seg_table>();  // Target segments
+};
+
+/**************************************************************************
+ * Struct to represent a trajectory submitted to the fusion service that
+ * is queued for the pipeline thread
+ ***************************************************************************/
+struct s_fuse_request
+{
+  std::shared_ptr<rmw_request_id_t> header;
+  std::shared_ptr<tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request> request;
+};
+
 class clanelet2_osm : public rclcpp::Node
 {
 public:
   /***************************************************************
    * Main constructor to be called after the node was triggered
-   * => calls all member functions
+   * => starts the pipeline on a background thread once the
+   *    executor is spinning
+   * => composable node (rclcpp_components)
    ****************************************************************/
-  explicit clanelet2_osm(const std::string & name);
+  explicit clanelet2_osm(const rclcpp::NodeOptions & options);
   ~clanelet2_osm();
 
+  /*****************************************************************
+   * Execute the pipeline of the selected mode stage by stage
+   * => runs on the background thread started by the constructor
+   ******************************************************************/
+  void run_pipeline();
+
+  /**************************************************************************
+   * Execute stages in order, publish progress and check for cancellation
+   * between stages
+   * => stages return false on failure => remaining stages are skipped
+   * => returns false if the pipeline was cancelled or a stage failed
+   ***************************************************************************/
+  bool run_stages(const std::vector<std::pair<std::string, std::function<bool()>>> & stages);
+
+  /***************************************************************************
+   * Publish marker array as unique pointer and leave message member empty
+   * => no copy of the (multi-MB) marker arrays with intra-process
+   *    communication in a component container
+   ****************************************************************************/
+  void publish_markers(
+    const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr & pub,
+    visualization_msgs::msg::MarkerArray & msg);
+
+  /*****************************************************************************
+   * Mark markerarrays of topics as outdated after their data changed and
+   * generate them if requested
+   ******************************************************************************/
+  void invalidate_markers(const std::vector<std::string> & topics);
+
+  /********************************************************************************
+   * Generate and publish outdated markerarrays of topics with subscribers
+   * => force: generate all outdated markerarrays (explicit request)
+   * => volatile topics (intra-process) are regenerated for new subscribers
+   *********************************************************************************/
+  void update_markers(const bool force);
+
+  /*****************************************************************
+   * Generate all outdated markerarrays on request
+   ******************************************************************/
+  void markers_callback(
+    const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+    std::shared_ptr<std_srvs::srv::Trigger::Response> response);
+
+  /*****************************************************************
+   * Publish progress event of the pipeline on lof/progress
+   ******************************************************************/
+  void publish_progress(
+    const std::string & stage, const std::string & step, const size_t stage_index,
+    const size_t num_stages, const double fraction, const uint8_t state);
+
+  /********************************************************************
+   * Request cooperative cancellation of the running pipeline
+   *********************************************************************/
+  void cancel_callback(
+    const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+    std::shared_ptr<std_srvs::srv::Trigger::Response> response);
+
   /**************************************************************
    * initialize publishers for visualization in RVIZ
    ***************************************************************/
@@ -61,57 +172,143 @@ public:
    * Set reference and target map (defined by user as parameter)
    * => paths to files specified in command-line or launch-file
    *********************************************************************/
-  void load_data();
+  bool load_data();
+
+  /***********************************************************************
+   * Set master and target trajectory/map depending on master parameter
+   ************************************************************************/
+  bool set_master(
+    const lanelet::ConstLineString3d & traj_GPS_proj, const lanelet::ConstLineString3d & traj_SLAM);
 
   /**********************************************************************
    * Extract road networks from openstreetmap-data
    ***********************************************************************/
-  void get_network();
+  bool get_network();
 
   /***********************************************************
    * Align GPS and SLAM trajectory (target to reference)
    * => use Umeyama-algorithm or ICP
    ************************************************************/
-  void align_traj();
+  bool align_traj();
 
   /*****************************************************************************
    * Publish reference and aligned target trajectory to select
    * control Points for Rubber-Sheeting
    ******************************************************************************/
-  void publish_traj();
+  bool publish_traj();
 
   /*************************************************************************
    * Perform Rubber-sheeting to further transform target-trajectory
    * to reference
    * => also transform corresponding map and (point cloud if desired)
    **************************************************************************/
-  void rubber_sheeting();
+  bool rubber_sheeting();
 
   /***********************************************
    * Publish Rubber-sheeting results
    ************************************************/
-  void publish_rs();
+  bool publish_rs();
 
   /*********************************************************************
    * Perform conflation from openstreetmap to lanelet-map
    **********************************************************************/
-  void conflation();
+  bool conflation();
+
+  /*************************************************************************************
+   * Match all parameter sets of the sweep file against the once preprocessed networks
+   * and write their matching statistics as table (sweep mode)
+   **************************************************************************************/
+  bool sweep();
+
+  /*************************************************************************************
+   * Re-conflate regions of a previously fused lanelet-map that are affected by an
+   * OsmChange-diff
+   * => match table of the previous run identifies the impacted reference polylines
+   **************************************************************************************/
+  bool osm_update();
+
+  /*************************************************************************************
+   * Update a previously fused lanelet-map with a new drive
+   * => check alignment residuals of the new drive, re-match and re-conflate only the
+   *    lanelets inside the corridor of the new trajectory
+   **************************************************************************************/
+  bool drive_update();
+
+  /*********************************************************************
+   * Load previously fused lanelet-map and match table of previous run
+   **********************************************************************/
+  bool load_fused_map();
 
   /************************************************************************************
    * Publish conflation geometry, lanelet-map and openstreetmap-road network
    *************************************************************************************/
-  void publish_map();
+  bool publish_map();
+
+  /*****************************************************************************
+   * Publish updated lanelet-map as binary map message (optionally compressed)
+   ******************************************************************************/
+  void publish_map_bin();
 
   /***********************************************************
    * Write conflated lanelet-map to file
    ************************************************************/
-  void write_map();
+  bool write_map();
 
   /******************************************************************************************
-   * Perform analysis calculations and save all desired data to txt-files for later
-   * visualization with python
+   * Stage remaining analysis data (lanelets of the conflated map) to be saved in txt-files
+   * for later visualization with python
+   * => trajectories and matches are staged by the stages producing them
    *******************************************************************************************/
-  void analysis();
+  bool analysis();
+
+  /*********************************************************************
+   * Check if analysis data of a pipeline stage is to be staged
+   * => not available in service mode
+   **********************************************************************/
+  bool stage_analysis(const std::string & param);
+
+  /**************************************************************************
+   * Initialize fusion service (service mode)
+   * => maps, projection origin, openstreetmap-excerpts and the collapsed
+   *    lanelet map are kept in memory between requests
+   * => requests are executed on the pipeline thread
+   ***************************************************************************/
+  void initialize_service();
+
+  /**************************************************************************
+   * Queue a trajectory submitted to the service for the pipeline thread
+   * => response is sent after the pipeline (progress on lof/progress), the
+   *    executor is not blocked by the request
+   ***************************************************************************/
+  void fuse_callback(
+    const std::shared_ptr<rmw_request_id_t> header,
+    const std::shared_ptr<tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request> request);
+
+  /*******************************************************************
+   * Execute queued service requests one after another
+   * => runs on the pipeline thread started by initialize_service
+   ********************************************************************/
+  void serve_requests();
+
+  /*********************************************************************
+   * Execute fusion pipeline for a trajectory submitted to the service
+   **********************************************************************/
+  void fuse_request(
+    const tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request & request,
+    tum_lanelet2_osm_fusion::srv::FuseTrajectory::Response & response);
+
+  /******************************************************************************
+   * Load data of a service request
+   * => reference map is only loaded from file for the first request and copied
+   *    from an in-memory snapshot afterwards
+   * => openstreetmap-excerpts are cached per bounding box (snapped to a grid)
+   *******************************************************************************/
+  bool load_request_data(const tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request & request);
+
+  /**********************************************************************
+   * Reset results of a previous request (service mode)
+   ***********************************************************************/
+  void reset_state();
 
 private:
   std::string node_name;
@@ -123,6 +320,15 @@ private:
   std::string proj_type;
   std::string align_type;
   std::string out_path;
+  std::string pipeline_mode;
+
+  // Pipeline execution
+  s_progress progress;
+  std::thread pipeline_thread;
+  std::mutex state_mutex;                   // Pipeline state (stages and marker generation)
+  std::unique_lock<std::mutex> state_lock;  // Lock of the running stage
+  rclcpp::TimerBase::SharedPtr start_timer;
+  rclcpp::CallbackGroup::SharedPtr cb_group_cancel;
 
   // Module classes
   cfile_in m_file_loader;
@@ -132,6 +338,10 @@ private:
   crubber_sheeting m_rubber_sheeting;
   cmatching m_matching;
   cconflation m_conflation;
+  ctiling m_tiling;
+  cincremental m_incremental;
+  cpartition m_partition;
+  csweep m_sweep;
   cmessages m_msgs;
   canalysis m_analysis;
 
@@ -151,6 +361,7 @@ private:
 
   // Conflation
   std::vector<s_match> matches;
+  std::vector<s_match_record> match_table;
 
   // Master and target map
   lanelet::LaneletMapPtr master_map_lanelet_ptr;
@@ -160,7 +371,7 @@ private:
   lanelet::LaneletMapPtr ll_map_lanelet_ptr;
   lanelet::ConstLanelets ll_lanelets;
   lanelet::ConstLanelets ll_regular_lanelets;
-  std::vector<std::pair<lanelet::Id, std::string>> ll_regular_cols;
+  s_color_table ll_regular_cols;
   lanelet::ConstLanelets ll_shoulder_lanelets;
   std::vector<lanelet::ConstLineString3d> ll_stop_lines;
   lanelet::ConstLanelets to_be_deleted;
@@ -180,7 +391,21 @@ private:
   lanelet::ConstLineStrings3d osm_highway_linestrings;
   lanelet::ConstLineStrings3d osm_road_linestrings;
 
-  // Messages
+  // Service mode (kept in memory between requests)
+  autoware_auto_mapping_msgs::msg::HADMapBin ll_map_snapshot;
+  std::map<std::string, s_osm_excerpt> osm_cache;
+  std::list<std::string> osm_cache_lru;  // Keys of osm_cache (most recently used first)
+  lanelet::LineStrings3d ll_coll_cache;
+  std::shared_ptr<s_seg_table> osm_seg_cache;  // Segments of the current excerpt (or nullptr)
+  std::deque<s_fuse_request> requests;  // Requests queued for the pipeline thread
+  std::mutex requests_mutex;
+  std::condition_variable requests_cv;
+  bool requests_stop = false;  // Pipeline thread stops serving requests
+
+  // Messages (generated on demand)
+  std::map<std::string, s_marker_topic> marker_topics;
+  std::mutex markers_mutex;
+  rclcpp::TimerBase::SharedPtr markers_timer;
   visualization_msgs::msg::MarkerArray msg_traj_master_markers;
   visualization_msgs::msg::MarkerArray msg_traj_target_markers;
   visualization_msgs::msg::MarkerArray msg_traj_align_markers;
@@ -201,4 +426,13 @@ private:
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pub_ll_map_markers;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pub_ll_map_new_markers;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pub_osm_map_markers;
+  rclcpp::Publisher<autoware_auto_mapping_msgs::msg::HADMapBin>::SharedPtr pub_ll_map_new_bin;
+  rclcpp::Publisher<tum_lanelet2_osm_fusion::msg::CompressedMapBin>::SharedPtr
+    pub_ll_map_new_bin_comp;
+  rclcpp::Publisher<tum_lanelet2_osm_fusion::msg::Progress>::SharedPtr pub_progress;
+
+  // Service
+  rclcpp::Service<tum_lanelet2_osm_fusion::srv::FuseTrajectory>::SharedPtr srv_fuse;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr srv_cancel;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr srv_markers;
 };
@@ -20,6 +20,8 @@
 //
 #pragma once
 //
+#include "utility.hpp"
+
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <rclcpp/rclcpp.hpp>
@@ -62,6 +64,14 @@ public:
     lanelet::ConstLineString3d & ls, lanelet::ConstLineString3d & ls_trans,
     const Eigen::Matrix3d & trans);
 
+  /****************************************************************************
+   * Calculate residuals between reference and aligned linestring
+   * => 2D distance of every point of the aligned linestring to the reference
+   *****************************************************************************/
+  bool residuals(
+    const lanelet::ConstLineString3d & ref, const lanelet::ConstLineString3d & ls,
+    std::vector<double> & res);
+
 private:
   /*************************************************************************
    * Calculate transformation matrix according to Umeyama algorithm
@@ -40,7 +40,7 @@
 #include <string>
 #include <vector>
 
-class crubber_sheeting
+class crubber_sheeting : public cprogress_reporter
 {
 public:
   crubber_sheeting();
@@ -83,6 +83,15 @@ public:
     const Eigen::Matrix3d & trans_al);
 
 private:
+  /*******************************************************************************
+   * Transform point cloud in float32 relative to a local origin (center of the
+   * triangles) => accurate to millimetres, half the memory of double geometry
+   ********************************************************************************/
+  void transform_pcd_local(
+    const pcl::PointCloud<pcl::PointXYZ> & cloud, pcl::PointCloud<pcl::PointXYZ> & cloud_out,
+    const lanelet::Areas & tri, const std::vector<Eigen::Matrix3d> & trans,
+    const Eigen::Matrix3d & trans_al_inv);
+
   /**************************************************************
    * Find closest point on given linestring for given point
    ***************************************************************/
@@ -27,7 +27,9 @@
 #include <lanelet2_extension/utility/query.hpp>
 #include <lanelet2_extension/visualization/visualization.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <tum_lanelet2_osm_fusion/msg/compressed_map_bin.hpp>
 
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
@@ -35,6 +37,7 @@
 #include <lanelet2_core/geometry/Point.h>
 #include <lanelet2_io/Io.h>
 
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -69,8 +72,7 @@ public:
   void col_map_net2marker_msg(
     rclcpp::Node & node, lanelet::ConstLanelets & all, lanelet::ConstLanelets & regular,
     lanelet::ConstLanelets & shoulder, std::vector<lanelet::ConstLineString3d> & stop_lines,
-    const std::vector<std::pair<lanelet::Id, std::string>> & cols,
-    visualization_msgs::msg::MarkerArray & map_marker_msg);
+    const s_color_table & cols, visualization_msgs::msg::MarkerArray & map_marker_msg);
 
   /*****************************************************************************************
    * Insert linestrings of an openstreetmap-file that represent streets into a markerarray
@@ -97,6 +99,47 @@ public:
     const lanelet::ConstLineStrings3d & ll_coll, const std::vector<s_match> & matches,
     visualization_msgs::msg::MarkerArray & msg);
 
+  /**************************************************************************
+   * Serialize lanelet map into binary map message (lanelet2 boost
+   * serialization) => no xml-parsing and projection for consumers
+   ***************************************************************************/
+  void map2bin_msg(
+    rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr,
+    autoware_auto_mapping_msgs::msg::HADMapBin & msg);
+
+  /****************************************************************************
+   * Compress data of a binary map message with zlib (level 1 - 9)
+   *****************************************************************************/
+  bool compress_bin_msg(
+    const autoware_auto_mapping_msgs::msg::HADMapBin & msg, const int level,
+    tum_lanelet2_osm_fusion::msg::CompressedMapBin & msg_comp);
+
+  /****************************************************************************
+   * Decompress a compressed binary map message (for consumers)
+   *****************************************************************************/
+  bool decompress_bin_msg(
+    const tum_lanelet2_osm_fusion::msg::CompressedMapBin & msg_comp,
+    autoware_auto_mapping_msgs::msg::HADMapBin & msg);
+
+  /***************************************************************************************
+   * Insert lanelets into marker array with level of detail (visualization of large maps)
+   * => markers split into namespaces of spatial tiles that are built in parallel
+   * => one level per tile: finest Douglas-Peucker tolerance whose markers fit into the
+   *    point budget (markers of the coarsest level are split if they still exceed it)
+   * => lanelets colored based on color code from conflation if given
+   ****************************************************************************************/
+  void lod_map_net2marker_msg(
+    rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & cols,
+    const std::string & ns, visualization_msgs::msg::MarkerArray & map_marker_msg);
+
+  /*****************************************************************************************
+   * Insert linestrings of an openstreetmap-file with level of detail into a markerarray
+   * => same tiling and choice of the level per tile as for lanelets
+   ******************************************************************************************/
+  void lod_osm_net2marker_msg(
+    rclcpp::Node & node, const lanelet::ConstLineStrings3d & lss, const std::string & ns,
+    visualization_msgs::msg::MarkerArray & map_marker_msg);
+
 private:
   /*****************************************************************************
    * Convert areas (rubber-sheet triangles) to markerarray (new namespace for
@@ -115,10 +158,11 @@ private:
 
   /*********************************************************************************
    * Convert lanelets into colored triangle based on color code from conflation
+   * => lanelets triangulated in parallel
    **********************************************************************************/
   visualization_msgs::msg::MarkerArray colored_lanelets2marker_msg(
-    const std::string & ns_base, const lanelet::ConstLanelets & lls,
-    const std::vector<std::pair<lanelet::Id, std::string>> & cols);
+    const std::string & ns_base, const lanelet::ConstLanelets & lls, const s_color_table & cols,
+    const int threads);
 
   /*************************************************************************************
    * Convert areas to markerarray (visualization of the surface but with transparency)
@@ -218,9 +262,37 @@ private:
    *********************************************************************/
   lanelet::ConstLineStrings3d to_const(const lanelet::LineStrings3d & lss);
 
-  /**********************************************************************
-   * Get color code of a lanelet from conflation based on its id
-   ***********************************************************************/
-  std::string id2col(
-    const std::vector<std::pair<lanelet::Id, std::string>> & cols, const lanelet::Id & id);
+  /***************************************************************************
+   * Get precomputed colors of the color codes of a color table
+   ****************************************************************************/
+  std::vector<std_msgs::msg::ColorRGBA> palette(const s_color_table & cols, const double a);
+
+  /*****************************************************************************
+   * Simplify linestring with Douglas-Peucker (2D)
+   * => all points are kept for a tolerance <= 0
+   ******************************************************************************/
+  std::vector<lanelet::BasicPoint3d> simplify(
+    const lanelet::ConstLineString3d & ls, const double tol);
+
+  /*****************************************************************************
+   * Get index of the visualization tile of a point
+   ******************************************************************************/
+  std::pair<int, int> viz_tile(const lanelet::ConstPoint3d & pt, const double tile_size);
+
+  /*******************************************************************************
+   * Build markerarrays of tiles in parallel
+   * => build(i) fills the markerarray of tile i, results inserted in tile order
+   ********************************************************************************/
+  void build_tiles(
+    const size_t num_tiles, const int threads,
+    const std::function<void(const size_t, visualization_msgs::msg::MarkerArray &)> & build,
+    visualization_msgs::msg::MarkerArray & msg);
+
+  /******************************************************************************
+   * Insert marker into markerarray, split into several markers (consecutive
+   * ids) if the number of points exceeds the budget
+   *******************************************************************************/
+  void insert_marker_budget(
+    const visualization_msgs::msg::Marker & marker, const size_t budget,
+    visualization_msgs::msg::MarkerArray * arr_src);
 };
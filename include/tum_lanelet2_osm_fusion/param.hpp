@@ -22,7 +22,24 @@
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <vector>
+
+/******************************************************************
+ * Descriptor of an integer parameter with a lower bound
+ * => declaration throws for values out of range
+ *******************************************************************/
+inline rcl_interfaces::msg::ParameterDescriptor min_int_desc(const int64_t min)
+{
+  rcl_interfaces::msg::ParameterDescriptor desc;
+  rcl_interfaces::msg::IntegerRange range;
+  range.from_value = min;
+  range.to_value = std::numeric_limits<int64_t>::max();
+  desc.integer_range.push_back(range);
+  return desc;
+}
 
 /******************************************************************
  * Declare and load parameters from parameter file in /config
@@ -85,12 +102,27 @@ void get_params(
   node.declare_parameter<double>("lim_length");
   node.declare_parameter<double>("lim_chord");
   node.declare_parameter<double>("lim_poly");
+  node.declare_parameter<double>("lim_frechet");
   node.declare_parameter<double>("w_angle");
   node.declare_parameter<double>("w_length");
   node.declare_parameter<double>("w_chord");
   node.declare_parameter<double>("w_poly");
+  node.declare_parameter<double>("w_frechet");
+  node.declare_parameter<bool>("use_frechet");
+  node.declare_parameter<int>("frechet_band");
   node.declare_parameter<double>("lim_tp");
   node.declare_parameter<double>("lim_ref_pline");
+  node.declare_parameter<bool>("float_geometry");
+  node.declare_parameter<std::string>("match_profile");
+  node.declare_parameter<std::string>("match_hierarchy");
+  node.declare_parameter<double>("coarse_tolerance");
+  node.declare_parameter<double>("coarse_seg_len");
+  node.declare_parameter<double>("coarse_buffer_scale");
+  node.declare_parameter<double>("coarse_corridor");
+  node.declare_parameter<int>("heading_bins");
+  node.declare_parameter<double>("heading_cell");
+  node.declare_parameter<bool>("heading_filter");
+  node.declare_parameter<double>("heading_tolerance");
   node.get_parameter("seg_len");
   node.get_parameter("pline_angle");
   node.get_parameter("buffer_V");
@@ -100,22 +132,127 @@ void get_params(
   node.get_parameter("lim_length");
   node.get_parameter("lim_chord");
   node.get_parameter("lim_poly");
+  node.get_parameter("lim_frechet");
   node.get_parameter("w_angle");
   node.get_parameter("w_length");
   node.get_parameter("w_chord");
   node.get_parameter("w_poly");
+  node.get_parameter("w_frechet");
+  node.get_parameter("use_frechet");
+  node.get_parameter("frechet_band");
   node.get_parameter("lim_tp");
   node.get_parameter("lim_ref_pline");
+  node.get_parameter("float_geometry");
+  node.get_parameter("match_profile");
+  node.get_parameter("match_hierarchy");
+  node.get_parameter("coarse_tolerance");
+  node.get_parameter("coarse_seg_len");
+  node.get_parameter("coarse_buffer_scale");
+  node.get_parameter("coarse_corridor");
+  node.get_parameter("heading_bins");
+  node.get_parameter("heading_cell");
+  node.get_parameter("heading_filter");
+  node.get_parameter("heading_tolerance");
+
+  // Road-class partitioned matching
+  node.declare_parameter<bool>("partitioning");
+  node.declare_parameter<std::vector<double>>("partition_buffer_motorway");
+  node.declare_parameter<std::vector<double>>("partition_buffer_highway");
+  node.declare_parameter<std::vector<double>>("partition_buffer_road");
+  node.declare_parameter<std::string>("partition_profile_motorway");
+  node.declare_parameter<std::string>("partition_profile_highway");
+  node.declare_parameter<std::string>("partition_profile_road");
+  node.get_parameter("partitioning");
+  node.get_parameter("partition_buffer_motorway");
+  node.get_parameter("partition_buffer_highway");
+  node.get_parameter("partition_buffer_road");
+  node.get_parameter("partition_profile_motorway");
+  node.get_parameter("partition_profile_highway");
+  node.get_parameter("partition_profile_road");
+
+  // Pipeline mode
+  node.declare_parameter<std::string>("pipeline_mode");
+  node.get_parameter("pipeline_mode");
+
+  // Service mode
+  node.declare_parameter<std::string>("osm_cache_dir");
+  node.declare_parameter<double>("osm_cache_res");
+  node.declare_parameter<int>("osm_cache_size", min_int_desc(1));
+  node.get_parameter("osm_cache_dir");
+  node.get_parameter("osm_cache_res");
+  node.get_parameter("osm_cache_size");
+
+  // Incremental update
+  node.declare_parameter<std::string>("match_table_path");
+  node.declare_parameter<std::string>("osc_path");
+  node.declare_parameter<std::string>("osc_out_path");
+  node.declare_parameter<double>("update_margin");
+  node.declare_parameter<double>("corridor_width");
+  node.declare_parameter<double>("drive_max_residual");
+  node.get_parameter("match_table_path");
+  node.get_parameter("osc_path");
+  node.get_parameter("osc_out_path");
+  node.get_parameter("update_margin");
+  node.get_parameter("corridor_width");
+  node.get_parameter("drive_max_residual");
+
+  // Tiling
+  node.declare_parameter<bool>("tiling");
+  node.declare_parameter<double>("tile_size");
+  node.declare_parameter<double>("tile_overlap");
+  node.declare_parameter<int>("tile_threads");
+  node.get_parameter("tiling");
+  node.get_parameter("tile_size");
+  node.get_parameter("tile_overlap");
+  node.get_parameter("tile_threads");
+
+  // Parameter sweep
+  node.declare_parameter<std::string>("sweep_path");
+  node.declare_parameter<std::string>("sweep_combine");
+  node.declare_parameter<std::string>("sweep_table_path");
+  node.declare_parameter<int>("sweep_threads");
+  node.get_parameter("sweep_path");
+  node.get_parameter("sweep_combine");
+  node.get_parameter("sweep_table_path");
+  node.get_parameter("sweep_threads");
 
   // Visualization
   node.declare_parameter<bool>("viz_lanelet_centerline");
+  node.declare_parameter<bool>("viz_lod");
+  node.declare_parameter<std::vector<double>>("viz_lod_tolerances");
+  node.declare_parameter<double>("viz_tile_size");
+  node.declare_parameter<int>("viz_point_budget", min_int_desc(1));
+  node.declare_parameter<int>("viz_threads");
+  node.declare_parameter<bool>("viz_lazy");
+  node.declare_parameter<double>("viz_check_period");
   node.get_parameter("viz_lanelet_centerline");
+  node.get_parameter("viz_lod");
+  node.get_parameter("viz_lod_tolerances");
+  node.get_parameter("viz_tile_size");
+  node.get_parameter("viz_point_budget");
+  node.get_parameter("viz_threads");
+  node.get_parameter("viz_lazy");
+  node.get_parameter("viz_check_period");
+
+  // Binary map output
+  node.declare_parameter<bool>("map_bin");
+  node.declare_parameter<bool>("map_bin_compressed");
+  node.declare_parameter<int>("map_bin_level");
+  node.get_parameter("map_bin");
+  node.get_parameter("map_bin_compressed");
+  node.get_parameter("map_bin_level");
 
   // Analysis Output
   node.declare_parameter<std::string>("analysis_output_dir");
   node.declare_parameter<bool>("analysis_traj_matching");
   node.declare_parameter<bool>("analysis_matching");
+  node.declare_parameter<std::string>("analysis_format");
+  node.declare_parameter<bool>("analysis_async");
+  node.declare_parameter<int>("analysis_queue_size", min_int_desc(1));
   node.get_parameter("analysis_output_dir");
   node.get_parameter("analysis_traj_matching");
   node.get_parameter("analysis_matching");
+  node.get_parameter("analysis_format");
+  node.get_parameter("analysis_async");
+  node.get_parameter("analysis_queue_size");
 }
@@ -0,0 +1,125 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ==========================================
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ==========================================
+//
+//
+#pragma once
+//
+#include "matching.hpp"
+#include "utility.hpp"
+
+#include <Eigen/Geometry>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/geometry/LineString.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**************************************
+ * Struct to represent a spatial tile
+ ***************************************/
+struct s_tile
+{
+  int ix;                         // Tile index in x-direction
+  int iy;                         // Tile index in y-direction
+  Eigen::AlignedBox2d ext;        // Tile extent including overlap margin
+  std::vector<uint32_t> ll_ind;   // Indices of the lanelets intersecting the extended tile
+  std::vector<uint32_t> osm_ind;  // Indices of the OSM-linestrings intersecting the extended tile
+  lanelet::Lanelets lls;          // Lanelets of the indices (see fill_tile)
+  lanelet::LineStrings3d osm;     // OSM-linestrings of the indices
+  lanelet::LineStrings3d coll;    // Collapsed centerlines owned by the tile
+  std::vector<s_match> matches;   // Matches owned by the tile
+};
+
+class ctiling : public cprogress_reporter
+{
+public:
+  ctiling();
+
+  /*****************************************************************************************
+   * Partition lanelet map and openstreetmap-network into spatial tiles with an overlap
+   * margin, collapse and match every tile independently in parallel and stitch the results
+   ******************************************************************************************/
+  bool tiled_matching(
+    rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr, const lanelet::LineStrings3d & osm,
+    lanelet::LineStrings3d & ll_coll, std::vector<s_match> & matches);
+
+private:
+  /*****************************************************************************
+   * Create tiles covering the lanelet map with the indices of the lanelets and
+   * openstreetmap-linestrings intersecting them (see fill_tile)
+   * => bounding boxes bucketed into the tiles of their cell range in one pass
+   ******************************************************************************/
+  std::vector<s_tile> create_tiles(
+    const lanelet::Lanelets & lls, const lanelet::LineStrings3d & osm, const double tile_size,
+    const double overlap, Eigen::AlignedBox2d & extent, int & nx, int & ny);
+
+  /*************************************************************************
+   * Assign lanelets and openstreetmap-linestrings intersecting the
+   * extended tile extent to a tile (right before it is processed)
+   **************************************************************************/
+  void fill_tile(s_tile & tile, const lanelet::Lanelets & lls, const lanelet::LineStrings3d & osm);
+
+  /*****************************************************************
+   * Collapse and match a single tile and keep owned results only
+   ******************************************************************/
+  void process_tile(
+    rclcpp::Node & node, s_tile & tile, const Eigen::AlignedBox2d & extent, const double tile_size,
+    const int nx, const int ny);
+
+  /************************************************************************************
+   * Resolve lanelets that are claimed by matches of multiple tiles
+   * => lanelet assigned to the match with the highest score (tie: lower tile index)
+   *************************************************************************************/
+  void resolve_claims(std::vector<s_match> & matches);
+
+  /***************************************************************************************
+   * Check if a reference polyline is owned by the tile
+   * => segment closest to the middle that represents lanelets is owned if its lanelets
+   *    are represented by owned centerlines (owned_ids, sorted)
+   * => by the midpoint of its middle segment if no segment represents lanelets
+   ****************************************************************************************/
+  bool owned(
+    const lanelet::LineStrings3d & pline, const lanelet::Ids & owned_ids, const s_tile & tile,
+    const Eigen::AlignedBox2d & extent, const double tile_size, const int nx, const int ny);
+  bool owned(
+    const lanelet::LineString3d & ls, const s_tile & tile, const Eigen::AlignedBox2d & extent,
+    const double tile_size, const int nx, const int ny);
+
+  /********************************************************************
+   * Get tile index of a point (clamped to the tiles of the extent)
+   *********************************************************************/
+  void tile_index(
+    const double x, const double y, const Eigen::AlignedBox2d & extent, const double tile_size,
+    const int nx, const int ny, int & ix, int & iy);
+
+  /*******************************************************************
+   * Get lanelet ids a reference polyline segment is representing
+   ********************************************************************/
+  lanelet::Ids ref_ids(const lanelet::LineString3d & seg);
+
+  /***************************************************************************
+   * Remove lanelet ids from a reference polyline segment and re-index the
+   * remaining forward/backward attributes
+   ****************************************************************************/
+  void remove_ref_ids(lanelet::LineString3d & seg, const lanelet::Ids & ids);
+};
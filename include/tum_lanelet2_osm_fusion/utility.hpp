@@ -20,11 +20,26 @@
 //
 #pragma once
 //
+#include <Eigen/Dense>
+
 #include <lanelet2_core/LaneletMap.h>
 #include <lanelet2_core/geometry/Point.h>
+#include <lanelet2_core/utility/Utilities.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 /**************************************
@@ -50,17 +65,20 @@ struct s_match
 public:
   s_match(
     const lanelet::LineStrings3d & ref_pl, const lanelet::LineStrings3d & target_pl,
-    const lanelet::Areas & buf);
+    const double buf_V, const double buf_P, const double buf_rad);
   void set_geo_measures(
     const double & d_bet, const double & d_l, const double & d_cho, const double & d_pol,
-    const double & d_cham, const double & len_ref_pl, const double & s);
+    const double & d_fre, const double & d_cham, const double & len_ref_pl, const double & s);
   lanelet::LineStrings3d ref_pline() const;
   lanelet::LineStrings3d target_pline() const;
+  lanelet::Ids target_ids() const;
+  void set_target_ids(const lanelet::Ids & ids);
   lanelet::Areas buffers() const;
   double d_ang() const;
   double d_len() const;
   double d_chord() const;
   double d_poly() const;
+  double d_frechet() const;
   double d_chamfer() const;
   double len_ref_pline() const;
   double score() const;
@@ -73,16 +91,196 @@ public:
 private:
   lanelet::LineStrings3d ref_pl;
   lanelet::LineStrings3d target_pl;
-  lanelet::Areas buf;
+  lanelet::Ids target_id;  // Original linestrings (e.g. openstreetmap-ways) of target_pl
+  double buf_V;    // Buffer size vertical to segments (buffers around ref_pl created on demand)
+  double buf_P;    // Buffer size in segment direction
+  double buf_rad;  // Buffer corner radius
   double d_bet;
   double d_l;
   double d_cho;
   double d_pol;
+  double d_fre;  // Discrete Frechet distance
   double d_cham;
   double len_ref_pl;
   double s;
 
-  lanelet::Point3d closest_on_lss(lanelet::Point3d & pt, const lanelet::LineStrings3d & lss) const;
+  lanelet::BasicPoint3d closest_on_lss(
+    const lanelet::BasicPoint3d & pt, const lanelet::LineStrings3d & lss) const;
+};
+
+/**************************************************************************************
+ * Get unique id for primitives that enter a lanelet map or whose id is used to track
+ * them (e.g. segments of polylines)
+ * => ids are reserved in blocks per thread => no contention on the global id counter
+ *    of lanelet2 if modules run in parallel
+ * => only allocation of ids in this package (the reservation of a block is not atomic
+ *    against direct calls of lanelet::utils::getId)
+ * => intermediate geometry uses id-less basic types or lanelet::InvalId instead
+ ***************************************************************************************/
+lanelet::Id next_id();
+
+/**************************************************************************************
+ * Execute func(i) for i in [0, n) on a pool of worker threads
+ * => threads <= 0: number of hardware threads
+ * => done(k) is called on the calling thread after k items finished (progress report
+ *    from a single thread only)
+ ***************************************************************************************/
+void parallel_for(
+  const size_t n, const int threads, const std::function<void(const size_t)> & func,
+  const std::function<void(const size_t)> & done = nullptr);
+
+/*************************************************************************************
+ * Create buffer polygons (id-less scratch geometry) around each line segment based
+ * on the given parameters
+ * => appends buffer_points consecutive polygon points per segment to pts
+ **************************************************************************************/
+constexpr size_t buffer_points = 12;
+template <typename PointsT>
+void buffer_polygons(
+  const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
+  const double rad, PointsT & pts);
+
+/*************************************************************************
+ * Create buffers around each line segment as areas for visualization
+ * => primitives are not part of any map and have no id
+ **************************************************************************/
+lanelet::Areas create_buffer(
+  const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
+  const double rad);
+
+/***************************************************************************
+ * Check if a point is inside a (buffer) polygon
+ * => PointT: lanelet::BasicPoint2d or Eigen::Vector2f (local coordinates)
+ ****************************************************************************/
+template <typename PointT>
+bool inside_polygon(const PointT * poly, const size_t n, const PointT & pt);
+
+/*************************************************************************************
+ * Sum of the distances of all points to the closest point of another set of points
+ * => PointT: lanelet::BasicPoint2d or Eigen::Vector2f (local coordinates)
+ **************************************************************************************/
+template <typename PointsT>
+double closest_sum(const PointsT & from, const PointsT & to);
+
+/*************************************************************************************
+ * Express a 2D homogeneous transformation in coordinates relative to a local origin
+ * => T_local = S(-origin) * T * S(origin) in precision of T (e.g. float)
+ **************************************************************************************/
+template <typename T>
+Eigen::Matrix<T, 3, 3> local_transform(
+  const Eigen::Matrix3d & trans, const Eigen::Vector2d & origin);
+
+/*****************************************************************************
+ * Simplify linestring with Douglas-Peucker (2D)
+ * => returns mask of the points to keep (all points for a tolerance <= 0)
+ ******************************************************************************/
+template <typename LineStringT>
+std::vector<bool> douglas_peucker(const LineStringT & ls, const double tol);
+
+/*************************************************************************
+ * Struct to report progress of long running steps and to request their
+ * cooperative cancellation (checked inside the loops of the modules)
+ **************************************************************************/
+struct s_progress
+{
+public:
+  bool cancelled() const { return this->cancel.load(); }
+  void update(const std::string & step, const double fraction) const
+  {
+    if (this->report) {
+      this->report(step, fraction);
+    }
+  }
+
+  std::atomic<bool> cancel{false};                                // Cancellation request
+  std::function<void(const std::string &, const double)> report;  // Progress callback
+};
+
+/*************************************************************************
+ * Base class of modules with long running steps
+ * => progress report and cancellation check are no-ops without progress
+ **************************************************************************/
+class cprogress_reporter
+{
+public:
+  /*********************************************************************
+   * Set object to report progress and to check for cancellation
+   **********************************************************************/
+  void set_progress(const s_progress * progress) { this->progress = progress; }
+
+protected:
+  bool cancelled() const { return this->progress && this->progress->cancelled(); }
+  void update(const std::string & step, const double fraction) const
+  {
+    if (this->progress) {
+      this->progress->update(step, fraction);
+    }
+  }
+
+  const s_progress * progress = nullptr;  // Progress report and cancellation (optional)
+};
+
+/*****************************************************************************************
+ * Struct to represent a monotonic arena for short-lived scratch data (single thread)
+ * => all scratch data is released at once by reset()
+ * => initial buffer grows on reset() if the last round needed more memory, so that the
+ *    steady state allocates nothing from the global heap
+ ******************************************************************************************/
+struct s_arena
+{
+public:
+  explicit s_arena(const size_t size = 64 * 1024);
+  s_arena(const s_arena &) = delete;
+  s_arena & operator=(const s_arena &) = delete;
+  std::pmr::memory_resource * get();
+  void reset();
+
+private:
+  // Upstream resource of the arena => counts bytes not fitting into the buffer
+  struct s_upstream : public std::pmr::memory_resource
+  {
+    size_t bytes = 0;
+    void * do_allocate(size_t n, size_t align) override;
+    void do_deallocate(void * p, size_t n, size_t align) override;
+    bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+  };
+
+  std::unique_ptr<std::byte[]> buf;
+  size_t size;
+  s_upstream upstream;
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> mono;
+};
+
+/*****************************************************************************
+ * Struct to represent the color codes of lanelets from conflation
+ * => hashed lanelet id -> index of one of the few distinct color codes
+ ******************************************************************************/
+struct s_color_table
+{
+public:
+  bool contains(const lanelet::Id & id) const;
+  void insert(const lanelet::Id & id, const std::string & code);
+  int index(const lanelet::Id & id) const;
+  std::string code(const lanelet::Id & id) const;
+  const std::vector<std::string> & codes() const;
+  bool empty() const;
+  void erase(const lanelet::Id & id);
+  void clear();
+
+private:
+  std::unordered_map<lanelet::Id, int> ids;  // Lanelet id -> index of color code
+  std::vector<std::string> col_codes;        // Distinct color codes
+};
+
+/*******************************************************************
+ * Struct to represent an entry of the persisted match table
+ * => lanelets represented by a reference polyline and the ids of
+ *    the openstreetmap-ways it was matched to
+ ********************************************************************/
+struct s_match_record
+{
+  lanelet::Ids ll_ids;   // Lanelets represented by reference polyline
+  lanelet::Ids osm_ids;  // Matched openstreetmap-ways (empty if unmatched)
 };
 
 /********************
@@ -92,13 +290,13 @@ private:
 s_control_point::s_control_point(const double vx, const double vy, const double ux, const double uy)
 {
   // Source point
-  this->v.setId(lanelet::utils::getId());
+  this->v.setId(next_id());
   this->v.x() = vx;
   this->v.y() = vy;
   this->v.z() = 0.0;
 
   // Target point
-  this->u.setId(lanelet::utils::getId());
+  this->u.setId(next_id());
   this->u.x() = ux;
   this->u.y() = uy;
   this->u.z() = 0.0;
@@ -119,11 +317,13 @@ lanelet::Point3d s_control_point::get_target_point() const
 
 s_match::s_match(
   const lanelet::LineStrings3d & ref_pl, const lanelet::LineStrings3d & target_pl,
-  const lanelet::Areas & buf)
+  const double buf_V, const double buf_P, const double buf_rad)
 {
   this->ref_pl = ref_pl;
   this->target_pl = target_pl;
-  this->buf = buf;
+  this->buf_V = buf_V;
+  this->buf_P = buf_P;
+  this->buf_rad = buf_rad;
 }
 lanelet::LineStrings3d s_match::ref_pline() const
 {
@@ -133,9 +333,17 @@ lanelet::LineStrings3d s_match::target_pline() const
 {
   return this->target_pl;
 }
+lanelet::Ids s_match::target_ids() const
+{
+  return this->target_id;
+}
+void s_match::set_target_ids(const lanelet::Ids & ids)
+{
+  this->target_id = ids;
+}
 lanelet::Areas s_match::buffers() const
 {
-  return this->buf;
+  return create_buffer(this->ref_pl, this->buf_V, this->buf_P, this->buf_rad);
 }
 double s_match::d_ang() const
 {
@@ -153,6 +361,10 @@ double s_match::d_poly() const
 {
   return this->d_pol;
 }
+double s_match::d_frechet() const
+{
+  return this->d_fre;
+}
 double s_match::d_chamfer() const
 {
   return this->d_cham;
@@ -171,12 +383,13 @@ double s_match::score() const
  ********************************************************/
 void s_match::set_geo_measures(
   const double & d_bet, const double & d_l, const double & d_cho, const double & d_pol,
-  const double & d_cham, const double & len_ref_pl, const double & s)
+  const double & d_fre, const double & d_cham, const double & len_ref_pl, const double & s)
 {
   this->d_bet = d_bet;
   this->d_l = d_l;
   this->d_cho = d_cho;
   this->d_pol = d_pol;
+  this->d_fre = d_fre;
   this->d_cham = d_cham;
   this->len_ref_pl = len_ref_pl;
   this->s = s;
@@ -190,11 +403,12 @@ lanelet::ConstLineStrings3d s_match::match_conn() const
   lanelet::ConstLineStrings3d match_connections;
   if (!this->target_pl.empty()) {
     for (const auto & ls : this->target_pl) {
-      lanelet::Point3d pt(
-        lanelet::utils::getId(), (ls.front().x() + ls.back().x()) / 2.0,
-        (ls.front().y() + ls.back().y()) / 2.0, (ls.front().z() + ls.back().z()) / 2.0);
-      lanelet::Point3d pt_ = closest_on_lss(pt, this->ref_pl);
-      lanelet::LineString3d ls_(lanelet::utils::getId(), {pt, pt_});
+      const lanelet::BasicPoint3d pt = (ls.front().basicPoint() + ls.back().basicPoint()) / 2.0;
+      const lanelet::BasicPoint3d pt_ = closest_on_lss(pt, this->ref_pl);
+      // Connection lines are only visualized => no ids
+      lanelet::LineString3d ls_(
+        lanelet::InvalId, {lanelet::Point3d(lanelet::InvalId, pt),
+                           lanelet::Point3d(lanelet::InvalId, pt_)});
       match_connections.push_back(ls_);
     }
   }
@@ -244,22 +458,405 @@ void s_match::remove_tag_ref_pline(const lanelet::Id & id)
 /*****************************************************************************
  * Return closest point to another point on a set on linestring segments
  ******************************************************************************/
-lanelet::Point3d s_match::closest_on_lss(
-  lanelet::Point3d & pt, const lanelet::LineStrings3d & lss) const
+lanelet::BasicPoint3d s_match::closest_on_lss(
+  const lanelet::BasicPoint3d & pt, const lanelet::LineStrings3d & lss) const
 {
   std::vector<double> dist;
-  lanelet::Points3d pts;
+  std::vector<lanelet::BasicPoint3d> pts;
   if (lss.empty()) {
     std::cerr << "\033[31m" << __FUNCTION__ << ": LineStrings are empty!\033[0m" << std::endl;
   }
 
   for (const auto & ls : lss) {
-    lanelet::Point3d pt_(
-      lanelet::utils::getId(), (ls.front().x() + ls.back().x()) / 2.0,
-      (ls.front().y() + ls.back().y()) / 2.0, (ls.front().z() + ls.back().z()) / 2.0);
+    const lanelet::BasicPoint3d pt_ = (ls.front().basicPoint() + ls.back().basicPoint()) / 2.0;
     pts.push_back(pt_);
-    dist.push_back(lanelet::geometry::distance2d(pt, pt_));
+    dist.push_back((pt.head<2>() - pt_.head<2>()).norm());
   }
   const int ind = std::distance(dist.begin(), std::min_element(dist.begin(), dist.end()));
   return pts[ind];
 }
+
+/*************************************************************************************
+ * Create buffer polygons (id-less scratch geometry) around each line segment based
+ * on the given parameters
+ * => appends buffer_points consecutive polygon points per segment to pts
+ **************************************************************************************/
+template <typename PointsT>
+void buffer_polygons(
+  const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
+  const double rad, PointsT & pts)
+{
+  /*********************************************************************
+   * Buffer around linestring segment
+   * => buffer_V: size vertical to segment direction
+   * => buffer_V: size in segment direction (before and after segment)
+   * => radius: radius on corners (here illustrate with slashes)
+   *    ____________________________________
+   *   /                                    \
+   *  /                                      \
+   * |                                        |
+   * |                                        |
+   * |          *                  *          |
+   * |                                        |
+   * |                                        |
+   *  \                                      /
+   *   \____________________________________/
+   **********************************************************************/
+
+  // Rotation matrix from angle
+  auto rot = [](const double angle) {
+    const double angle_rad = angle * std::atan(1.0) * 4 / 180.0;
+    Eigen::Matrix2d mat;
+    mat << std::cos(angle_rad), -std::sin(angle_rad), std::sin(angle_rad), std::cos(angle_rad);
+    return mat;
+  };
+
+  pts.reserve(pts.size() + buffer_points * lss.size());
+  // Iterate through segments
+  for (const auto & ls : lss) {
+    // Get first and second point of segment and difference vector
+    Eigen::Vector2d pt_f(ls.front().x(), ls.front().y());
+    Eigen::Vector2d pt_s(ls.back().x(), ls.back().y());
+    Eigen::Vector2d dir = (pt_s - pt_f);
+
+    // Calculate normalized vector perpendicular to segment direction (left)
+    Eigen::Vector2d offset_l = rot(90) * dir.normalized();
+
+    // Define buffer points on front and back
+    Eigen::Vector2d pt_f_l = pt_f - dir.normalized() * buffer_P + offset_l * (buffer_V - rad);
+    Eigen::Vector2d pt_f_r = pt_f - dir.normalized() * buffer_P - offset_l * (buffer_V - rad);
+    Eigen::Vector2d pt_s_l = pt_s + dir.normalized() * buffer_P + offset_l * (buffer_V - rad);
+    Eigen::Vector2d pt_s_r = pt_s + dir.normalized() * buffer_P - offset_l * (buffer_V - rad);
+
+    // PDefine points on sides
+    Eigen::Vector2d pt_l_f = pt_f + offset_l * buffer_V - dir.normalized() * (buffer_P - rad);
+    Eigen::Vector2d pt_r_f = pt_f - offset_l * buffer_V - dir.normalized() * (buffer_P - rad);
+    Eigen::Vector2d pt_l_s = pt_s + offset_l * buffer_V + dir.normalized() * (buffer_P - rad);
+    Eigen::Vector2d pt_r_s = pt_s - offset_l * buffer_V + dir.normalized() * (buffer_P - rad);
+
+    // Define points on radius (at 45 degrees)
+    Eigen::Vector2d pt_rad_f_l = pt_f - dir.normalized() * (buffer_P - rad) +
+                                 offset_l * (buffer_V - rad) + rot(135) * dir.normalized() * rad;
+    Eigen::Vector2d pt_rad_f_r = pt_f - dir.normalized() * (buffer_P - rad) -
+                                 offset_l * (buffer_V - rad) + rot(225) * dir.normalized() * rad;
+    Eigen::Vector2d pt_rad_s_l = pt_s + dir.normalized() * (buffer_P - rad) +
+                                 offset_l * (buffer_V - rad) + rot(45) * dir.normalized() * rad;
+    Eigen::Vector2d pt_rad_s_r = pt_s + dir.normalized() * (buffer_P - rad) -
+                                 offset_l * (buffer_V - rad) + rot(315) * dir.normalized() * rad;
+
+    // Polygon along the boundary (left side, around second point, right side, around first)
+    for (const auto & pt : {pt_l_f, pt_l_s, pt_rad_s_l, pt_s_l, pt_s_r, pt_rad_s_r, pt_r_s, pt_r_f,
+                            pt_rad_f_r, pt_f_r, pt_f_l, pt_rad_f_l}) {
+      pts.push_back(pt);
+    }
+  }
+}
+
+/*************************************************************************
+ * Create buffers around each line segment as areas for visualization
+ * => primitives are not part of any map and have no id
+ **************************************************************************/
+lanelet::Areas create_buffer(
+  const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
+  const double rad)
+{
+  lanelet::BasicPoints2d pts;
+  buffer_polygons(lss, buffer_V, buffer_P, rad, pts);
+
+  lanelet::Areas buffers;
+  for (size_t k = 0; k < pts.size(); k += buffer_points) {
+    lanelet::Points3d points;
+    for (size_t i = k; i < k + buffer_points; ++i) {
+      points.push_back(lanelet::Point3d(lanelet::InvalId, pts[i].x(), pts[i].y(), 0.0));
+    }
+    lanelet::LineStrings3d bound;
+    for (size_t i = 0; i < points.size(); ++i) {
+      bound.push_back(
+        lanelet::LineString3d(lanelet::InvalId, {points[i], points[(i + 1) % points.size()]}));
+    }
+    buffers.push_back(lanelet::Area(lanelet::InvalId, bound));
+  }
+  return buffers;
+}
+
+/***************************************************************************
+ * Check if a point is inside a (buffer) polygon
+ * => crossing number test
+ ****************************************************************************/
+template <typename PointT>
+bool inside_polygon(const PointT * poly, const size_t n, const PointT & pt)
+{
+  bool inside = false;
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    if (
+      (poly[i].y() > pt.y()) != (poly[j].y() > pt.y()) &&
+      pt.x() < (poly[j].x() - poly[i].x()) * (pt.y() - poly[i].y()) / (poly[j].y() - poly[i].y()) +
+                 poly[i].x()) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+/*************************************************************************************
+ * Sum of the distances of all points to the closest point of another set of points
+ **************************************************************************************/
+template <typename PointsT>
+double closest_sum(const PointsT & from, const PointsT & to)
+{
+  using T = typename PointsT::value_type::Scalar;
+  double sum = 0;
+  for (const auto & pt1 : from) {
+    T min = std::numeric_limits<T>::max();
+    for (const auto & pt2 : to) {
+      min = std::min(min, (pt1 - pt2).norm());
+    }
+    sum += min;
+  }
+  return sum;
+}
+
+/*************************************************************************************
+ * Express a 2D homogeneous transformation in coordinates relative to a local origin
+ **************************************************************************************/
+template <typename T>
+Eigen::Matrix<T, 3, 3> local_transform(
+  const Eigen::Matrix3d & trans, const Eigen::Vector2d & origin)
+{
+  Eigen::Matrix3d shift = Eigen::Matrix3d::Identity();
+  Eigen::Matrix3d shift_inv = Eigen::Matrix3d::Identity();
+  shift.block<2, 1>(0, 2) = origin;
+  shift_inv.block<2, 1>(0, 2) = -origin;
+  return (shift_inv * trans * shift).cast<T>();
+}
+
+/*****************************************************************************
+ * Simplify linestring with Douglas-Peucker (2D)
+ ******************************************************************************/
+template <typename LineStringT>
+std::vector<bool> douglas_peucker(const LineStringT & ls, const double tol)
+{
+  if (ls.size() < 3 || tol <= 0.0) {
+    return std::vector<bool>(ls.size(), true);
+  }
+
+  // Iterative Douglas-Peucker => keep points with distance > tol to the current chord
+  std::vector<bool> keep(ls.size(), false);
+  keep.front() = keep.back() = true;
+  std::vector<std::pair<size_t, size_t>> stack{{0, ls.size() - 1}};
+  while (!stack.empty()) {
+    const auto [first, last] = stack.back();
+    stack.pop_back();
+    const Eigen::Vector2d a(ls[first].x(), ls[first].y());
+    const Eigen::Vector2d ab = Eigen::Vector2d(ls[last].x(), ls[last].y()) - a;
+    const double len = ab.norm();
+    double d_max = 0.0;
+    size_t ind = first;
+    for (size_t i = first + 1; i < last; ++i) {
+      const Eigen::Vector2d ap = Eigen::Vector2d(ls[i].x(), ls[i].y()) - a;
+      const double d = (len > 0.0) ? std::abs(ab.x() * ap.y() - ab.y() * ap.x()) / len : ap.norm();
+      if (d > d_max) {
+        d_max = d;
+        ind = i;
+      }
+    }
+    if (d_max > tol) {
+      keep[ind] = true;
+      stack.push_back({first, ind});
+      stack.push_back({ind, last});
+    }
+  }
+  return keep;
+}
+
+/**********
+ * Ids
+ ***********/
+
+/**************************************************************************************
+ * Get unique id for primitives that enter a lanelet map or whose id is used to track
+ * them (e.g. segments of polylines)
+ * => ids are reserved in blocks per thread => no contention on the global id counter
+ *    of lanelet2 if modules run in parallel
+ ***************************************************************************************/
+lanelet::Id next_id()
+{
+  constexpr lanelet::Id block = 1024;
+  thread_local lanelet::Id next = 0;
+  thread_local lanelet::Id end = 0;
+  if (next == end) {
+    // Reserve block [next, next + block) in the global id counter
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    next = lanelet::utils::getId();
+    lanelet::utils::registerId(next + block - 1);
+    end = next + block;
+  }
+  return next++;
+}
+
+/***********************
+ * Parallel execution
+ ************************/
+
+/**************************************************************************************
+ * Execute func(i) for i in [0, n) on a pool of worker threads
+ * => threads <= 0: number of hardware threads
+ * => done(k) is called on the calling thread after k items finished (progress report
+ *    from a single thread only)
+ ***************************************************************************************/
+void parallel_for(
+  const size_t n, const int threads, const std::function<void(const size_t)> & func,
+  const std::function<void(const size_t)> & done)
+{
+  const size_t num_threads = std::min(
+    n, static_cast<size_t>(
+         threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())));
+  std::atomic<size_t> next{0};
+  size_t finished = 0;
+  std::mutex mutex;
+  std::condition_variable cv;
+  auto worker = [&]() {
+    for (size_t i = next++; i < n; i = next++) {
+      func(i);
+      if (done) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          ++finished;
+        }
+        cv.notify_one();
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < num_threads; ++i) {
+    pool.emplace_back(worker);
+  }
+
+  // Report finished items on the calling thread
+  if (done) {
+    size_t reported = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (reported < n) {
+      cv.wait(lock, [&]() { return finished > reported; });
+      reported = finished;
+      lock.unlock();
+      done(reported);
+      lock.lock();
+    }
+  }
+  for (auto & t : pool) {
+    t.join();
+  }
+}
+
+/******************
+ * Color table
+ *******************/
+
+/*********************************************************
+ * Check if a color code is assigned to a lanelet id
+ **********************************************************/
+bool s_color_table::contains(const lanelet::Id & id) const
+{
+  return this->ids.find(id) != this->ids.end();
+}
+
+/*************************************************************************
+ * Assign color code to lanelet id (first assigned color code is kept)
+ **************************************************************************/
+void s_color_table::insert(const lanelet::Id & id, const std::string & code)
+{
+  if (this->contains(id)) {
+    return;
+  }
+  auto it = std::find(this->col_codes.begin(), this->col_codes.end(), code);
+  if (it == this->col_codes.end()) {
+    this->col_codes.push_back(code);
+    it = this->col_codes.end() - 1;
+  }
+  this->ids.emplace(id, static_cast<int>(std::distance(this->col_codes.begin(), it)));
+}
+
+/*********************************************************************
+ * Return index of the color code of a lanelet (-1 if not colored)
+ **********************************************************************/
+int s_color_table::index(const lanelet::Id & id) const
+{
+  const auto it = this->ids.find(id);
+  return (it != this->ids.end()) ? it->second : -1;
+}
+
+/*******************************************************************
+ * Return color code of a lanelet (empty if not colored)
+ ********************************************************************/
+std::string s_color_table::code(const lanelet::Id & id) const
+{
+  const int ind = this->index(id);
+  return (ind >= 0) ? this->col_codes[ind] : "";
+}
+const std::vector<std::string> & s_color_table::codes() const
+{
+  return this->col_codes;
+}
+bool s_color_table::empty() const
+{
+  return this->ids.empty();
+}
+void s_color_table::erase(const lanelet::Id & id)
+{
+  this->ids.erase(id);
+}
+void s_color_table::clear()
+{
+  this->ids.clear();
+  this->col_codes.clear();
+}
+
+/************
+ * Arena
+ *************/
+
+s_arena::s_arena(const size_t size) : buf(new std::byte[size]), size(size)
+{
+  this->mono =
+    std::make_unique<std::pmr::monotonic_buffer_resource>(buf.get(), size, &this->upstream);
+}
+
+/********************************************************
+ * Memory resource to allocate scratch data from
+ *********************************************************/
+std::pmr::memory_resource * s_arena::get()
+{
+  return this->mono.get();
+}
+
+/*****************************************************************************
+ * Release all scratch data (must not be used anymore) and grow the buffer
+ * if the last round did not fit into it
+ ******************************************************************************/
+void s_arena::reset()
+{
+  this->mono->release();
+  if (this->upstream.bytes > 0) {
+    this->size = 2 * (this->size + this->upstream.bytes);
+    this->buf.reset(new std::byte[this->size]);
+    this->upstream.bytes = 0;
+    this->mono = std::make_unique<std::pmr::monotonic_buffer_resource>(
+      this->buf.get(), this->size, &this->upstream);
+  }
+}
+
+void * s_arena::s_upstream::do_allocate(size_t n, size_t align)
+{
+  this->bytes += n;
+  return std::pmr::new_delete_resource()->allocate(n, align);
+}
+void s_arena::s_upstream::do_deallocate(void * p, size_t n, size_t align)
+{
+  std::pmr::new_delete_resource()->deallocate(p, n, align);
+}
+bool s_arena::s_upstream::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+{
+  return this == &other;
+}
@@ -0,0 +1,88 @@
+# Copyright 2023 Maximilian Leitenstern
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# ========================================== //
+# Author: Maximilian Leitenstern (TUM)
+# Date: 17.10.2026
+# ========================================== //
+#
+#
+import os
+import os.path
+
+from ament_index_python import get_package_share_directory
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import LaunchConfiguration
+from launch.substitutions import TextSubstitution
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.actions import Node
+from launch_ros.descriptions import ComposableNode
+
+
+def generate_launch_description():
+    # Define path to config folder
+    config = os.path.join(get_package_share_directory("tum_lanelet2_osm_fusion"), "config")
+
+    # Define command line args
+    traj_path = DeclareLaunchArgument(
+        "traj_path", default_value=TextSubstitution(text="test/Route_1_GPS.txt")
+    )
+    poses_path = DeclareLaunchArgument(
+        "poses_path", default_value=TextSubstitution(text="test/route1_pose_kitti.txt")
+    )
+    map_path = DeclareLaunchArgument(
+        "map_path", default_value=TextSubstitution(text="test/lanelet2_route_1.osm")
+    )
+    out_path = DeclareLaunchArgument(
+        "out_path", default_value=TextSubstitution(text="lanelet2_map.osm")
+    )
+
+    # Start nodes
+    rviz2_node = Node(
+        package="rviz2",
+        namespace="",
+        executable="rviz2",
+        name="rviz2",
+        arguments=["-d" + os.path.join(config, "rviz_conf.rviz")],
+    )
+
+    # Multi-threaded container => downstream consumers can be loaded into the same
+    # container and receive the marker arrays without serialization
+    container = ComposableNodeContainer(
+        name="lanelet2_osm_container",
+        namespace="",
+        package="rclcpp_components",
+        executable="component_container_mt",
+        output="screen",
+        composable_node_descriptions=[
+            ComposableNode(
+                package="tum_lanelet2_osm_fusion",
+                plugin="clanelet2_osm",
+                name="lanelet2_osm",
+                parameters=[
+                    {
+                        "traj_path": LaunchConfiguration("traj_path"),
+                        "poses_path": LaunchConfiguration("poses_path"),
+                        "map_path": LaunchConfiguration("map_path"),
+                        "out_path": LaunchConfiguration("out_path"),
+                    },
+                    os.path.join(config, "lanelet2_osm.param.yaml"),
+                ],
+                extra_arguments=[{"use_intra_process_comms": True}],
+            )
+        ],
+    )
+
+    return LaunchDescription([traj_path, poses_path, map_path, out_path, container, rviz2_node])
@@ -21,10 +21,17 @@
 #include "analysis.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -36,26 +43,63 @@ canalysis::canalysis()
 {
 }
 
+canalysis::~canalysis()
+{
+  wait();
+}
+
 /****************/
 /*public methods*/
 /****************/
 
+/*************************************************************************
+ * Start background thread writing staged analysis data
+ * => at most <capacity> files are queued, staging blocks if queue full
+ **************************************************************************/
+void canalysis::start_writer(const size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(this->jobs_mutex);
+  if (this->running) {
+    return;
+  }
+  this->capacity = std::max<size_t>(capacity, 1);
+  this->stop = false;
+  this->running = true;
+  this->io_thread = std::thread(&canalysis::io_loop, this);
+}
+
+/*****************************************************************************
+ * Wait until all staged analysis data is written and stop background thread
+ * => returns number of files written so far
+ ******************************************************************************/
+size_t canalysis::wait()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->jobs_mutex);
+    this->stop = true;
+  }
+  this->cv_jobs.notify_all();
+  if (this->io_thread.joinable()) {
+    this->io_thread.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->jobs_mutex);
+    this->running = false;
+  }
+  return this->written.load();
+}
+
 /************************************************************************
- * Calculate difference between aligned and rubber-sheeted trajectory
- * and export everything into txt-files for python-visualization
+ * Calculate difference between master and aligned trajectory and
+ * stage trajectories for python-visualization
  *************************************************************************/
-bool canalysis::traj_matching(
+bool canalysis::traj_alignment(
   rclcpp::Node & node, const lanelet::ConstLineString3d & src,
   const lanelet::ConstLineString3d & target, const lanelet::ConstLineString3d & target_al,
-  const lanelet::ConstLineString3d & target_rs, const lanelet::Areas & tri,
-  const std::vector<s_control_point> & cps, std::vector<double> & diff_al,
-  std::vector<double> & diff_rs)
+  std::vector<double> & diff_al)
 {
   diff_al.clear();
-  diff_rs.clear();
-
   calc_diff(src, target_al, diff_al);
-  calc_diff(src, target_rs, diff_rs);
 
   const std::string traj_matching_dir = "/traj_matching";
   create_output_dir(node, traj_matching_dir);
@@ -63,28 +107,45 @@ bool canalysis::traj_matching(
   write_ls(node, src, traj_matching_dir, "source.txt");
   write_ls(node, target, traj_matching_dir, "target.txt");
   write_ls(node, target_al, traj_matching_dir, "target_al.txt");
+  write_double_vec(node, diff_al, traj_matching_dir, "diff_al.txt");
+  return true;
+}
+
+/************************************************************************
+ * Calculate difference between master and rubber-sheeted trajectory and
+ * stage rubber-sheeting results for python-visualization
+ *************************************************************************/
+bool canalysis::traj_rubber_sheeting(
+  rclcpp::Node & node, const lanelet::ConstLineString3d & src,
+  const lanelet::ConstLineString3d & target_rs, const lanelet::Areas & tri,
+  const std::vector<s_control_point> & cps, std::vector<double> & diff_rs)
+{
+  diff_rs.clear();
+  calc_diff(src, target_rs, diff_rs);
+
+  const std::string traj_matching_dir = "/traj_matching";
+  create_output_dir(node, traj_matching_dir);
+
   write_ls(node, target_rs, traj_matching_dir, "target_rs.txt");
   write_areas(node, tri, traj_matching_dir, "triangles.txt");
   write_cp(node, cps, traj_matching_dir, "controlPoints.txt");
-  write_double_vec(node, diff_al, traj_matching_dir, "diff_al.txt");
   write_double_vec(node, diff_rs, traj_matching_dir, "diff_rs.txt");
   return true;
 }
 
-/*************************************************************
- * Export matching data in txt-files for python-visualization
- **************************************************************/
-bool canalysis::matching(
-  rclcpp::Node & node, const std::vector<s_match> & matches, const lanelet::LineStrings3d & osm,
-  const lanelet::ConstLanelets & lls, std::vector<std::pair<lanelet::Id, std::string>> & ll_cols,
-  const lanelet::ConstLanelets & lls_updated)
+/*******************************************************************
+ * Stage matches and openstreetmap-linestrings for python-visualization
+ ********************************************************************/
+bool canalysis::matching_results(
+  rclcpp::Node & node, const std::vector<s_match> & matches, const lanelet::LineStrings3d & osm)
 {
-  std::vector<double> dAng, dLen, dChord, dPoly, dChamfer, lenRefPline, score;
+  std::vector<double> dAng, dLen, dChord, dPoly, dFrechet, dChamfer, lenRefPline, score;
   for (const auto & match : matches) {
     dAng.push_back(match.d_ang());
     dLen.push_back(match.d_len());
     dChord.push_back(match.d_chord());
     dPoly.push_back(match.d_poly());
+    dFrechet.push_back(match.d_frechet());
     dChamfer.push_back(match.d_chamfer());
     lenRefPline.push_back(match.len_ref_pline());
     score.push_back(match.score());
@@ -100,76 +161,199 @@ bool canalysis::matching(
   write_double_vec(node, dLen, matching_dir, "dLen.txt");
   write_double_vec(node, dChord, matching_dir, "dChord.txt");
   write_double_vec(node, dPoly, matching_dir, "dPoly.txt");
+  write_double_vec(node, dFrechet, matching_dir, "dFrechet.txt");
   write_double_vec(node, dChamfer, matching_dir, "dChamfer.txt");
   write_double_vec(node, lenRefPline, matching_dir, "lenRefPline.txt");
   write_double_vec(node, score, matching_dir, "score.txt");
   write_lss(node, osm, matching_dir, "osm_linestrings.txt");
+  return true;
+}
+
+/***************************************************************************
+ * Stage original (colored) and updated lanelets for python-visualization
+ ****************************************************************************/
+bool canalysis::matching_lanelets(
+  rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & ll_cols,
+  const lanelet::ConstLanelets & lls_updated)
+{
+  const std::string matching_dir = "/matching";
+  create_output_dir(node, matching_dir);
+
   write_lanelets(node, lls, matching_dir, "lanelets.txt");
   write_lanelets_cols(node, lls, ll_cols, matching_dir, "lanelets_colors.txt");
   write_lanelets(node, lls_updated, matching_dir, "lanelets_updated.txt");
   write_lanelets_WGS84(node, lls, matching_dir, "lanelets_WGS84.txt");
-
   return true;
 }
 
-/*****************/
-/*private methods*/
-/*****************/
+/***************************************************************************
+ * Calculate difference between source & target trajectory
+ * => vertical distance from target to source for each point
+ * => segments of source indexed in a uniform grid, closest segment found
+ *    with a ring search around each point, points processed in parallel
+ * => bit-identical to calc_diff_brute (same distance kernel)
+ ****************************************************************************/
+void canalysis::calc_diff(
+  const lanelet::ConstLineString3d & src, const lanelet::ConstLineString3d & target,
+  std::vector<double> & diff)
+{
+  if (src.size() < 2) {
+    return;
+  }
+  // Cell size from mean segment length => few segments per cell
+  const size_t num_seg = src.size() - 1;
+  double len = 0.0;
+  double x_min = src.front().x();
+  double y_min = src.front().y();
+  for (size_t i = 0; i < num_seg; ++i) {
+    len += std::hypot(src[i + 1].x() - src[i].x(), src[i + 1].y() - src[i].y());
+    x_min = std::min(x_min, src[i + 1].x());
+    y_min = std::min(y_min, src[i + 1].y());
+  }
+  const double cell = std::max(len / num_seg, 0.1);
+
+  // Insert segments into all cells overlapped by their bounding box
+  auto cell_ind = [&](const double v, const double v_min) {
+    return static_cast<int64_t>(std::floor((v - v_min) / cell));
+  };
+  auto key = [](const int64_t ix, const int64_t iy) { return (ix << 32) ^ (iy & 0xffffffff); };
+  std::unordered_map<int64_t, std::vector<size_t>> grid;
+  int64_t ix_max = 0;
+  int64_t iy_max = 0;
+  for (size_t i = 0; i < num_seg; ++i) {
+    const int64_t x0 = cell_ind(std::min(src[i].x(), src[i + 1].x()), x_min);
+    const int64_t x1 = cell_ind(std::max(src[i].x(), src[i + 1].x()), x_min);
+    const int64_t y0 = cell_ind(std::min(src[i].y(), src[i + 1].y()), y_min);
+    const int64_t y1 = cell_ind(std::max(src[i].y(), src[i + 1].y()), y_min);
+    for (int64_t ix = x0; ix <= x1; ++ix) {
+      for (int64_t iy = y0; iy <= y1; ++iy) {
+        grid[key(ix, iy)].push_back(i);
+      }
+    }
+    ix_max = std::max(ix_max, x1);
+    iy_max = std::max(iy_max, y1);
+  }
+
+  // Ring search around the cell of each point (in parallel)
+  // => after ring r all segments closer than r * cell are visited
+  // => only cells of the ring inside the grid are visited
+  diff.assign(target.size(), 0.0);
+  auto search = [&](const size_t p) {
+    const lanelet::ConstPoint3d & pt = target[p];
+    const int64_t cx = cell_ind(pt.x(), x_min);
+    const int64_t cy = cell_ind(pt.y(), y_min);
+    double best = std::numeric_limits<double>::max();
+    auto visit = [&](const int64_t ix, const int64_t iy) {
+      const auto it = grid.find(key(ix, iy));
+      if (it != grid.end()) {
+        for (const size_t i : it->second) {
+          best = std::min(best, seg_dist(pt, src[i], src[i + 1]));
+        }
+      }
+    };
+    // First ring that intersects the grid
+    const int64_t r0 = std::max({int64_t(0), -cx, -cy, cx - ix_max, cy - iy_max});
+    for (int64_t r = r0;; ++r) {
+      const int64_t x0 = std::max(cx - r, int64_t(0));
+      const int64_t x1 = std::min(cx + r, ix_max);
+      const int64_t y0 = std::max(cy - r + 1, int64_t(0));
+      const int64_t y1 = std::min(cy + r - 1, iy_max);
+      for (const int64_t iy : {cy - r, cy + r}) {
+        if (iy >= 0 && iy <= iy_max) {
+          for (int64_t ix = x0; ix <= x1; ++ix) {
+            visit(ix, iy);
+          }
+        }
+        if (r == 0) {
+          break;
+        }
+      }
+      for (const int64_t ix : {cx - r, cx + r}) {
+        if (r > 0 && ix >= 0 && ix <= ix_max) {
+          for (int64_t iy = y0; iy <= y1; ++iy) {
+            visit(ix, iy);
+          }
+        }
+      }
+      // Margin => rounding of the kernel can't hide a closer segment
+      const bool covered = cx - r <= 0 && cy - r <= 0 && cx + r >= ix_max && cy + r >= iy_max;
+      if (covered || best < r * cell - 1e-6) {
+        break;
+      }
+    }
+    diff[p] = best;
+  };
+  parallel_for(target.size(), 0, search);
+}
 
 /***************************************************************
  * Calculate difference between source & target trajectory
- * => vertical distance from target to source for each point
+ * => distance of each point to every segment (reference)
  ****************************************************************/
-void canalysis::calc_diff(
+void canalysis::calc_diff_brute(
   const lanelet::ConstLineString3d & src, const lanelet::ConstLineString3d & target,
   std::vector<double> & diff)
 {
   // Iterate through points on target trajectory
   for (const auto & pt : target) {
-    double d = 0;
     std::vector<double> dist;
     // Iterate through segments on source trajectory to find closest distance
     for (auto it = src.begin(); it != src.end() - 1; ++it) {
-      // If segment length > 1cm => calculate minimum distance of target point to segment
-      // Else => take minimum distance from two point on segment
-      if (lanelet::geometry::distance2d(*it, *(it + 1)) > 0.01) {
-        // Code to calculate distance from a point to a line SEGMENT, not a line
-        Eigen::Vector2d ab((it + 1)->x() - it->x(), (it + 1)->y() - it->y());
-        Eigen::Vector2d ap(pt.x() - it->x(), pt.y() - it->y());
-
-        // u
-        double u = ab.dot(ap) / ab.dot(ab);
-
-        // 3 Cases
-        // 1. Shortest distance point to segment = distance point to segment end point
-        // 2. Shortest distance point to segment = distance point to segment start point
-        // 3. Shortest distance point to segment = perpendicular distance
-        if (u > 1) {
-          double y = pt.y() - (it + 1)->y();
-          double x = pt.x() - (it + 1)->x();
-          d = sqrt(x * x + y * y);
-        } else if (u < 0) {
-          double y = pt.y() - it->y();
-          double x = pt.x() - it->x();
-          d = sqrt(x * x + y * y);
-        } else {
-          double x1 = ab(0);
-          double y1 = ab(1);
-          double x2 = ap(0);
-          double y2 = ap(1);
-          double mod = sqrt(x1 * x1 + y1 * y1);
-          d = std::abs(x1 * y2 - y1 * x2) / mod;
-        }
-      } else {
-        d = std::min(
-          lanelet::geometry::distance2d(pt, *it), lanelet::geometry::distance2d(pt, *(it + 1)));
-      }
-      dist.push_back(d);
+      dist.push_back(seg_dist(pt, *it, *(it + 1)));
     }
     diff.push_back(*std::min_element(dist.begin(), dist.end()));
   }
 }
 
+/*****************/
+/*private methods*/
+/*****************/
+
+/***************************************************************************
+ * Distance of a point to a segment of the source trajectory
+ * => minimum distance to the segment points for segments shorter than 1cm
+ ****************************************************************************/
+double canalysis::seg_dist(
+  const lanelet::ConstPoint3d & pt, const lanelet::ConstPoint3d & a,
+  const lanelet::ConstPoint3d & b)
+{
+  double d = 0;
+  // If segment length > 1cm => calculate minimum distance of target point to segment
+  // Else => take minimum distance from two point on segment
+  if (lanelet::geometry::distance2d(a, b) > 0.01) {
+    // Code to calculate distance from a point to a line SEGMENT, not a line
+    Eigen::Vector2d ab(b.x() - a.x(), b.y() - a.y());
+    Eigen::Vector2d ap(pt.x() - a.x(), pt.y() - a.y());
+
+    // u
+    double u = ab.dot(ap) / ab.dot(ab);
+
+    // 3 Cases
+    // 1. Shortest distance point to segment = distance point to segment end point
+    // 2. Shortest distance point to segment = distance point to segment start point
+    // 3. Shortest distance point to segment = perpendicular distance
+    if (u > 1) {
+      double y = pt.y() - b.y();
+      double x = pt.x() - b.x();
+      d = sqrt(x * x + y * y);
+    } else if (u < 0) {
+      double y = pt.y() - a.y();
+      double x = pt.x() - a.x();
+      d = sqrt(x * x + y * y);
+    } else {
+      double x1 = ab(0);
+      double y1 = ab(1);
+      double x2 = ap(0);
+      double y2 = ap(1);
+      double mod = sqrt(x1 * x1 + y1 * y1);
+      d = std::abs(x1 * y2 - y1 * x2) / mod;
+    }
+  } else {
+    d = std::min(lanelet::geometry::distance2d(pt, a), lanelet::geometry::distance2d(pt, b));
+  }
+  return d;
+}
+
 /*******************************************************************************
  * Create subdirectory in the desired output-directory if not existing so far
  ********************************************************************************/
@@ -183,222 +367,167 @@ void canalysis::create_output_dir(rclcpp::Node & node, const std::string & dir_p
 }
 
 /**************************************
- * Write linestring to txt-file
+ * Write linestring to file
  ***************************************/
 void canalysis::write_ls(
   rclcpp::Node & node, const lanelet::ConstLineString3d & ls, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & pt : ls) {
-      file << pt.x() << " " << pt.y() << std::endl;
-    }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+  std::vector<double> vals;
+  vals.reserve(2 * ls.size());
+  for (const auto & pt : ls) {
+    vals.push_back(pt.x());
+    vals.push_back(pt.y());
   }
+  write_rows(node, std::move(vals), {}, 2, 6, dir_path, file_name);
 }
 
 /**************************************
- * Write linestrings to txt-file
+ * Write linestrings to file
  ***************************************/
 void canalysis::write_lss(
   rclcpp::Node & node, const lanelet::LineStrings3d & lss, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & ls : lss) {
-      for (const auto & pt : ls) {
-        file << pt.x() << " " << pt.y() << " ";
-      }
-      file << std::endl;
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & ls : lss) {
+    for (const auto & pt : ls) {
+      vals.push_back(pt.x());
+      vals.push_back(pt.y());
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 6, dir_path, file_name);
 }
 
 /***************************************
- * Write double-vector to txt-file
+ * Write double-vector to file
  ****************************************/
 void canalysis::write_double_vec(
   rclcpp::Node & node, const std::vector<double> & vec, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & el : vec) {
-      file << el << std::endl;
-    }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
-  }
+  write_rows(node, vec, {}, 1, 6, dir_path, file_name);
 }
 
 /********************************
- * Write areas to txt-file
+ * Write areas to file
  *********************************/
 void canalysis::write_areas(
   rclcpp::Node & node, const lanelet::Areas & areas, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & ar : areas) {
-      lanelet::ConstLineStrings3d lss = ar.outerBound();
-      for (const auto & ls : lss) {
-        file << ls[0].x() << " " << ls[0].y() << " " << ls[1].x() << " " << ls[1].y() << " ";
-      }
-      file << std::endl;
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & ar : areas) {
+    lanelet::ConstLineStrings3d lss = ar.outerBound();
+    for (const auto & ls : lss) {
+      vals.insert(vals.end(), {ls[0].x(), ls[0].y(), ls[1].x(), ls[1].y()});
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 6, dir_path, file_name);
 }
 
 /****************************************
- * Write controlpoints to txt-file
+ * Write controlpoints to file
  *****************************************/
 void canalysis::write_cp(
   rclcpp::Node & node, const std::vector<s_control_point> & cps, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & cpt : cps) {
-      lanelet::ConstPoint3d src = cpt.get_source_point();
-      lanelet::ConstPoint3d target = cpt.get_target_point();
-      file << src.x() << " " << src.y() << " " << target.x() << " " << target.y() << std::endl;
-    }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+  std::vector<double> vals;
+  vals.reserve(4 * cps.size());
+  for (const auto & cpt : cps) {
+    lanelet::ConstPoint3d src = cpt.get_source_point();
+    lanelet::ConstPoint3d target = cpt.get_target_point();
+    vals.insert(vals.end(), {src.x(), src.y(), target.x(), target.y()});
   }
+  write_rows(node, std::move(vals), {}, 4, 6, dir_path, file_name);
 }
 
 /**********************************************************************************
- * Write reference or target polyline or match connection of a match to txt-file
+ * Write reference or target polyline or match connection of a match to file
  ***********************************************************************************/
 void canalysis::write_match_pline(
   rclcpp::Node & node, const std::vector<s_match> & matches, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & match : matches) {
-      lanelet::ConstLineStrings3d pline;
-      if (file_name.find("ref") != std::string::npos) {
-        pline = to_const(match.ref_pline());
-      } else if (file_name.find("target") != std::string::npos) {
-        pline = to_const(match.target_pline());
-      } else if (file_name.find("conn") != std::string::npos) {
-        pline = match.match_conn();
-      } else {
-        std::cerr << __FUNCTION__ << ": specify ref,target or conn in the filename!" << std::endl;
-      }
-      for (const auto & ls : pline) {
-        file << ls.front().x() << " " << ls.front().y() << " " << ls.back().x() << " "
-             << ls.back().y() << " ";
-      }
-      file << std::endl;
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & match : matches) {
+    lanelet::ConstLineStrings3d pline;
+    if (file_name.find("ref") != std::string::npos) {
+      pline = to_const(match.ref_pline());
+    } else if (file_name.find("target") != std::string::npos) {
+      pline = to_const(match.target_pline());
+    } else if (file_name.find("conn") != std::string::npos) {
+      pline = match.match_conn();
+    } else {
+      std::cerr << __FUNCTION__ << ": specify ref,target or conn in the filename!" << std::endl;
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    for (const auto & ls : pline) {
+      vals.insert(vals.end(), {ls.front().x(), ls.front().y(), ls.back().x(), ls.back().y()});
+    }
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 6, dir_path, file_name);
 }
 
 /***********************************************
- * Write buffers of a match to txt-file
+ * Write buffers of a match to file
  ************************************************/
 void canalysis::write_match_areas(
   rclcpp::Node & node, const std::vector<s_match> & matches, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & match : matches) {
-      lanelet::Areas areas = match.buffers();
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & match : matches) {
+    lanelet::Areas areas = match.buffers();
 
-      for (const auto & area : areas) {
-        lanelet::ConstLineStrings3d lss = area.outerBound();
-        for (const auto & ls : lss) {
-          file << ls.front().x() << " " << ls.front().y() << " " << ls.back().x() << " "
-               << ls.back().y() << " ";
-        }
+    for (const auto & area : areas) {
+      lanelet::ConstLineStrings3d lss = area.outerBound();
+      for (const auto & ls : lss) {
+        vals.insert(vals.end(), {ls.front().x(), ls.front().y(), ls.back().x(), ls.back().y()});
       }
-      file << std::endl;
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 6, dir_path, file_name);
 }
 
 /***********************************************
- * Write lanelets of a map to txt-file
+ * Write lanelets of a map to file
  ************************************************/
 void canalysis::write_lanelets(
   rclcpp::Node & node, const lanelet::ConstLanelets & lls, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & ll : lls) {
-      for (const auto & pt : ll.leftBound()) {
-        file << pt.x() << " " << pt.y() << " ";
-      }
-      for (const auto & pt : ll.rightBound().invert()) {
-        file << pt.x() << " " << pt.y() << " ";
-      }
-      file << std::endl;
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & ll : lls) {
+    for (const auto & pt : ll.leftBound()) {
+      vals.push_back(pt.x());
+      vals.push_back(pt.y());
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    for (const auto & pt : ll.rightBound().invert()) {
+      vals.push_back(pt.x());
+      vals.push_back(pt.y());
+    }
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 6, dir_path, file_name);
 }
 
 /***********************************************
- * Write lanelets of a map to txt-file
+ * Write lanelets of a map in WGS84 to file
  ************************************************/
 void canalysis::write_lanelets_WGS84(
   rclcpp::Node & node, const lanelet::ConstLanelets & lls, const std::string & dir_path,
   const std::string & file_name)
 {
-  const std::string file_path =
-    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
   // Get map origin and projector type
   const std::string proj_type = node.get_parameter("proj_type").as_string();
   const double orig_lat = node.get_parameter("orig_lat").as_double();
@@ -407,67 +536,239 @@ void canalysis::write_lanelets_WGS84(
   lanelet::GPSPoint position{orig_lat, orig_lon};
   lanelet::Origin orig{position};
 
-  if (file.is_open()) {
-    for (const auto & ll : lls) {
+  // Projector is set up once for all points
+  std::unique_ptr<lanelet::Projector> projector;
+  if (proj_type == "MGRS") {
+    auto mgrs = std::make_unique<lanelet::projection::MGRSProjector>();
+    mgrs->setMGRSCode({position});
+    projector = std::move(mgrs);
+  } else if (proj_type == "UTM") {
+    projector = std::make_unique<lanelet::projection::UtmProjector>(orig);
+  }
+
+  std::vector<double> vals;
+  std::vector<int64_t> offs{0};
+  for (const auto & ll : lls) {
+    if (projector) {
       for (const auto & pt : ll.leftBound()) {
-        if (proj_type == "MGRS") {
-          lanelet::projection::MGRSProjector projector;
-          projector.setMGRSCode({position});
-          lanelet::GPSPoint pt_WGS84 = projector.reverse(pt.basicPoint());
-          file << std::setprecision(15) << pt_WGS84.lat << " " << pt_WGS84.lon << " ";
-        } else if (proj_type == "UTM") {
-          lanelet::projection::UtmProjector projector{orig};
-          lanelet::GPSPoint pt_WGS84 = projector.reverse(pt.basicPoint());
-          file << std::setprecision(15) << pt_WGS84.lat << " " << pt_WGS84.lon << " ";
-        }
+        lanelet::GPSPoint pt_WGS84 = projector->reverse(pt.basicPoint());
+        vals.push_back(pt_WGS84.lat);
+        vals.push_back(pt_WGS84.lon);
       }
       for (const auto & pt : ll.rightBound().invert()) {
-        if (proj_type == "MGRS") {
-          lanelet::projection::MGRSProjector projector;
-          projector.setMGRSCode({position});
-          lanelet::GPSPoint pt_WGS84 = projector.reverse(pt.basicPoint());
-          file << std::setprecision(15) << pt_WGS84.lat << " " << pt_WGS84.lon << " ";
-        } else if (proj_type == "UTM") {
-          lanelet::projection::UtmProjector projector{orig};
-          lanelet::GPSPoint pt_WGS84 = projector.reverse(pt.basicPoint());
-          file << std::setprecision(15) << pt_WGS84.lat << " " << pt_WGS84.lon << " ";
-        }
+        lanelet::GPSPoint pt_WGS84 = projector->reverse(pt.basicPoint());
+        vals.push_back(pt_WGS84.lat);
+        vals.push_back(pt_WGS84.lon);
       }
-      file << std::endl;
     }
-    file.close();
-  } else {
-    std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    offs.push_back(static_cast<int64_t>(vals.size()));
   }
+  write_rows(node, std::move(vals), std::move(offs), 0, 15, dir_path, file_name);
 }
 
 /***********************************************
- * Write colors of lanelets of a map to txt-file
+ * Write colors of lanelets of a map to file
  ************************************************/
 void canalysis::write_lanelets_cols(
-  rclcpp::Node & node, const lanelet::ConstLanelets & lls,
-  std::vector<std::pair<lanelet::Id, std::string>> & ll_cols, const std::string & dir_path,
-  const std::string & file_name)
+  rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & ll_cols,
+  const std::string & dir_path, const std::string & file_name)
 {
+  std::vector<std::string> codes;
+  codes.reserve(lls.size());
+  for (const auto & ll : lls) {
+    codes.push_back(ll_cols.code(ll.id()));
+  }
   const std::string file_path =
     node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
-  std::ofstream file(file_path);
-
-  if (file.is_open()) {
-    for (const auto & ll : lls) {
-      // Find color string
-      std::string col_string = "";
-      for (const auto & el : ll_cols) {
-        if (el.first == ll.id()) {
-          col_string = el.second;
-          break;
+
+  if (binary(node)) {
+    stage([this, codes = std::move(codes), file_path]() {
+      // Fixed-width byte strings (numpy dtype S<width>)
+      size_t width = 1;
+      for (const auto & code : codes) {
+        width = std::max(width, code.size());
+      }
+      std::string data(codes.size() * width, '\0');
+      for (size_t i = 0; i < codes.size(); ++i) {
+        data.replace(i * width, codes[i].size(), codes[i]);
+      }
+      write_npy(
+        npy_path(file_path, ""), "|S" + std::to_string(width), {codes.size()}, data.data(),
+        data.size());
+    });
+    return;
+  }
+
+  stage([codes = std::move(codes), file_path]() {
+    std::ofstream file(file_path);
+
+    if (file.is_open()) {
+      for (const auto & code : codes) {
+        file << code << '\n';
+      }
+      file.close();
+    } else {
+      std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    }
+  });
+}
+
+/**************************************************************************************
+ * Stage rows of values to be written to file
+ * => fixed row width (cols > 0) or ragged rows described by offsets (cols = 0)
+ * => txt: one row per line separated by spaces
+ * => npy: array of shape (rows, cols) or flat values + int64 offsets (<name>_offsets)
+ ***************************************************************************************/
+void canalysis::write_rows(
+  rclcpp::Node & node, std::vector<double> vals, std::vector<int64_t> offs, const size_t cols,
+  const int prec, const std::string & dir_path, const std::string & file_name)
+{
+  const std::string file_path =
+    node.get_parameter("analysis_output_dir").as_string() + dir_path + "/" + file_name;
+
+  if (binary(node)) {
+    stage([this, vals = std::move(vals), offs = std::move(offs), cols, file_path]() {
+      const char * data = reinterpret_cast<const char *>(vals.data());
+      const size_t n_bytes = vals.size() * sizeof(double);
+      if (cols == 1) {
+        write_npy(npy_path(file_path, ""), "<f8", {vals.size()}, data, n_bytes);
+      } else if (cols > 1) {
+        write_npy(npy_path(file_path, ""), "<f8", {vals.size() / cols, cols}, data, n_bytes);
+      } else {
+        write_npy(npy_path(file_path, ""), "<f8", {vals.size()}, data, n_bytes);
+        write_npy(
+          npy_path(file_path, "_offsets"), "<i8", {offs.size()},
+          reinterpret_cast<const char *>(offs.data()), offs.size() * sizeof(int64_t));
+      }
+    });
+    return;
+  }
+
+  stage([vals = std::move(vals), offs = std::move(offs), cols, prec, file_path]() {
+    std::ofstream file(file_path);
+
+    if (file.is_open()) {
+      file << std::setprecision(prec);
+      if (cols > 0) {
+        for (size_t i = 0; i < vals.size(); ++i) {
+          file << vals[i] << (((i + 1) % cols == 0) ? '\n' : ' ');
+        }
+      } else {
+        for (size_t r = 0; r + 1 < offs.size(); ++r) {
+          for (int64_t i = offs[r]; i < offs[r + 1]; ++i) {
+            file << vals[i] << ' ';
+          }
+          file << '\n';
         }
       }
-      file << col_string << std::endl;
+      file.close();
+    } else {
+      std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
     }
-    file.close();
-  } else {
+  });
+}
+
+// Raw arrays are written with the little-endian descriptors <f8/<i8
+static_assert(
+  __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "npy output of the analysis requires little-endian");
+
+/*********************************************************************************
+ * Write raw array to npy-file (format version 1.0, little-endian, C-order)
+ **********************************************************************************/
+void canalysis::write_npy(
+  const std::string & file_path, const std::string & descr, const std::vector<size_t> & shape,
+  const char * data, const size_t n_bytes)
+{
+  std::ofstream file(file_path, std::ios::binary);
+
+  if (!file.is_open()) {
     std::cout << "\033[1;31m!! Unable to open " << file_path << " !!\033[0m" << std::endl;
+    return;
+  }
+
+  // Header dictionary, padded with spaces so that the data is 64-byte aligned
+  std::string shape_str = "(";
+  for (const auto & dim : shape) {
+    shape_str += std::to_string(dim) + ", ";
+  }
+  if (shape.size() > 1) {
+    shape_str.erase(shape_str.size() - 2);
+  } else {
+    shape_str.pop_back();
+  }
+  shape_str += ")";
+  std::string header =
+    "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape_str + ", }";
+  const size_t preamble = 10;
+  header.append(63 - (preamble + header.size()) % 64, ' ');
+  header.push_back('\n');
+
+  const uint16_t header_len = static_cast<uint16_t>(header.size());
+  file.write("\x93NUMPY\x01\x00", 8);
+  const char len_le[2] = {
+    static_cast<char>(header_len & 0xff), static_cast<char>((header_len >> 8) & 0xff)};
+  file.write(len_le, 2);
+  file.write(header.data(), header.size());
+  file.write(data, n_bytes);
+  file.close();
+}
+
+/**************************************************************************
+ * Path of npy-file => file extension replaced by <suffix>.npy
+ ***************************************************************************/
+std::string canalysis::npy_path(const std::string & file_path, const std::string & suffix)
+{
+  std::filesystem::path path(file_path);
+  return (path.parent_path() / (path.stem().string() + suffix + ".npy")).string();
+}
+
+/*******************************************************
+ * Check if analysis output is written in binary format
+ ********************************************************/
+bool canalysis::binary(rclcpp::Node & node)
+{
+  return node.get_parameter("analysis_format").as_string() == "npy";
+}
+
+/**************************************************************************
+ * Queue job writing a file for the background thread
+ * => blocks while the queue is full
+ * => executed immediately if no background thread is running
+ ***************************************************************************/
+void canalysis::stage(std::function<void()> job)
+{
+  std::unique_lock<std::mutex> lock(this->jobs_mutex);
+  if (!this->running || this->stop) {
+    lock.unlock();
+    job();
+    ++this->written;
+    return;
+  }
+  this->cv_space.wait(lock, [this]() { return this->jobs.size() < this->capacity; });
+  this->jobs.push_back(std::move(job));
+  lock.unlock();
+  this->cv_jobs.notify_one();
+}
+
+/*************************************************************************
+ * Background thread: write staged files until stopped and queue drained
+ **************************************************************************/
+void canalysis::io_loop()
+{
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(this->jobs_mutex);
+      this->cv_jobs.wait(lock, [this]() { return this->stop || !this->jobs.empty(); });
+      if (this->jobs.empty()) {
+        return;
+      }
+      job = std::move(this->jobs.front());
+      this->jobs.pop_front();
+    }
+    this->cv_space.notify_one();
+    job();
+    ++this->written;
   }
 }
 
@@ -50,6 +50,21 @@ bool cconflation::remove_tags(lanelet::LaneletMapPtr & map_ptr)
   return true;
 }
 
+/*****************************************************************************
+ * Remove tags and color codes transferred from OpenStreetMap from the lanelets
+ * of a region before it is re-conflated (incremental update)
+ * => subtype and location are kept (default of the input map is unknown)
+ ******************************************************************************/
+bool cconflation::clear_conflated_tags(lanelet::Lanelets & region, s_color_table & cols)
+{
+  for (auto & ll : region) {
+    remove_attributes(
+      ll, {"speed_limit", "road_name", "one_way", "road_surface", "lane_markings"});
+    cols.erase(ll.id());
+  }
+  return true;
+}
+
 /***********************************************************************************
  * Conflate information from OpenStreetMap into existing lanelet map:
  * -> map highway tag from osm to subtype and location tags in lanelet2
@@ -63,14 +78,24 @@ bool cconflation::remove_tags(lanelet::LaneletMapPtr & map_ptr)
  * remove lanelets that are likely to be wrong if more adjacent lanes than osm lanes tag
  ************************************************************************************/
 bool cconflation::conflate_lanelet_OSM(
-  lanelet::LaneletMapPtr & map_ptr, std::vector<s_match> & matches,
-  std::vector<std::pair<lanelet::Id, std::string>> & cols, lanelet::ConstLanelets & deleted)
+  lanelet::LaneletMapPtr & map_ptr, std::vector<s_match> & matches, s_color_table & cols,
+  lanelet::ConstLanelets & deleted)
 {
   const std::vector<std::string> target_keys = {"highway", "maxspeed",      "name",  "oneway",
                                                 "surface", "lane_markings", "lanes", "shoulder"};
 
   // Itearate through matches
+  size_t n = 0;
   for (auto & match : matches) {
+    // Check for cancellation and report progress
+    ++n;
+    if (cancelled()) {
+      std::cout << "\033[33m~~~~~> Conflation cancelled!\033[0m" << std::endl;
+      return false;
+    }
+    if (n % 50 == 0) {
+      update("conflate_lanelet_OSM", static_cast<double>(n) / matches.size());
+    }
     if (!match.target_pline().empty()) {
       std::vector<lanelet::ConstPoints3d> pts_change;
       std::vector<std::vector<std::string>> values;
@@ -235,8 +260,7 @@ void cconflation::transfer_att(
  * no lanes tag = blue, no match = white)
  ************************************************************************************/
 void cconflation::check_lanes(
-  const lanelet::LaneletMapPtr & map_ptr, s_match & match,
-  std::vector<std::pair<lanelet::Id, std::string>> & cols,
+  const lanelet::LaneletMapPtr & map_ptr, s_match & match, s_color_table & cols,
   const lanelet::ConstPoints3d & pts_change_lanes,
   const lanelet::ConstPoints3d & pts_change_shoulder, std::vector<std::string> & val_lanes,
   std::vector<std::string> & val_shoulder, lanelet::ConstLanelets & deleted)
@@ -412,7 +436,7 @@ void cconflation::split_ll_dir(
     lanelet::LineString3d right = orig.rightBound();
     lanelet::LineString3d new_right;
     split_linestring(right, new_right, splitted, newls, pt, invert);
-    lanelet::Lanelet new_ll(lanelet::utils::getId(), new_left, new_right, orig.attributes());
+    lanelet::Lanelet new_ll(next_id(), new_left, new_right, orig.attributes());
     map_ptr->add(new_ll);
     // Update attribute with id-tag
     match.update_ref_tags(key_ind, orig.id(), new_ll.id(), ind);
@@ -437,7 +461,7 @@ void cconflation::split_linestring(
     lanelet::BasicPoint3d pt_proj = lanelet::geometry::project(orig_ls, pt.basicPoint());
     // Create new point if there is no point on the linestring within a tolerance
     lanelet::Point3d new_pt;
-    new_pt.setId(lanelet::utils::getId());
+    new_pt.setId(next_id());
     std::vector<double> d;
     int ind = 0;
     for (const auto & pt_ls : orig_ls) {
@@ -473,7 +497,7 @@ void cconflation::split_linestring(
       ind = find_segment_2D(new_pt, orig_ls);
     }
     // Create new linestring starting with newPt and attributes from original ls
-    lanelet::LineString3d new_ls_(lanelet::utils::getId(), {new_pt}, orig_ls.attributes());
+    lanelet::LineString3d new_ls_(next_id(), {new_pt}, orig_ls.attributes());
     // Add points behind the index to newls
     new_ls_.insert(new_ls_.end(), orig_ls.begin() + ind + 1, orig_ls.end());
     // Erase those points from original ls (complicated since erase not overwritten properly)
@@ -610,19 +634,15 @@ void cconflation::remove_attributes(lanelet::Point3d & pt, const std::vector<std
     }
   }
 }
-
-/*****************************************************************************
- * Check if a lanelet id is already present in the vector with color codes
- ******************************************************************************/
-bool cconflation::used_Id(
-  std::vector<std::pair<lanelet::Id, std::string>> & cols, const lanelet::Lanelet & ll)
+void cconflation::remove_attributes(lanelet::Lanelet & ll, const std::vector<std::string> & names)
 {
-  for (auto & p : cols) {
-    if (p.first == ll.id()) {
-      return true;
+  for (const auto & name : names) {
+    auto & attr = ll.attributes();
+    auto it = attr.find(name);
+    if (it != attr.end()) {
+      attr.erase(it);
     }
   }
-  return false;
 }
 
 /*********************************************
@@ -729,17 +749,13 @@ void cconflation::count_lanes_dir(
  ************************************************************************************/
 void cconflation::set_color_code_dir(
   const std::string & key, const lanelet::LineString3d & seg,
-  const lanelet::LaneletMapPtr & map_ptr, const std::string & col_code,
-  std::vector<std::pair<lanelet::Id, std::string>> & cols)
+  const lanelet::LaneletMapPtr & map_ptr, const std::string & col_code, s_color_table & cols)
 {
   int i = 1;
   std::string key_ind = key + std::to_string(i);
   while (seg.hasAttribute(key_ind)) {
     lanelet::Lanelet ll = find_ll(map_ptr, *seg.attribute(key_ind).asId());
-    if (!used_Id(cols, ll)) {
-      std::pair<lanelet::Id, std::string> p(ll.id(), col_code);
-      cols.push_back(p);
-    }
+    cols.insert(ll.id(), col_code);
     ++i;
     key_ind = key + std::to_string(i);
   }
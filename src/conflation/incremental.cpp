@@ -0,0 +1,297 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "incremental.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**************/
+/*Constructors*/
+/**************/
+
+cincremental::cincremental()
+{
+}
+
+/****************/
+/*public methods*/
+/****************/
+
+/***************************************************************************************
+ * Find the lanelets affected by changed openstreetmap-ways based on the match table
+ * => lanelets matched to a changed/deleted way
+ * => unmatched lanelets within update_margin of a changed way (potential new match)
+ ****************************************************************************************/
+bool cincremental::impacted_region(
+  rclcpp::Node & node, const std::vector<s_match_record> & table, const lanelet::Ids & ways,
+  const lanelet::LineStrings3d & osm, const lanelet::LaneletMapPtr & map_ptr,
+  lanelet::Lanelets & region)
+{
+  if (!map_ptr) {
+    std::cerr << "\033[1;31m" << __FUNCTION__ << ": No map received!\033[0m" << std::endl;
+    return false;
+  }
+  const double margin = node.get_parameter("update_margin").as_double();
+  const std::unordered_set<lanelet::Id> way_set(ways.begin(), ways.end());
+
+  // Extent of changed ways that are still part of the road network (deleted ways have no
+  // geometry anymore and are only found via the match table)
+  std::vector<Eigen::AlignedBox2d> boxes;
+  for (const auto & ls : osm) {
+    if (way_set.count(ls.id())) {
+      Eigen::AlignedBox2d box = bbox(ls);
+      box.extend(box.min() - Eigen::Vector2d(margin, margin));
+      box.extend(box.max() + Eigen::Vector2d(margin, margin));
+      boxes.push_back(box);
+    }
+  }
+
+  // Collect lanelets of impacted entries (in order of the table)
+  lanelet::Ids ids;
+  for (const auto & rec : table) {
+    bool impacted = std::any_of(rec.osm_ids.begin(), rec.osm_ids.end(), [&](const auto & id) {
+      return way_set.count(id) > 0;
+    });
+    if (!impacted && rec.osm_ids.empty()) {
+      for (const auto & id : rec.ll_ids) {
+        if (!map_ptr->laneletLayer.exists(id)) {
+          continue;
+        }
+        const Eigen::AlignedBox2d box = bbox(map_ptr->laneletLayer.get(id));
+        if (std::any_of(boxes.begin(), boxes.end(), [&](const auto & b) {
+              return b.intersects(box);
+            })) {
+          impacted = true;
+          break;
+        }
+      }
+    }
+    if (impacted) {
+      for (const auto & id : rec.ll_ids) {
+        add_unique(ids, id);
+      }
+    }
+  }
+  // Lanelets that were deleted in the previous run are no longer part of the map
+  for (const auto & id : ids) {
+    if (map_ptr->laneletLayer.exists(id)) {
+      region.push_back(map_ptr->laneletLayer.get(id));
+    }
+  }
+  std::cout << "\033[33m~~~~~> " << ways.size() << " changed ways affect " << region.size()
+            << " of " << map_ptr->laneletLayer.size() << " lanelets!\033[0m" << std::endl;
+  return true;
+}
+
+/**************************************************************************************
+ * Find the lanelets inside the corridor of a new trajectory (corridor_width to each
+ * side) and complete their street cross-sections based on the match table
+ ***************************************************************************************/
+bool cincremental::corridor_region(
+  rclcpp::Node & node, const lanelet::ConstLineString3d & traj,
+  const std::vector<s_match_record> & table, const lanelet::LaneletMapPtr & map_ptr,
+  lanelet::Lanelets & region)
+{
+  if (!map_ptr || traj.empty()) {
+    std::cerr << "\033[1;31m" << __FUNCTION__ << ": No map or trajectory received!\033[0m"
+              << std::endl;
+    return false;
+  }
+  const double width = node.get_parameter("corridor_width").as_double();
+
+  // Approximate corridor by bounding boxes of short pieces of the trajectory
+  // (consecutive pieces share their end point)
+  const size_t piece = 10;
+  std::vector<Eigen::AlignedBox2d> boxes;
+  for (size_t i = 0; i < traj.size(); i += piece) {
+    Eigen::AlignedBox2d box;
+    for (size_t j = i; j < std::min(i + piece + 1, traj.size()); ++j) {
+      box.extend(Eigen::Vector2d(traj[j].x(), traj[j].y()));
+    }
+    box.extend(box.min() - Eigen::Vector2d(width, width));
+    box.extend(box.max() + Eigen::Vector2d(width, width));
+    boxes.push_back(box);
+  }
+
+  // Lanelets inside corridor (includes lanelets that are not in the match table so far)
+  std::unordered_set<lanelet::Id> inside;
+  lanelet::Ids ids;
+  for (const auto & ll : map_ptr->laneletLayer) {
+    const Eigen::AlignedBox2d box = bbox(ll);
+    if (std::any_of(
+          boxes.begin(), boxes.end(), [&](const auto & b) { return b.intersects(box); })) {
+      inside.insert(ll.id());
+      ids.push_back(ll.id());
+    }
+  }
+
+  // Complete street cross-sections with the lanelets of the same reference polyline
+  std::unordered_set<lanelet::Id> added(inside);
+  for (const auto & rec : table) {
+    if (std::any_of(rec.ll_ids.begin(), rec.ll_ids.end(), [&](const auto & id) {
+          return inside.count(id) > 0;
+        })) {
+      for (const auto & id : rec.ll_ids) {
+        if (added.insert(id).second) {
+          ids.push_back(id);
+        }
+      }
+    }
+  }
+  for (const auto & id : ids) {
+    if (map_ptr->laneletLayer.exists(id)) {
+      region.push_back(map_ptr->laneletLayer.get(id));
+    }
+  }
+  std::cout << "\033[33m~~~~~> Trajectory corridor contains " << region.size() << " of "
+            << map_ptr->laneletLayer.size() << " lanelets!\033[0m" << std::endl;
+  return true;
+}
+
+/*****************************************************************************************
+ * Collapse and match a region of the lanelet map against the openstreetmap-linestrings
+ * surrounding the region (bounding box extended by update_margin)
+ ******************************************************************************************/
+bool cincremental::rematch_region(
+  rclcpp::Node & node, const lanelet::Lanelets & region, const lanelet::LineStrings3d & osm,
+  lanelet::LineStrings3d & ll_coll, std::vector<s_match> & matches)
+{
+  if (region.empty()) {
+    return true;
+  }
+  const double margin = node.get_parameter("update_margin").as_double();
+
+  // Extent of region
+  Eigen::AlignedBox2d ext;
+  for (const auto & ll : region) {
+    ext.extend(bbox(ll));
+  }
+  ext.extend(ext.min() - Eigen::Vector2d(margin, margin));
+  ext.extend(ext.max() + Eigen::Vector2d(margin, margin));
+
+  // Openstreetmap-linestrings in the surrounding of the region
+  lanelet::LineStrings3d osm_region;
+  for (const auto & ls : osm) {
+    if (ext.intersects(bbox(ls))) {
+      osm_region.push_back(ls);
+    }
+  }
+
+  cmatching matching;
+  matching.set_progress(this->progress);
+  if (!matching.collapse_ll_map(region, ll_coll)) {
+    return false;
+  }
+  return matching.buffer_growing(node, ll_coll, osm_region, matches);
+}
+
+/*********************************************************************
+ * Create match table entries from the reference polylines of matches
+ **********************************************************************/
+std::vector<s_match_record> cincremental::match_records(const std::vector<s_match> & matches)
+{
+  std::vector<s_match_record> table;
+  for (const auto & match : matches) {
+    s_match_record rec;
+    for (const auto & seg : match.ref_pline()) {
+      for (const auto & att : seg.attributes()) {
+        if (
+          att.first.find("ll_id_forward_") != std::string::npos ||
+          att.first.find("ll_id_backward_") != std::string::npos) {
+          add_unique(rec.ll_ids, *att.second.asId());
+        }
+      }
+    }
+    for (const auto & id : match.target_ids()) {
+      add_unique(rec.osm_ids, id);
+    }
+    if (!rec.ll_ids.empty()) {
+      table.push_back(rec);
+    }
+  }
+  return table;
+}
+
+/***************************************************************************
+ * Replace entries of the match table that contain lanelets of the region
+ * with the entries of the new matches
+ ****************************************************************************/
+void cincremental::update_table(
+  std::vector<s_match_record> & table, const lanelet::Lanelets & region,
+  const std::vector<s_match> & matches)
+{
+  std::unordered_set<lanelet::Id> ids;
+  for (const auto & ll : region) {
+    ids.insert(ll.id());
+  }
+  table.erase(
+    std::remove_if(
+      table.begin(), table.end(),
+      [&](const auto & rec) {
+        return std::any_of(rec.ll_ids.begin(), rec.ll_ids.end(), [&](const auto & id) {
+          return ids.count(id) > 0;
+        });
+      }),
+    table.end());
+
+  std::vector<s_match_record> records = match_records(matches);
+  table.insert(table.end(), records.begin(), records.end());
+}
+
+/*****************/
+/*private methods*/
+/*****************/
+
+/*****************************************************
+ * Get 2D bounding box of a lanelet or linestring
+ ******************************************************/
+Eigen::AlignedBox2d cincremental::bbox(const lanelet::ConstLanelet & ll)
+{
+  Eigen::AlignedBox2d box;
+  for (const auto & pt : ll.leftBound()) {
+    box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+  }
+  for (const auto & pt : ll.rightBound()) {
+    box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+  }
+  return box;
+}
+Eigen::AlignedBox2d cincremental::bbox(const lanelet::ConstLineString3d & ls)
+{
+  Eigen::AlignedBox2d box;
+  for (const auto & pt : ls) {
+    box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+  }
+  return box;
+}
+
+/**********************************************************
+ * Add an id to a vector if it's not already contained
+ ***********************************************************/
+void cincremental::add_unique(lanelet::Ids & ids, const lanelet::Id & id)
+{
+  if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+    ids.push_back(id);
+  }
+}
@@ -21,9 +21,16 @@
 #include "matching.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -35,6 +42,256 @@ cmatching::cmatching()
 {
 }
 
+/***************/
+/*Segment table*/
+/***************/
+
+size_t s_seg_table::size() const
+{
+  return this->id.size();
+}
+
+/*****************************************************
+ * Add point (if not added yet) and return its index
+ ******************************************************/
+uint32_t s_seg_table::add_point(const lanelet::Point3d & pt)
+{
+  const auto ins = this->pt_ind.emplace(pt.id(), static_cast<uint32_t>(this->pts.size()));
+  if (ins.second) {
+    this->x.push_back(pt.x());
+    this->y.push_back(pt.y());
+    this->z.push_back(pt.z());
+    this->pts.push_back(pt);
+  }
+  return ins.first->second;
+}
+
+/**************************************************************
+ * Add segment between two points of a parent linestring
+ ***************************************************************/
+void s_seg_table::add_segment(
+  const uint32_t p0, const uint32_t p1, const uint32_t parent, const bool attr)
+{
+  this->p0.push_back(p0);
+  this->p1.push_back(p1);
+  this->parent.push_back(parent);
+  this->id.push_back(next_id());
+  this->attr.push_back(attr);
+  this->seg_ind.emplace(this->id.back(), static_cast<uint32_t>(this->id.size() - 1));
+}
+
+/***************************************************************************
+ * Id of the parent linestring of a segment by the segment id
+ * => lanelet::InvalId if the segment is not contained in the table
+ ****************************************************************************/
+lanelet::Id s_seg_table::parent_id(const lanelet::Id seg_id) const
+{
+  const auto it = this->seg_ind.find(seg_id);
+  return (it == this->seg_ind.end()) ? lanelet::InvalId
+                                     : this->parents[this->parent[it->second]].id();
+}
+
+/*******************************
+ * 2D-coordinates of a point
+ ********************************/
+lanelet::BasicPoint2d s_seg_table::pt2d(const uint32_t p) const
+{
+  return lanelet::BasicPoint2d(this->x[p], this->y[p]);
+}
+
+/*******************************************************************
+ * Set float32 coordinates of all points relative to a local origin
+ * => accurate to millimetres within a tile
+ ********************************************************************/
+void s_seg_table::localize(const Eigen::Vector2d & origin)
+{
+  this->origin = origin;
+  this->xf.resize(this->x.size());
+  this->yf.resize(this->y.size());
+  for (size_t p = 0; p < this->x.size(); ++p) {
+    this->xf[p] = static_cast<float>(this->x[p] - origin.x());
+    this->yf[p] = static_cast<float>(this->y[p] - origin.y());
+  }
+}
+
+/********************************************************
+ * Local float32 2D-coordinates of a point (see localize)
+ *********************************************************/
+Eigen::Vector2f s_seg_table::pt2f(const uint32_t p) const
+{
+  return Eigen::Vector2f(this->xf[p], this->yf[p]);
+}
+
+/**********************************************************************************
+ * Create segment as linestring
+ * => attributes copied from the parent linestring (if not created for connection)
+ ***********************************************************************************/
+lanelet::LineString3d s_seg_table::segment(const size_t i) const
+{
+  const lanelet::LineString3d & par = this->parents[this->parent[i]];
+  lanelet::LineString3d ls(this->id[i], {this->pts[this->p0[i]], this->pts[this->p1[i]]});
+  if (this->attr[i]) {
+    ls.attributes() = par.attributes();
+  }
+  return ls;
+}
+
+/*******************************
+ * Direction of a segment [rad]
+ ********************************/
+double s_seg_table::heading(const size_t i) const
+{
+  return std::atan2(
+    this->y[this->p1[i]] - this->y[this->p0[i]], this->x[this->p1[i]] - this->x[this->p0[i]]);
+}
+
+/*************************************************************************************
+ * Build point -> segment adjacency as compressed rows (segments of point p are
+ * pt_seg[pt_seg_off[p]] ... pt_seg[pt_seg_off[p + 1] - 1] in ascending order)
+ **************************************************************************************/
+void s_seg_table::index_points()
+{
+  this->pt_seg_off.assign(this->pts.size() + 1, 0);
+  for (size_t i = 0; i < this->size(); ++i) {
+    ++this->pt_seg_off[this->p0[i] + 1];
+    if (this->p1[i] != this->p0[i]) {
+      ++this->pt_seg_off[this->p1[i] + 1];
+    }
+  }
+  for (size_t p = 0; p < this->pts.size(); ++p) {
+    this->pt_seg_off[p + 1] += this->pt_seg_off[p];
+  }
+  this->pt_seg.resize(this->pt_seg_off.back());
+  std::vector<uint32_t> fill(this->pt_seg_off.begin(), this->pt_seg_off.end() - 1);
+  for (size_t i = 0; i < this->size(); ++i) {
+    this->pt_seg[fill[this->p0[i]]++] = static_cast<uint32_t>(i);
+    if (this->p1[i] != this->p0[i]) {
+      this->pt_seg[fill[this->p1[i]]++] = static_cast<uint32_t>(i);
+    }
+  }
+}
+
+/**************************************************************************************
+ * Build heading-binned spatial index of the segments (bins = 0: no index)
+ * => segments registered in all cells their bounding box overlaps with the bins of both
+ *    orientations (openstreetmap-ways are undirected)
+ ***************************************************************************************/
+void s_seg_table::index_headings(const double cell, const size_t bins)
+{
+  this->cell = std::max(cell, 1.0);
+  this->bins = bins;
+  this->index.clear();
+  if (bins == 0) {
+    return;
+  }
+  const double pi = std::atan(1.0) * 4;
+  for (size_t i = 0; i < this->size(); ++i) {
+    const double h = heading(i);
+    const size_t b0 = heading_bin(h);
+    const size_t b1 = heading_bin(h + pi);
+    const uint32_t p0 = this->p0[i];
+    const uint32_t p1 = this->p1[i];
+    const int64_t x1 = cell_ind(std::max(this->x[p0], this->x[p1]));
+    const int64_t y1 = cell_ind(std::max(this->y[p0], this->y[p1]));
+    for (int64_t ix = cell_ind(std::min(this->x[p0], this->x[p1])); ix <= x1; ++ix) {
+      for (int64_t iy = cell_ind(std::min(this->y[p0], this->y[p1])); iy <= y1; ++iy) {
+        this->index[index_key(ix, iy, b0)].push_back(static_cast<uint32_t>(i));
+        if (b1 != b0) {
+          this->index[index_key(ix, iy, b1)].push_back(static_cast<uint32_t>(i));
+        }
+      }
+    }
+  }
+}
+
+/**********************************
+ * Cell of a coordinate in the index
+ ***********************************/
+int64_t s_seg_table::cell_ind(const double v) const
+{
+  return static_cast<int64_t>(std::floor(v / this->cell));
+}
+
+/*********************************************
+ * Heading bin of a direction [rad] in the index
+ **********************************************/
+size_t s_seg_table::heading_bin(const double heading) const
+{
+  const double pi = std::atan(1.0) * 4;
+  const double h = std::remainder(heading, 2 * pi) + pi;  // [0, 2pi]
+  return std::min(static_cast<size_t>(h / (2 * pi) * this->bins), this->bins - 1);
+}
+
+/**************************************************************************
+ * Key of a cell and heading bin in the index
+ * => collisions of distant cells only add segments (checked exactly anyway)
+ ***************************************************************************/
+int64_t s_seg_table::index_key(const int64_t ix, const int64_t iy, const size_t bin) const
+{
+  const uint64_t key = (static_cast<uint64_t>(ix) << 36) ^
+                       ((static_cast<uint64_t>(iy) & 0xfffffff) << 8) ^ (bin & 0xff);
+  return static_cast<int64_t>(key);
+}
+
+/************/
+/*Table view*/
+/************/
+
+s_seg_view::s_seg_view(const s_seg_table & table) : t(table), lss(table.size())
+{
+}
+
+size_t s_seg_view::size() const
+{
+  return this->t.size();
+}
+
+/************************************************************************
+ * Segment as linestring (created once per matching, afterwards shared)
+ *************************************************************************/
+lanelet::LineString3d s_seg_view::segment(const size_t i)
+{
+  if (!this->lss[i]) {
+    this->lss[i] = this->t.segment(i);
+  }
+  return *this->lss[i];
+}
+
+/*****************/
+/*Scoring profile*/
+/*****************/
+
+/*************************************************************
+ * Scoring profile from the parameter file (all measures)
+ **************************************************************/
+s_param_scoring::s_param_scoring(rclcpp::Node & node)
+{
+  this->p.use_angle = true;
+  this->p.use_length = true;
+  this->p.use_chord = true;
+  this->p.use_poly = true;
+  this->p.use_frechet = node.get_parameter("use_frechet").as_bool();
+  this->p.lim_angle = node.get_parameter("lim_angle").as_double();
+  this->p.lim_length = node.get_parameter("lim_length").as_double();
+  this->p.lim_chord = node.get_parameter("lim_chord").as_double();
+  this->p.lim_poly = node.get_parameter("lim_poly").as_double();
+  this->p.lim_frechet = node.get_parameter("lim_frechet").as_double();
+  this->p.w_angle = node.get_parameter("w_angle").as_double();
+  this->p.w_len = node.get_parameter("w_length").as_double();
+  this->p.w_chord = node.get_parameter("w_chord").as_double();
+  this->p.w_poly = node.get_parameter("w_poly").as_double();
+  this->p.w_frechet = node.get_parameter("w_frechet").as_double();
+}
+
+s_param_scoring::s_param_scoring(const s_score_profile & profile) : p(profile)
+{
+}
+
+const s_score_profile & s_param_scoring::profile() const
+{
+  return this->p;
+}
+
 /****************/
 /*public methods*/
 /****************/
@@ -47,12 +304,23 @@ bool cmatching::collapse_ll_map(
   const lanelet::LaneletMapPtr & map_ptr, lanelet::LineStrings3d & ls_col)
 {
   // Get lanelets of map
-  const lanelet::Lanelets lls = lanelet_layer(map_ptr);
+  return collapse_ll_map(lanelet_layer(map_ptr), ls_col);
+}
+
+/************************************************************************
+ * Collapse a subset of lanelets (e.g. a spatial tile of the map)
+ *************************************************************************/
+bool cmatching::collapse_ll_map(const lanelet::Lanelets & lls, lanelet::LineStrings3d & ls_col)
+{
   lanelet::Ids ids_coll;
   lanelet::LineStrings3d centerlines;
 
   // Extract centerlines of adjacent lanelets and put them into linestrings
   for (const auto & ll : lls) {
+    if (cancelled()) {
+      std::cout << "\033[33m~~~~~> Collapsing cancelled!\033[0m" << std::endl;
+      return false;
+    }
     if (!used_Id(ids_coll, ll)) {
       ids_coll.push_back(ll.id());
       lanelet::LineString3d center = get_centerline(lls, ids_coll, ll);
@@ -80,20 +348,207 @@ bool cmatching::collapse_ll_map(
  ******************************************************************************************/
 bool cmatching::buffer_growing(
   rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+  std::vector<s_match> & matches, const bool verbose)
+{
+  const std::string hierarchy = node.get_parameter("match_hierarchy").as_string();
+  this->eval_stats = s_eval_stats();
+  if (hierarchy == "compare") {
+    // Apply flat and coarse-to-fine algorithm => compare runtime and results
+    // (matches of coarse-to-fine algorithm are returned)
+    std::vector<s_match> matches_flat;
+    const auto t0 = std::chrono::steady_clock::now();
+    if (!flat_matching(node, src, target, matches_flat)) {
+      return false;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    const s_eval_stats eval_flat = this->eval_stats;
+    this->eval_stats = s_eval_stats();
+    if (!coarse_to_fine(node, src, target, matches)) {
+      return false;
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+    if (verbose) {
+      std::cout << "\033[33m~~~~~> Flat matching: "
+                << std::chrono::duration<double>(t1 - t0).count() << " s\033[0m" << std::endl;
+      print_stats(node, matches_flat);
+      print_eval_stats(eval_flat);
+      std::cout << "\033[33m~~~~~> Coarse-to-fine matching: "
+                << std::chrono::duration<double>(t2 - t1).count() << " s\033[0m" << std::endl;
+      print_stats(node, matches);
+      print_eval_stats(this->eval_stats);
+      size_t same = 0;
+      for (size_t i = 0; i < std::min(matches.size(), matches_flat.size()); ++i) {
+        same += same_target(matches[i], matches_flat[i]) ? 1 : 0;
+      }
+      std::cout << "\033[33m~~~~~> Reference polylines with the same match: " << same << "/"
+                << matches_flat.size() << "\033[0m" << std::endl;
+      // Work of the coarse-to-fine algorithm (both levels) relative to the flat algorithm
+      auto ratio = [](const size_t a, const size_t b) {
+        return (b > 0) ? 100.0 * static_cast<double>(a) / static_cast<double>(b) : 0.0;
+      };
+      std::cout << "\033[33m~~~~~> Work of coarse-to-fine vs. flat matching: "
+                << ratio(this->eval_stats.segments, eval_flat.segments)
+                << " % tested target segments, "
+                << ratio(this->eval_stats.candidates, eval_flat.candidates)
+                << " % evaluated candidates, "
+                << ratio(this->eval_stats.measures, eval_flat.measures)
+                << " % calculated measures\033[0m" << std::endl;
+    }
+    return true;
+  } else if (hierarchy != "flat" && hierarchy != "coarse_to_fine") {
+    std::cerr << "\033[1;31m!! Unknown match_hierarchy " << hierarchy
+              << " => using flat algorithm !!\033[0m" << std::endl;
+  }
+
+  const bool bG = (hierarchy == "coarse_to_fine") ? coarse_to_fine(node, src, target, matches)
+                                                  : flat_matching(node, src, target, matches);
+  if (bG && verbose) {
+    print_stats(node, matches);
+    print_eval_stats(this->eval_stats);
+  }
+  return bG;
+}
+
+/****************************************************************************************
+ * Split vector of linestrings with plines into vector of segments (copy attributes)
+ * => independent of buffer and scoring parameters (can be shared by multiple matchings)
+ *****************************************************************************************/
+s_seg_table cmatching::split_lss(rclcpp::Node & node, lanelet::LineStrings3d & lss)
+{
+  return split_lss(lss, node.get_parameter("seg_len").as_double());
+}
+
+s_seg_table cmatching::split_lss(const lanelet::LineStrings3d & lss, const double seg_len)
+{
+  s_seg_table lss_split;
+  lss_split.parents = lss;
+  for (uint32_t k = 0; k < lss.size(); ++k) {
+    const lanelet::LineString3d & ls = lss[k];
+    for (size_t j = 0; j + 1 < ls.size(); ++j) {
+      // Only keep attributes, if segments does not contain a point that is only created
+      // for connection reasons (see preprocessing step)
+      const bool attr = !ls[j].hasAttribute("connection") && !ls[j + 1].hasAttribute("connection");
+      const uint32_t p0 = lss_split.add_point(ls[j]);
+      uint32_t p1 = lss_split.add_point(ls[j + 1]);
+      // Further split segment if it is too long
+      Eigen::Vector3d pt0(lss_split.x[p0], lss_split.y[p0], lss_split.z[p0]);
+      Eigen::Vector3d pt1(lss_split.x[p1], lss_split.y[p1], lss_split.z[p1]);
+      while ((pt1 - pt0).norm() > seg_len) {
+        double len = (pt1 - pt0).norm();
+        // Create new interpolated point
+        const Eigen::Vector3d pt_inter = pt0 + (pt1 - pt0) * ((len - seg_len) / len);
+        lanelet::Point3d pt__inter(next_id(), pt_inter.x(), pt_inter.y(), pt_inter.z());
+        const uint32_t p_inter = lss_split.add_point(pt__inter);
+
+        // Create new segment with len specified by "seg_len" and update original segment
+        lss_split.add_segment(p_inter, p1, k, true);
+        p1 = p_inter;
+        pt1 = pt_inter;
+      }
+      lss_split.add_segment(p0, p1, k, attr);
+    }
+  }
+  lss_split.index_points();
+  return lss_split;
+}
+
+/****************************************************************************************
+ * Split linestrings of the target dataset into segments (see split_lss) and set their
+ * float32 coordinates relative to the center of the segments (if selected)
+ *****************************************************************************************/
+s_seg_table cmatching::split_target(rclcpp::Node & node, lanelet::LineStrings3d & target)
+{
+  s_seg_table target_seg = split_lss(node, target);
+  prepare_target(node, target_seg);
+  return target_seg;
+}
+
+/*****************************************************************************************
+ * Reuse the split and indexed target dataset of previous matchings (e.g. of a cached
+ * openstreetmap-excerpt, see split_target)
+ * => empty table is filled by the next matching, nullptr: split target for every matching
+ ******************************************************************************************/
+void cmatching::set_target_cache(const std::shared_ptr<s_seg_table> & cache)
+{
+  this->target_cache = cache;
+}
+
+/*****************************************************************************************
+ * Apply buffer-growing map-matching-algorithm on segment tables with the given buffer
+ * parameters and scoring profile
+ * => tables are only read (matchings with multiple parameter sets may run in parallel)
+ ******************************************************************************************/
+bool cmatching::match_segments(
+  rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+  const s_buffer_params & buffer, const s_score_profile & profile,
   std::vector<s_match> & matches)
+{
+  return match_segments(node, src_seg, target_seg, buffer, matches, s_param_scoring(profile));
+}
+
+/*****************************************************************************************
+ * Apply buffer-growing map-matching-algorithm on segment tables with the given buffer
+ * parameters and a scoring profile by name (see match_profile)
+ ******************************************************************************************/
+bool cmatching::match_segments(
+  rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+  const s_buffer_params & buffer, const std::string & profile, std::vector<s_match> & matches)
+{
+  if (profile == "motorway") {
+    return match_segments(
+      node, src_seg, target_seg, buffer, matches, s_fixed_scoring<profile_motorway>());
+  } else if (profile == "urban") {
+    return match_segments(
+      node, src_seg, target_seg, buffer, matches, s_fixed_scoring<profile_urban>());
+  } else if (profile != "param") {
+    std::cerr << "\033[1;31m!! Unknown match_profile " << profile
+              << " => using the parameter file !!\033[0m" << std::endl;
+  }
+  return match_segments(node, src_seg, target_seg, buffer, matches, s_param_scoring(node));
+}
+
+/*****************************************************************************************
+ * Apply buffer-growing map-matching-algorithm on segment tables with the given scoring
+ * policy
+ ******************************************************************************************/
+template <typename ScoringT>
+bool cmatching::match_segments(
+  rclcpp::Node & node, const s_seg_table & src_seg, const s_seg_table & target_seg,
+  const s_buffer_params & buffer, std::vector<s_match> & matches, const ScoringT & scoring)
 {
   // Initialize vector of ids to track linestrings that were already used
   lanelet::Ids ids;
 
-  // Split linestrings of source and target dataset into segments (keeping attributes)
-  lanelet::LineStrings3d src_seg = split_lss(node, src);
-  lanelet::LineStrings3d target_seg = split_lss(node, target);
+  // Segments materialized by this matching only
+  s_seg_view src_view(src_seg);
+  s_seg_view target_view(target_seg);
+
+  // Float32 geometry if the target segments were localized (see split_target)
+  this->float_geometry = !target_seg.xf.empty();
+  this->origin = target_seg.origin;
+  this->heading_filter = node.get_parameter("heading_filter").as_bool();
+  this->heading_tol = node.get_parameter("heading_tolerance").as_double() * std::atan(1.0) * 4 /
+                      180.0;
+  this->frechet_band =
+    static_cast<size_t>(std::max<int64_t>(node.get_parameter("frechet_band").as_int(), 0));
 
   // Apply algorithm (starting from an unused linestring segment)
-  for (const auto & ls : src_seg) {
-    if (!used_Id(ids, ls)) {
+  size_t n = 0;
+  for (size_t i = 0; i < src_seg.size(); ++i) {
+    // Check for cancellation and report progress
+    ++n;
+    if (cancelled()) {
+      std::cout << "\033[33m~~~~~> Matching cancelled!\033[0m" << std::endl;
+      return false;
+    }
+    if (n % 200 == 0) {
+      update("buffer_growing", static_cast<double>(n) / src_seg.size());
+    }
+    if (!used_Id(ids, src_seg.id[i])) {
+      // Release scratch data of the previous reference polyline
+      this->arena.reset();
       // Instantiate new reference polyline
-      lanelet::LineStrings3d pline = init_pline(node, ls, src_seg, ids);
+      lanelet::LineStrings3d pline = init_pline(node, src_view.segment(i), src_view, ids);
       // Update tags with lanelets if linestring segment was inverted during pline generation
       for (auto & ls : pline) {
         if (ls.inverted()) {
@@ -102,27 +557,56 @@ bool cmatching::buffer_growing(
       }
       // std::cout << pline.size() << std::endl;
 
-      // Get initial buffer parameters as set in parameter file
-      double buffer_V = node.get_parameter("buffer_V").as_double();
-      double buffer_P = node.get_parameter("buffer_P").as_double();
-      double buffer_rad = node.get_parameter("buffer_rad").as_double();
+      // Coarse matches of the reference polyline (coarse-to-fine) => no search without
+      bool search = true;
+      if (this->corridors) {
+        this->pline_corridors.clear();
+        for (const auto & ls : pline) {
+          const auto it = this->corridors->src.find(src_seg.parent_id(ls.id()));
+          if (it != this->corridors->src.end()) {
+            this->pline_corridors.insert(
+              this->pline_corridors.end(), it->second.begin(), it->second.end());
+          }
+        }
+        std::sort(this->pline_corridors.begin(), this->pline_corridors.end());
+        this->pline_corridors.erase(
+          std::unique(this->pline_corridors.begin(), this->pline_corridors.end()),
+          this->pline_corridors.end());
+        search = !this->pline_corridors.empty();
+      }
+      ++(search ? this->eval_stats.plines : this->eval_stats.outside);
+
+      // Start with the initial buffer parameters
+      double buffer_V = buffer.V;
+      double buffer_P = buffer.P;
+      double buffer_rad = buffer.rad;
+      double buf_V = buffer_V;
+      double buf_P = buffer_P;
+      double buf_rad = buffer_rad;
       int j = 0;
       // Initialize variables
-      lanelet::Areas buf;
-      std::vector<lanelet::LineStrings3d> candidates;
+      scratch_points buf(this->arena.get());
+      scratch_plines candidates(this->arena.get());
+      bool found = false;
+      size_t ind = 0;
+      s_measures matched_measures;
       lanelet::LineStrings3d matched_candidate;
 
       /***********************************************************************************
        * Find possible matching candidates by iteratively increasing the buffer parameters
        * if no candidates were found
        ************************************************************************************/
-      while (candidates.empty() && j < 3) {
+      while (search && !found && j < 3) {
         // Initialize buffers around reference polyline segments
-        buf = create_buffer(pline, buffer_V, buffer_P, buffer_rad);
+        buf.clear();
+        buffer_polygons(pline, buffer_V, buffer_P, buffer_rad, buf);
+        buf_V = buffer_V;
+        buf_P = buffer_P;
+        buf_rad = buffer_rad;
         // Find alle matching candidates inside buffer
-        candidates = matching_candidates(pline, buf, target_seg);
-        // Exclude candidates that exceed geometric limits
-        candidates = exclude_candidates(node, pline, candidates);
+        candidates = matching_candidates(pline, buf, target_view);
+        // Select best candidate within the geometric limits
+        found = select_candidate(pline, candidates, ind, matched_measures, scoring);
 
         // Increase buffer parameters (only to be used if candidates are empty)
         buffer_V *= 1.5;
@@ -132,20 +616,34 @@ bool cmatching::buffer_growing(
       }
 
       /******************************************************************************
-       * Set candidate as matched candidate if only one candidate was found OR
-       * select best candidate by a geometric similarity score if multiple candidates
+       * Set best candidate within the geometric limits as matched candidate
        *******************************************************************************/
       // std::cout << "Size " << candidates.size() << std::endl;
 
-      if (candidates.size() == 1) {
-        matched_candidate = candidates.front();
-      } else if (candidates.size() > 1) {
-        matched_candidate = select_candidate(node, pline, candidates);
+      if (found) {
+        matched_candidate.assign(candidates[ind].begin(), candidates[ind].end());
+      }
+      matches.push_back(s_match(pline, matched_candidate, buf_V, buf_P, buf_rad));
+      // Original linestrings (e.g. openstreetmap-ways) of the match for the match table
+      lanelet::Ids target_ids;
+      for (const auto & ls : matched_candidate) {
+        const lanelet::Id id = target_seg.parent_id(ls.id());
+        if (std::find(target_ids.begin(), target_ids.end(), id) == target_ids.end()) {
+          target_ids.push_back(id);
+        }
       }
-      matches.push_back(s_match(pline, matched_candidate, buf));
-      calc_geo_measures(node, matches.back());
+      matches.back().set_target_ids(target_ids);
+      calc_geo_measures(matches.back(), matched_measures, scoring);
     }
   }
+  return true;
+}
+
+/*****************************************************
+ * Output matching statistics to the command window
+ ******************************************************/
+void cmatching::print_stats(rclcpp::Node & node, const std::vector<s_match> & matches)
+{
   std::vector<double> stats = matching_stats(node, matches);
   std::cout.precision(10);
   std::cout << "\033[33m~~~~~> Matching statistics:\033[0m" << std::endl;
@@ -166,13 +664,269 @@ bool cmatching::buffer_growing(
             << std::endl;
   std::cout << "\033[34m~~~~~~~~~~> Mean score of matches: " << stats[7] << "\033[0m" << std::endl;
   std::cout << "\033[34m~~~~~~~~~~> Matching precision: " << stats[8] << "\033[0m" << std::endl;
-  return true;
+  std::cout << "\033[34m~~~~~~~~~~> Mean Frechet distance of matches: " << stats[9] << "\033[0m"
+            << std::endl;
+}
+
+/*****************************************************************
+ * Output evaluations of candidate measures to the command window
+ ******************************************************************/
+void cmatching::print_eval_stats(const s_eval_stats & eval)
+{
+  std::cout << "\033[33m~~~~~> Candidate evaluations:\033[0m" << std::endl;
+  std::cout << "\033[34m~~~~~~~~~~> Searched reference polylines: " << eval.plines << "\033[0m"
+            << std::endl;
+  if (eval.outside > 0) {
+    std::cout << "\033[34m~~~~~~~~~~> Reference polylines without coarse match: " << eval.outside
+              << "\033[0m" << std::endl;
+  }
+  std::cout << "\033[34m~~~~~~~~~~> Target segments tested against buffers: " << eval.segments
+            << "\033[0m" << std::endl;
+  std::cout << "\033[34m~~~~~~~~~~> Evaluated candidates: " << eval.candidates << "\033[0m"
+            << std::endl;
+  std::cout << "\033[34m~~~~~~~~~~> Candidates rejected by limits: " << eval.rejected
+            << "\033[0m" << std::endl;
+  std::cout << "\033[34m~~~~~~~~~~> Candidates pruned by score bound: " << eval.pruned
+            << "\033[0m" << std::endl;
+  std::cout << "\033[34m~~~~~~~~~~> Calculated/skipped measures: " << eval.measures << "/"
+            << eval.skipped << "\033[0m" << std::endl;
 }
 
 /*****************/
 /*private methods*/
 /*****************/
 
+/*****************************************************************************************
+ * Apply buffer-growing map-matching-algorithm at full resolution (seg_len)
+ ******************************************************************************************/
+bool cmatching::flat_matching(
+  rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+  std::vector<s_match> & matches)
+{
+  // Split linestrings of source and target dataset into segments (keeping attributes)
+  const s_seg_table src_seg = split_lss(node, src);
+  const std::shared_ptr<const s_seg_table> target_seg = target_table(node, target);
+
+  // Get initial buffer parameters as set in parameter file
+  const s_buffer_params buffer{
+    node.get_parameter("buffer_V").as_double(), node.get_parameter("buffer_P").as_double(),
+    node.get_parameter("buffer_rad").as_double()};
+
+  // Score match candidates with a fixed profile or the profile of the parameter file
+  const std::string profile = node.get_parameter("match_profile").as_string();
+  return match_segments(node, src_seg, *target_seg, buffer, profile, matches);
+}
+
+/*****************************************************************************************
+ * Apply buffer-growing map-matching-algorithm coarse-to-fine
+ * => match Douglas-Peucker-simplified linestrings with coarse buffers first
+ * => full resolution matching of a reference polyline only on target segments inside the
+ *    corridors of the coarse matches of its source linestrings (no search without)
+ ******************************************************************************************/
+bool cmatching::coarse_to_fine(
+  rclcpp::Node & node, lanelet::LineStrings3d & src, lanelet::LineStrings3d & target,
+  std::vector<s_match> & matches)
+{
+  const double tol = node.get_parameter("coarse_tolerance").as_double();
+  const double seg_len = node.get_parameter("coarse_seg_len").as_double();
+  const double scale = node.get_parameter("coarse_buffer_scale").as_double();
+  const double corridor = node.get_parameter("coarse_corridor").as_double();
+  const std::string profile = node.get_parameter("match_profile").as_string();
+  const s_buffer_params buffer{
+    node.get_parameter("buffer_V").as_double(), node.get_parameter("buffer_P").as_double(),
+    node.get_parameter("buffer_rad").as_double()};
+
+  // Coarse level => few long segments of the simplified linestrings, enlarged buffers
+  const s_seg_table src_coarse = split_lss(simplify_lss(src, tol), seg_len);
+  s_seg_table target_coarse = split_lss(simplify_lss(target, tol), seg_len);
+  prepare_target(node, target_coarse);
+  std::vector<s_match> matches_coarse;
+  const s_buffer_params buffer_coarse{scale * buffer.V, scale * buffer.P, scale * buffer.rad};
+  if (!match_segments(node, src_coarse, target_coarse, buffer_coarse, profile, matches_coarse)) {
+    return false;
+  }
+
+  // Coarse matches of every source linestring (linestring ids kept by the simplification)
+  s_corridors corr;
+  for (uint32_t m = 0; m < matches_coarse.size(); ++m) {
+    if (matches_coarse[m].target_pline().empty()) {
+      continue;
+    }
+    for (const auto & ls : matches_coarse[m].ref_pline()) {
+      std::vector<uint32_t> & ms = corr.src[src_coarse.parent_id(ls.id())];
+      if (ms.empty() || ms.back() != m) {
+        ms.push_back(m);
+      }
+    }
+  }
+
+  // Fine level => full resolution, only target segments inside the corridors
+  // => each reference polyline only searches the corridors of its own coarse matches
+  const s_seg_table src_seg = split_lss(node, src);
+  const s_seg_table target_seg =
+    corridor_segments(*target_table(node, target), matches_coarse, corridor, corr.target);
+  this->corridors = &corr;
+  const bool bG = match_segments(node, src_seg, target_seg, buffer, profile, matches);
+  this->corridors = nullptr;
+  return bG;
+}
+
+/*****************************************************************************************
+ * Split and prepare the target dataset (see split_target) or reuse the table of the
+ * target cache (see set_target_cache)
+ ******************************************************************************************/
+std::shared_ptr<const s_seg_table> cmatching::target_table(
+  rclcpp::Node & node, lanelet::LineStrings3d & target)
+{
+  if (!this->target_cache) {
+    return std::make_shared<const s_seg_table>(split_target(node, target));
+  }
+  if (this->target_cache->size() == 0) {
+    *this->target_cache = split_target(node, target);
+  }
+  return this->target_cache;
+}
+
+/*****************************************************************************
+ * Simplify linestrings with Douglas-Peucker (2D)
+ * => original points (ids) and attributes are kept to preserve connectivity
+ ******************************************************************************/
+lanelet::LineStrings3d cmatching::simplify_lss(
+  const lanelet::LineStrings3d & lss, const double tol)
+{
+  lanelet::LineStrings3d lss_simple;
+  for (const auto & ls : lss) {
+    const std::vector<bool> keep = douglas_peucker(ls, tol);
+    lanelet::Points3d pts;
+    for (size_t i = 0; i < ls.size(); ++i) {
+      if (keep[i]) {
+        pts.push_back(ls[i]);
+      }
+    }
+    lss_simple.push_back(lanelet::LineString3d(ls.id(), pts, ls.attributes()));
+  }
+  return lss_simple;
+}
+
+/*****************************************************************************************
+ * Set float32 coordinates of target segments relative to their center (if selected) and
+ * build their heading-binned spatial index
+ ******************************************************************************************/
+void cmatching::prepare_target(rclcpp::Node & node, s_seg_table & target_seg)
+{
+  const int64_t bins = node.get_parameter("heading_bins").as_int();
+  target_seg.index_headings(
+    node.get_parameter("heading_cell").as_double(),
+    static_cast<size_t>(std::clamp<int64_t>(bins, 0, 256)));
+
+  // Local origin for float32 geometry (center of the target segments, e.g. of a tile)
+  if (node.get_parameter("float_geometry").as_bool() && !target_seg.x.empty()) {
+    const auto [min_x, max_x] = std::minmax_element(target_seg.x.begin(), target_seg.x.end());
+    const auto [min_y, max_y] = std::minmax_element(target_seg.y.begin(), target_seg.y.end());
+    target_seg.localize(Eigen::Vector2d((*min_x + *max_x) / 2.0, (*min_y + *max_y) / 2.0));
+  }
+}
+
+/*****************************************************************************************
+ * Get segments of a table inside the corridors (given width to each side) around the
+ * target polylines of matches
+ * => matches of each kept segment whose corridor contains it in seg_matches
+ ******************************************************************************************/
+s_seg_table cmatching::corridor_segments(
+  const s_seg_table & seg, const std::vector<s_match> & matches, const double corridor,
+  std::vector<std::vector<uint32_t>> & seg_matches)
+{
+  // Hash grid of the matched target segments (cells of corridor size)
+  // => segments registered in all cells their corridor overlaps
+  const double cell = std::max(corridor, 1.0);
+  auto ind = [cell](const double v) { return static_cast<int64_t>(std::floor(v / cell)); };
+  auto key = [](const int64_t ix, const int64_t iy) { return (ix << 32) ^ (iy & 0xffffffff); };
+  std::vector<Eigen::Vector2d> seg_first, seg_second;
+  std::vector<uint32_t> seg_match;
+  std::unordered_map<int64_t, std::vector<size_t>> grid;
+  for (uint32_t m = 0; m < matches.size(); ++m) {
+    for (const auto & ls : matches[m].target_pline()) {
+      for (size_t j = 0; j + 1 < ls.size(); ++j) {
+        const Eigen::Vector2d a(ls[j].x(), ls[j].y());
+        const Eigen::Vector2d b(ls[j + 1].x(), ls[j + 1].y());
+        seg_first.push_back(a);
+        seg_second.push_back(b);
+        seg_match.push_back(m);
+        const int64_t x1 = ind(std::max(a.x(), b.x()) + corridor);
+        const int64_t y1 = ind(std::max(a.y(), b.y()) + corridor);
+        for (int64_t ix = ind(std::min(a.x(), b.x()) - corridor); ix <= x1; ++ix) {
+          for (int64_t iy = ind(std::min(a.y(), b.y()) - corridor); iy <= y1; ++iy) {
+            grid[key(ix, iy)].push_back(seg_first.size() - 1);
+          }
+        }
+      }
+    }
+  }
+
+  // Matches whose corridors contain a point (distance to the matched target segments of its
+  // cell, sorted and unique)
+  auto inside = [&](const lanelet::BasicPoint2d & pt, std::vector<uint32_t> & ms) {
+    ms.clear();
+    const auto it = grid.find(key(ind(pt.x()), ind(pt.y())));
+    if (it == grid.end()) {
+      return;
+    }
+    for (const size_t k : it->second) {
+      const Eigen::Vector2d d = seg_second[k] - seg_first[k];
+      const double len2 = d.squaredNorm();
+      const double t =
+        (len2 > 0.0) ? std::clamp((pt - seg_first[k]).dot(d) / len2, 0.0, 1.0) : 0.0;
+      if ((pt - (seg_first[k] + t * d)).norm() <= corridor) {
+        ms.push_back(seg_match[k]);
+      }
+    }
+    std::sort(ms.begin(), ms.end());
+    ms.erase(std::unique(ms.begin(), ms.end()), ms.end());
+  };
+
+  // Keep segments with both points inside the corridors
+  // => segment belongs to the matches of the corridors of both points
+  s_seg_table seg_corr;
+  seg_corr.parents = seg.parents;
+  seg_matches.clear();
+  std::vector<uint32_t> ms0, ms1;
+  for (size_t i = 0; i < seg.size(); ++i) {
+    inside(seg.pt2d(seg.p0[i]), ms0);
+    if (ms0.empty()) {
+      continue;
+    }
+    inside(seg.pt2d(seg.p1[i]), ms1);
+    if (!ms1.empty()) {
+      const uint32_t p0 = seg_corr.add_point(seg.pts[seg.p0[i]]);
+      const uint32_t p1 = seg_corr.add_point(seg.pts[seg.p1[i]]);
+      seg_corr.add_segment(p0, p1, seg.parent[i], seg.attr[i]);
+      seg_matches.emplace_back();
+      std::set_union(
+        ms0.begin(), ms0.end(), ms1.begin(), ms1.end(), std::back_inserter(seg_matches.back()));
+    }
+  }
+  if (!seg.xf.empty()) {
+    seg_corr.localize(seg.origin);
+  }
+  seg_corr.index_points();
+  seg_corr.index_headings(seg.cell, seg.bins);
+  return seg_corr;
+}
+
+/*****************************************************************************
+ * Check if two matches were matched to the same openstreetmap-linestrings
+ ******************************************************************************/
+bool cmatching::same_target(const s_match & match_1, const s_match & match_2)
+{
+  lanelet::Ids ids_1 = match_1.target_ids();
+  lanelet::Ids ids_2 = match_2.target_ids();
+  std::sort(ids_1.begin(), ids_1.end());
+  ids_1.erase(std::unique(ids_1.begin(), ids_1.end()), ids_1.end());
+  std::sort(ids_2.begin(), ids_2.end());
+  ids_2.erase(std::unique(ids_2.begin(), ids_2.end()), ids_2.end());
+  return ids_1 == ids_2;
+}
+
 /********************************************
  * Get centerline of a part of the street
  *********************************************/
@@ -222,14 +976,13 @@ lanelet::LineString3d cmatching::get_centerline(
     }
   }
 
-  // Create new lanelet of outer Bounds and return its centerline
-  lanelet::Lanelet ll_new(
-    lanelet::utils::getId(), left_outer.leftBound(), right_outer.rightBound());
+  // Create new lanelet of outer Bounds (scratch, no id) and return its centerline
+  lanelet::Lanelet ll_new(lanelet::InvalId, left_outer.leftBound(), right_outer.rightBound());
 
   // Create resulting linestring with the lanelet ids it is representing as attributes
-  lanelet::LineString3d center(lanelet::utils::getId(), {});
+  lanelet::LineString3d center(next_id(), {});
   for (const auto & pt : ll_new.centerline()) {
-    lanelet::Point3d pt_(lanelet::utils::getId(), pt.x(), pt.y(), pt.z());
+    lanelet::Point3d pt_(next_id(), pt.x(), pt.y(), pt.z());
     center.push_back(pt_);
   }
   // Forward lanelet ids as attributes
@@ -261,50 +1014,11 @@ void cmatching::connect_lss(
   connect_dir(lls, lss, conn, ls, "ll_id_forward_");
 }
 
-/****************************************************************************************
- * Split vector of linestrings with plines into vector of segments (copy attributes)
- *****************************************************************************************/
-lanelet::LineStrings3d cmatching::split_lss(rclcpp::Node & node, lanelet::LineStrings3d & lss)
-{
-  const double seg_len = node.get_parameter("seg_len").as_double();
-
-  lanelet::LineStrings3d lss_split;
-  for (auto & ls : lss) {
-    for (auto it = ls.begin(); it != ls.end() - 1; ++it) {
-      lanelet::LineString3d new_segment(lanelet::utils::getId(), {*it, *(it + 1)});
-      // Only copy attributes, if segments does not contain a point that is only created
-      // for connection reasons (see preprocessing step)
-      if (!it->hasAttribute("connection") && !(it + 1)->hasAttribute("connection")) {
-        new_segment.attributes() = ls.attributes();
-      }
-      // Further split segment if it is too long
-      while (lanelet::geometry::length(new_segment) > seg_len) {
-        double len = lanelet::geometry::length(new_segment);
-        // Create new interpolated point
-        lanelet::BasicPoint3d pt_inter =
-          lanelet::geometry::interpolatedPointAtDistance(new_segment, len - seg_len);
-        lanelet::Point3d pt__inter(
-          lanelet::utils::getId(), pt_inter.x(), pt_inter.y(), pt_inter.z());
-
-        // Create new linestring with len specified by "seg_len" and update original linestring
-        lanelet::LineString3d new_segment_(
-          lanelet::utils::getId(), {pt__inter, new_segment.back()}, ls.attributes());
-        lss_split.push_back(new_segment_);
-        new_segment.pop_back();
-        new_segment.push_back(pt__inter);
-      }
-      lss_split.push_back(new_segment);
-    }
-  }
-  return lss_split;
-}
-
 /*************************************************************************
  * Instantiate a polyline consisting of linestring segments with 2 points
  **************************************************************************/
 lanelet::LineStrings3d cmatching::init_pline(
-  rclcpp::Node & node, const lanelet::LineString3d & ls, lanelet::LineStrings3d & lss,
-  lanelet::Ids & ids)
+  rclcpp::Node & node, const lanelet::LineString3d & ls, s_seg_view & lss, lanelet::Ids & ids)
 {
   // Get parameter and start with the given (unused) linestring
   double pline_angle = node.get_parameter("pline_angle").as_double() * std::atan(1.0) * 4 / 180.0;
@@ -320,110 +1034,69 @@ lanelet::LineStrings3d cmatching::init_pline(
   return pline;
 }
 
-/*******************************************************************************
- * Initialize buffers around each line segment based on the given parameters
- ********************************************************************************/
-lanelet::Areas cmatching::create_buffer(
-  const lanelet::LineStrings3d & lss, const double buffer_V, const double buffer_P,
-  const double rad)
-{
-  /*********************************************************************
-   * Buffer around linestring segment
-   * => buffer_V: size vertical to segment direction
-   * => buffer_V: size in segment direction (before and after segment)
-   * => radius: radius on corners (here illustrate with slashes)
-   *    ____________________________________
-   *   /                                    \
-   *  /                                      \
-   * |                                        |
-   * |                                        |
-   * |          *                  *          |
-   * |                                        |
-   * |                                        |
-   *  \                                      /
-   *   \____________________________________/
-   **********************************************************************/
-
-  lanelet::Areas buffers;
-  // Iterate through segments
-  for (const auto & ls : lss) {
-    // Get first and second point of segment and difference vector
-    Eigen::Vector2d pt_f(ls.front().x(), ls.front().y());
-    Eigen::Vector2d pt_s(ls.back().x(), ls.back().y());
-    Eigen::Vector2d dir = (pt_s - pt_f);
-
-    // Calculate normalized vector perpendicular to segment direction (left)
-    Eigen::Vector2d offset_l = rot(90) * dir.normalized();
-
-    // Define buffer points on front and back
-    Eigen::Vector2d pt_f_l = pt_f - dir.normalized() * buffer_P + offset_l * (buffer_V - rad);
-    Eigen::Vector2d pt_f_r = pt_f - dir.normalized() * buffer_P - offset_l * (buffer_V - rad);
-    Eigen::Vector2d pt_s_l = pt_s + dir.normalized() * buffer_P + offset_l * (buffer_V - rad);
-    Eigen::Vector2d pt_s_r = pt_s + dir.normalized() * buffer_P - offset_l * (buffer_V - rad);
-
-    // PDefine points on sides
-    Eigen::Vector2d pt_l_f = pt_f + offset_l * buffer_V - dir.normalized() * (buffer_P - rad);
-    Eigen::Vector2d pt_r_f = pt_f - offset_l * buffer_V - dir.normalized() * (buffer_P - rad);
-    Eigen::Vector2d pt_l_s = pt_s + offset_l * buffer_V + dir.normalized() * (buffer_P - rad);
-    Eigen::Vector2d pt_r_s = pt_s - offset_l * buffer_V + dir.normalized() * (buffer_P - rad);
-
-    // Define points on radius (at 45 degrees)
-    Eigen::Vector2d pt_rad_f_l = pt_f - dir.normalized() * (buffer_P - rad) +
-                                 offset_l * (buffer_V - rad) + rot(135) * dir.normalized() * rad;
-    Eigen::Vector2d pt_rad_f_r = pt_f - dir.normalized() * (buffer_P - rad) -
-                                 offset_l * (buffer_V - rad) + rot(225) * dir.normalized() * rad;
-    Eigen::Vector2d pt_rad_s_l = pt_s + dir.normalized() * (buffer_P - rad) +
-                                 offset_l * (buffer_V - rad) + rot(45) * dir.normalized() * rad;
-    Eigen::Vector2d pt_rad_s_r = pt_s + dir.normalized() * (buffer_P - rad) -
-                                 offset_l * (buffer_V - rad) + rot(315) * dir.normalized() * rad;
-
-    // Convert Eigen-vectors to lanelet-points to create area
-    std::vector<Eigen::Vector2d> points_{pt_f_l,     pt_f_r,     pt_s_l,     pt_s_r,
-                                         pt_l_f,     pt_r_f,     pt_l_s,     pt_r_s,
-                                         pt_rad_f_l, pt_rad_f_r, pt_rad_s_l, pt_rad_s_r};
-
-    // Create linestrings and area
-    lanelet::Points3d points;
-    for (const auto & pt_ : points_) {
-      lanelet::Point3d pt(lanelet::utils::getId(), pt_(0), pt_(1), 0.0);
-      points.push_back(pt);
+/***********************************************************************
+ * Find all line segments inside given buffers and return as candidates
+ ************************************************************************/
+scratch_plines cmatching::matching_candidates(
+  const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers, s_seg_view & lss)
+{
+  scratch_plines candidates(this->arena.get());
+  scratch_pline pline(this->arena.get());
+  scratch_ids ids(this->arena.get());
+
+  // Buffers in float32 relative to the local origin (if selected)
+  std::pmr::vector<Eigen::Vector2f> buffers_f(this->arena.get());
+  if (this->float_geometry) {
+    buffers_f.reserve(buffers.size());
+    for (const auto & pt : buffers) {
+      buffers_f.push_back((pt - this->origin).cast<float>());
     }
+  }
 
-    lanelet::LineString3d ls_l(lanelet::utils::getId(), {points[4], points[6]});
-    lanelet::LineString3d lsc_sl1(lanelet::utils::getId(), {points[6], points[10]});
-    lanelet::LineString3d lsc_sl2(lanelet::utils::getId(), {points[10], points[2]});
-    lanelet::LineString3d ls_s(lanelet::utils::getId(), {points[2], points[3]});
-    lanelet::LineString3d lsc_sr1(lanelet::utils::getId(), {points[3], points[11]});
-    lanelet::LineString3d lsc_sr2(lanelet::utils::getId(), {points[11], points[7]});
-    lanelet::LineString3d ls_r(lanelet::utils::getId(), {points[7], points[5]});
-    lanelet::LineString3d lsc_fr1(lanelet::utils::getId(), {points[5], points[9]});
-    lanelet::LineString3d lsc_fr2(lanelet::utils::getId(), {points[9], points[1]});
-    lanelet::LineString3d ls_f(lanelet::utils::getId(), {points[1], points[0]});
-    lanelet::LineString3d lsc_fl1(lanelet::utils::getId(), {points[0], points[8]});
-    lanelet::LineString3d lsc_fl2(lanelet::utils::getId(), {points[8], points[4]});
+  // Segments to test => all or only the segments of the heading-binned index with a direction
+  // compatible with the reference polyline (see heading_segments)
+  std::pmr::vector<uint32_t> sel(this->arena.get());
+  if (lss.t.bins == 0) {
+    sel.resize(lss.size());
+    std::iota(sel.begin(), sel.end(), 0);
+  } else {
+    heading_segments(ref_pline, buffers, lss.t, sel);
+  }
 
-    lanelet::Area ar(
-      lanelet::utils::getId(), {ls_l, lsc_sl1, lsc_sl2, ls_s, lsc_sr1, lsc_sr2, ls_r, lsc_fr1,
-                                lsc_fr2, ls_f, lsc_fl1, lsc_fl2});
-    buffers.push_back(ar);
+  // Only segments inside the corridors of the coarse matches of the reference polyline
+  // (coarse-to-fine, both sorted)
+  if (this->corridors) {
+    auto own = [this](const uint32_t i) {
+      const std::vector<uint32_t> & ms = this->corridors->target[i];
+      auto a = ms.begin();
+      auto b = this->pline_corridors.begin();
+      while (a != ms.end() && b != this->pline_corridors.end()) {
+        if (*a == *b) {
+          return true;
+        } else if (*a < *b) {
+          ++a;
+        } else {
+          ++b;
+        }
+      }
+      return false;
+    };
+    sel.erase(
+      std::remove_if(sel.begin(), sel.end(), [&](const uint32_t i) { return !own(i); }),
+      sel.end());
   }
-  return buffers;
-}
+  this->eval_stats.segments += sel.size();
 
-/***********************************************************************
- * Find all line segments inside given buffers and return as candidates
- ************************************************************************/
-std::vector<lanelet::LineStrings3d> cmatching::matching_candidates(
-  const lanelet::LineStrings3d & ref_pline, const lanelet::Areas & buffers,
-  lanelet::LineStrings3d & lss)
-{
-  std::vector<lanelet::LineStrings3d> candidates;
-  lanelet::LineStrings3d pline;
-  lanelet::Ids ids;
   // Iterate through segments to find first one inside the buffer
   // => start form this segment to find following/previous segments inside
-  for (const auto & ls : lss) {
-    if (ls_inside_buffer(buffers, ls) && !used_Id(ids, ls)) {
+  // => scan on the coordinates, segments are only materialized if inside the buffers
+  for (const uint32_t i : sel) {
+    const bool inside =
+      this->float_geometry
+        ? ls_inside_buffer(buffers_f, lss.t.pt2f(lss.t.p0[i]), lss.t.pt2f(lss.t.p1[i]))
+        : ls_inside_buffer(buffers, lss.t.pt2d(lss.t.p0[i]), lss.t.pt2d(lss.t.p1[i]));
+    if (inside && !used_Id(ids, lss.t.id[i])) {
+      const lanelet::LineString3d ls = lss.segment(i);
       pline.clear();
       pline.push_back(ls);
       candidates.push_back(pline);
@@ -438,118 +1111,216 @@ std::vector<lanelet::LineStrings3d> cmatching::matching_candidates(
   return candidates;
 }
 
-/************************************************************************
- * Exclude match candidates if one of their geometric measures to
- * the reference polyline exceeds the limits
- *************************************************************************/
-std::vector<lanelet::LineStrings3d> cmatching::exclude_candidates(
-  rclcpp::Node & node, const lanelet::LineStrings3d & ref,
-  const std::vector<lanelet::LineStrings3d> & candidates)
-{
-  // Get parameters
-  const double lim_angle = node.get_parameter("lim_angle").as_double() * std::atan(1.0) * 4 / 180.0;
-  const double lim_length = node.get_parameter("lim_length").as_double();
-  const double lim_chord = node.get_parameter("lim_chord").as_double();
-  const double lim_poly = node.get_parameter("lim_poly").as_double();
-
-  std::vector<lanelet::LineStrings3d> candidates_rem;
-  // Exlude candidates that exceed limits
-  if (!candidates.empty()) {
-    for (auto & candidate : candidates) {
-      // Calculate similarity measures
-      double d_beta = angle_diff_pline(ref, candidate);
-      double d_len = len_diff_pline(ref, candidate);
-      double d_chord = chord_diff_pline(ref, candidate);
-      double d_poly = poly_area_diff_pline(ref, candidate);
-
-      // Only keep candidates that are in the limits
-      if (d_beta < lim_angle && d_len < lim_length && d_chord < lim_chord && d_poly < lim_poly) {
-        candidates_rem.push_back(candidate);
+/******************************************************************************************
+ * Get segments of the heading-binned index inside the cells of the buffers
+ * => lossless: superset of the segments inside the buffers (same candidates as testing all
+ *    segments), ordered as the scan of all segments
+ * => heading filter: only segments with a direction compatible with the corresponding
+ *    reference segment (either orientation)
+ *******************************************************************************************/
+void cmatching::heading_segments(
+  const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers,
+  const s_seg_table & seg, std::pmr::vector<uint32_t> & sel)
+{
+  const double pi = std::atan(1.0) * 4;
+  const double bin_width = 2 * pi / seg.bins;
+  std::pmr::vector<size_t> bins(this->arena.get());
+  // One buffer polygon per reference segment (see buffer_polygons)
+  for (size_t r = 0; r < ref_pline.size() && (r + 1) * buffer_points <= buffers.size(); ++r) {
+    const lanelet::BasicPoint2d a = lanelet::utils::to2D(ref_pline[r].front().basicPoint());
+    const lanelet::BasicPoint2d b = lanelet::utils::to2D(ref_pline[r].back().basicPoint());
+    const double h = std::atan2(b.y() - a.y(), b.x() - a.x());
+
+    // All heading bins (lossless) or the bins overlapping the tolerance around the reference
+    // direction (heading filter)
+    bins.clear();
+    for (size_t k = 0; k < seg.bins; ++k) {
+      const double center = -pi + (k + 0.5) * bin_width;
+      if (
+        !this->heading_filter ||
+        std::abs(std::remainder(center - h, 2 * pi)) <= this->heading_tol + bin_width / 2) {
+        bins.push_back(k);
+      }
+    }
+
+    // Cells of the bounding box of the buffer
+    lanelet::BasicPoint2d min = buffers[r * buffer_points];
+    lanelet::BasicPoint2d max = min;
+    for (size_t k = r * buffer_points; k < (r + 1) * buffer_points; ++k) {
+      min = min.cwiseMin(buffers[k]);
+      max = max.cwiseMax(buffers[k]);
+    }
+    // Margin for the rounding of float32 geometry (buffer tests relative to local origin)
+    min -= lanelet::BasicPoint2d(0.01, 0.01);
+    max += lanelet::BasicPoint2d(0.01, 0.01);
+    for (int64_t ix = seg.cell_ind(min.x()); ix <= seg.cell_ind(max.x()); ++ix) {
+      for (int64_t iy = seg.cell_ind(min.y()); iy <= seg.cell_ind(max.y()); ++iy) {
+        for (const size_t k : bins) {
+          const auto it = seg.index.find(seg.index_key(ix, iy, k));
+          if (it == seg.index.end()) {
+            continue;
+          }
+          // Exact (undirected) direction difference
+          for (const uint32_t i : it->second) {
+            if (
+              !this->heading_filter ||
+              std::abs(std::remainder(seg.heading(i) - h, pi)) <= this->heading_tol) {
+              sel.push_back(i);
+            }
+          }
+        }
       }
     }
   }
-  return candidates_rem;
+  // Same order as scanning all segments
+  std::sort(sel.begin(), sel.end());
+  sel.erase(std::unique(sel.begin(), sel.end()), sel.end());
 }
 
-/**********************************************************************
- * Select the best match candidate out of multiple ones by a
- * weighted score of geo-similarity measures
- ***********************************************************************/
-lanelet::LineStrings3d cmatching::select_candidate(
-  rclcpp::Node & node, const lanelet::LineStrings3d & ref,
-  const std::vector<lanelet::LineStrings3d> & candidates)
+/******************************************************************************************
+ * Select the best match candidate by a weighted score of geo-similarity measures with a
+ * bounded search (returns false if all candidates exceed a limit)
+ * => measures are calculated from cheap to expensive, a candidate is rejected as soon as a
+ *    measure exceeds its limit and pruned as soon as the upper bound of its score can't
+ *    beat the best candidate so far (same selection as scoring all candidates)
+ *******************************************************************************************/
+template <typename ScoringT>
+bool cmatching::select_candidate(
+  const lanelet::LineStrings3d & ref, const scratch_plines & candidates, size_t & ind,
+  s_measures & measures, const ScoringT & scoring)
 {
-  // Get parameters
-  // limits/normalizing values
-  const double lim_angle = node.get_parameter("lim_angle").as_double() * std::atan(1.0) * 4 / 180.0;
-  const double lim_length = node.get_parameter("lim_length").as_double();
-  const double lim_chord = node.get_parameter("lim_chord").as_double();
-  const double lim_poly = node.get_parameter("lim_poly").as_double();
-
-  // Weights
-  const double w_angle = node.get_parameter("w_angle").as_double();
-  const double w_len = node.get_parameter("w_length").as_double();
-  const double w_chord = node.get_parameter("w_chord").as_double();
-  const double w_poly = node.get_parameter("w_poly").as_double();
+  // Get limits of the profile
+  const s_score_profile & p = scoring.profile();
+  const double lim_angle = p.lim_angle * std::atan(1.0) * 4 / 180.0;
+  const size_t n_use = static_cast<size_t>(p.use_angle) + static_cast<size_t>(p.use_length) +
+                       static_cast<size_t>(p.use_chord) + static_cast<size_t>(p.use_poly) +
+                       static_cast<size_t>(p.use_frechet);
+  // Upper bound of the score (all enabled measures 0)
+  const auto w_max = [](const bool use, const double w) { return use ? std::max(w, 0.0) : 0.0; };
+  const double bound_max = w_max(p.use_angle, p.w_angle) + w_max(p.use_length, p.w_len) +
+                           w_max(p.use_chord, p.w_chord) + w_max(p.use_poly, p.w_poly) +
+                           w_max(p.use_frechet, p.w_frechet);
+
+  bool found = false;
+  double score_max = -std::numeric_limits<double>::max();
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const auto & candidate = candidates[i];
+    ++this->eval_stats.candidates;
+    s_measures m;
+    double bound = bound_max;
+    size_t n_calc = 0;
+    bool rejected = false;
+
+    // Calculate a measure and tighten the upper bound of the score
+    // => false if the candidate is rejected by the limit or can't beat the best candidate
+    // => measures may stop early at the threshold the candidate needs to stay in the search
+    //    (then a lower bound of the measure is returned)
+    const auto eval = [&](const bool use, const double w, const double lim, double & d, auto calc) {
+      if (!use) {
+        return true;
+      }
+      // Tolerance for the different summation order of geo_score (first candidate wins ties)
+      const double thr =
+        (found && w > 0.0) ? std::min(lim, lim * (bound - score_max + 1e-9) / w) : lim;
+      d = calc(thr);
+      ++n_calc;
+      if (!(d < lim)) {
+        rejected = true;
+        return false;
+      }
+      bound += w * (1.0 - d / lim) - std::max(w, 0.0);
+      return !found || bound + 1e-9 > score_max;
+    };
+
+    // Measures ordered by cost (chord/angle: end points, length: all points, poly: alignment,
+    // Frechet: all couplings of the points => last to stop at the tightest threshold)
+    const bool complete =
+      eval(
+        p.use_chord, p.w_chord, p.lim_chord, m.d_chord,
+        [&](double) { return chord_diff_pline(ref, candidate); }) &&
+      eval(
+        p.use_angle, p.w_angle, lim_angle, m.d_ang,
+        [&](double) { return angle_diff_pline(ref, candidate); }) &&
+      eval(
+        p.use_length, p.w_len, p.lim_length, m.d_len,
+        [&](double) { return len_diff_pline(ref, candidate); }) &&
+      eval(
+        p.use_poly, p.w_poly, p.lim_poly, m.d_poly,
+        [&](double) { return poly_area_diff_pline(ref, candidate); }) &&
+      eval(
+        p.use_frechet, p.w_frechet, p.lim_frechet, m.d_frechet,
+        [&](const double thr) { return frechet_distance(ref, candidate, thr); });
+    this->eval_stats.measures += n_calc;
+    if (!complete) {
+      this->eval_stats.skipped += n_use - n_calc;
+      ++(rejected ? this->eval_stats.rejected : this->eval_stats.pruned);
+      continue;
+    }
 
-  std::vector<double> d_beta, d_len, d_chord, d_poly, d_ang_first, d_ang_last, scores;
+    // Candidate with maximum score (first one on ties)
+    const double score = geo_score(m, scoring);
+    if (!found || score > score_max) {
+      found = true;
+      score_max = score;
+      ind = i;
+      measures = m;
+    }
+  }
+  return found;
+}
 
-  // Find the best candidate by geometric score
-  for (auto & candidate : candidates) {
-    // Calculate similarity measures
-    d_beta.push_back(angle_diff_pline(ref, candidate));
-    d_len.push_back(len_diff_pline(ref, candidate));
-    d_chord.push_back(chord_diff_pline(ref, candidate));
-    d_poly.push_back(poly_area_diff_pline(ref, candidate));
+/*****************************************************************************
+ * Weighted score of the enabled geometric similarity measures
+ ******************************************************************************/
+template <typename ScoringT>
+double cmatching::geo_score(const s_measures & m, const ScoringT & scoring)
+{
+  const s_score_profile & p = scoring.profile();
+  const double lim_angle = p.lim_angle * std::atan(1.0) * 4 / 180.0;
+  double score = 0.0;
+  if (p.use_angle) {
+    score += p.w_angle * (1.0 - m.d_ang / lim_angle);
+  }
+  if (p.use_length) {
+    score += p.w_len * (1.0 - m.d_len / p.lim_length);
+  }
+  if (p.use_chord) {
+    score += p.w_chord * (1.0 - m.d_chord / p.lim_chord);
+  }
+  if (p.use_poly) {
+    score += p.w_poly * (1.0 - m.d_poly / p.lim_poly);
   }
-  // Calculate weighted score
-  for (int i = 0; i < static_cast<int>(candidates.size()); ++i) {
-    double score = w_angle * (1.0 - d_beta[i] / lim_angle) + w_len * (1.0 - d_len[i] / lim_length) +
-                   w_chord * (1.0 - d_chord[i] / lim_chord) + w_poly * (1.0 - d_poly[i] / lim_poly);
-    scores.push_back(score);
+  if (p.use_frechet) {
+    score += p.w_frechet * (1.0 - m.d_frechet / p.lim_frechet);
   }
-  // Find candidate with maximum score and return
-  const int ind = std::distance(scores.begin(), std::max_element(scores.begin(), scores.end()));
-  return candidates[ind];
+  return score;
 }
 
 /*****************************************************************************
  * Set geosimilarity measures for later evaluation of matching result
+ * => measures of the matched candidate (all 0 if unmatched)
  ******************************************************************************/
-void cmatching::calc_geo_measures(rclcpp::Node & node, s_match & match)
-{
-  // Get parameters
-  // limits/normalizing values
-  const double lim_angle = node.get_parameter("lim_angle").as_double() * std::atan(1.0) * 4 / 180.0;
-  const double lim_length = node.get_parameter("lim_length").as_double();
-  const double lim_chord = node.get_parameter("lim_chord").as_double();
-  const double lim_poly = node.get_parameter("lim_poly").as_double();
-
-  // Weights
-  const double w_angle = node.get_parameter("w_angle").as_double();
-  const double w_len = node.get_parameter("w_length").as_double();
-  const double w_chord = node.get_parameter("w_chord").as_double();
-  const double w_poly = node.get_parameter("w_poly").as_double();
-
-  double d_ang, d_len, d_chord, d_poly, d_chamfer, score;
+template <typename ScoringT>
+void cmatching::calc_geo_measures(s_match & match, const s_measures & m, const ScoringT & scoring)
+{
+  double d_frechet, d_chamfer, score;
   if (!match.target_pline().empty()) {
-    d_ang = angle_diff_pline(match.ref_pline(), match.target_pline());
-    d_len = len_diff_pline(match.ref_pline(), match.target_pline());
-    d_chord = chord_diff_pline(match.ref_pline(), match.target_pline());
-    d_poly = poly_area_diff_pline(match.ref_pline(), match.target_pline());
+    // Frechet distance of the selection or as additional statistic (not scored)
+    d_frechet = scoring.profile().use_frechet
+                  ? m.d_frechet
+                  : frechet_distance(
+                      match.ref_pline(), match.target_pline(),
+                      std::numeric_limits<double>::infinity());
     d_chamfer = chamfer_distance(match.ref_pline(), match.target_pline());
-    score = w_angle * (1.0 - d_ang / lim_angle) + w_len * (1.0 - d_len / lim_length) +
-            w_chord * (1.0 - d_chord / lim_chord) + w_poly * (1.0 - d_poly / lim_poly);
+    score = geo_score(m, scoring);
   } else {
-    d_ang = 0;
-    d_len = 0;
-    d_chord = 0;
-    d_poly = 0;
+    d_frechet = 0;
     d_chamfer = 0;
     score = 0;
   }
-  const double len_ref_pline = lanelet::geometry::length(ls_seg2string(match.ref_pline()));
-  match.set_geo_measures(d_ang, d_len, d_chord, d_poly, d_chamfer, len_ref_pline, score);
+  const double len_ref_pline = pline_length(match.ref_pline());
+  match.set_geo_measures(
+    m.d_ang, m.d_len, m.d_chord, m.d_poly, d_frechet, d_chamfer, len_ref_pline, score);
 }
 
 /*****************************************************************************
@@ -560,13 +1331,14 @@ std::vector<double> cmatching::matching_stats(
   rclcpp::Node & node, const std::vector<s_match> & matches)
 {
   std::vector<double> stats;
-  std::vector<double> len_ref_pline, d_ang, d_len, d_chord, d_poly, d_chamfer, score;
+  std::vector<double> len_ref_pline, d_ang, d_len, d_chord, d_poly, d_frechet, d_chamfer, score;
   for (const auto & match : matches) {
     len_ref_pline.push_back(match.len_ref_pline());
     d_ang.push_back(match.d_ang());
     d_len.push_back(match.d_len());
     d_chord.push_back(match.d_chord());
     d_poly.push_back(match.d_poly());
+    d_frechet.push_back(match.d_frechet());
     d_chamfer.push_back(match.d_chamfer());
     score.push_back(match.score());
   }
@@ -586,13 +1358,14 @@ std::vector<double> cmatching::matching_stats(
 
   // Filter out polylines based on length threshold
   std::vector<double> len_ref_pline_fil, d_ang_fil, d_len_fil, d_chord_fil, d_poly_fil,
-    d_chamfer_fil, score_fil;
+    d_frechet_fil, d_chamfer_fil, score_fil;
   for (const auto & index : ind_ref_pline) {
     len_ref_pline_fil.push_back(len_ref_pline[index]);
     d_ang_fil.push_back(d_ang[index]);
     d_len_fil.push_back(d_len[index]);
     d_chord_fil.push_back(d_chord[index]);
     d_poly_fil.push_back(d_poly[index]);
+    d_frechet_fil.push_back(d_frechet[index]);
     d_chamfer_fil.push_back(d_chamfer[index]);
     score_fil.push_back(score[index]);
   }
@@ -621,6 +1394,10 @@ std::vector<double> cmatching::matching_stats(
   int tp =
     std::count_if(score_fil.begin(), score_fil.end(), [lim_tp](double s) { return s >= lim_tp; });
   stats.push_back(static_cast<double>(tp) / static_cast<double>(count));
+
+  // Mean Frechet distance of matches
+  stats.push_back(
+    std::accumulate(d_frechet_fil.begin(), d_frechet_fil.end(), 0.0) / static_cast<double>(count));
   return stats;
 }
 
@@ -675,24 +1452,26 @@ void cmatching::connect_dir(
  * segment is below the given limit
  *******************************************************************************************/
 void cmatching::extend_ref_pline(
-  lanelet::LineStrings3d & pline, lanelet::LineStrings3d & lss, const double angle_lim,
+  lanelet::LineStrings3d & pline, s_seg_view & lss, const double angle_lim,
   lanelet::Ids & ids, const std::string & direction)
 {
   const int dir = (direction == "forward") ? 1 : 0;
 
   // Initialize by finding the connected segments to the point in forward/backward direction
-  lanelet::LineStrings3d connected;
+  scratch_pline connected(this->arena.get());
   (dir == 1) ? find_ls_from_point(connected, lss, pline.back(), dir)
              : find_ls_from_point(connected, lss, pline.front(), dir);
   bool angle_within_lim = true;
 
   // Iterate as long as no intersection (valence >= 3) and angle within the limits
+  std::pmr::vector<double> angles(this->arena.get());
+  scratch_pline ls_angles(this->arena.get());
   while (!connected.empty() && connected.size() < 3 && angle_within_lim) {
-    std::vector<double> angles;
-    lanelet::LineStrings3d ls_angles;
+    angles.clear();
+    ls_angles.clear();
     lanelet::LineString3d pline_seg = (dir == 1) ? pline.back() : pline.front();
     // Calculate angle between potential new segment and current pline segment
-    for (const auto ls_ : connected) {
+    for (const auto & ls_ : connected) {
       if (!used_Id(ids, ls_)) {
         angles.push_back(std::abs(angle_segment(pline_seg, ls_, false)));
         ls_angles.push_back(ls_);
@@ -725,35 +1504,40 @@ void cmatching::extend_ref_pline(
  * as long as they are inside the buffers and add them as match candidates
  *******************************************************************************/
 void cmatching::extend_candidates(
-  std::vector<lanelet::LineStrings3d> & candidates, lanelet::LineStrings3d & pline,
-  lanelet::LineStrings3d & lss, const lanelet::LineStrings3d & ref_pline,
-  const lanelet::Areas & buffers, lanelet::Ids & ids, const std::string & direction)
+  scratch_plines & candidates, scratch_pline & pline, s_seg_view & lss,
+  const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers, scratch_ids & ids,
+  const std::string & direction)
 {
   bool cont = true;
   const int dir = (direction == "forward") ? 1 : 0;
 
   // Initialize by finding the connected segments to the point in forward/backward direction
-  lanelet::LineStrings3d connected;
+  scratch_pline connected(this->arena.get());
   (dir == 1) ? find_ls_from_point(connected, lss, pline.back(), dir)
              : find_ls_from_point(connected, lss, pline.front(), dir);
 
   // Iterate as long as segment inside buffers
+  std::pmr::vector<double> angles(this->arena.get());
+  scratch_pline ls_inside(this->arena.get());
   while (!connected.empty() && cont) {
-    std::vector<double> angles;
-    lanelet::LineStrings3d ls_inside;
+    angles.clear();
+    ls_inside.clear();
     cont = false;
     for (const auto & ls : connected) {
       if (ls_inside_buffer(buffers, ls) && !used_Id(ids, ls)) {
         ls_inside.push_back(ls);
-        std::vector<double> min;
-        for (const auto & lsref : ref_pline) {
-          min.push_back(
-            lanelet::geometry::distance2d(ls.front(), lsref.front()) +
-            lanelet::geometry::distance2d(ls.back(), lsref.back()));
+        // Closest reference segment (first one on ties)
+        size_t ind_min = 0;
+        double min = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < ref_pline.size(); ++i) {
+          const double d = lanelet::geometry::distance2d(ls.front(), ref_pline[i].front()) +
+                           lanelet::geometry::distance2d(ls.back(), ref_pline[i].back());
+          if (d < min) {
+            min = d;
+            ind_min = i;
+          }
         }
-        angles.push_back(std::abs(angle_segment(
-          ref_pline[std::distance(min.begin(), std::min_element(min.begin(), min.end()))], ls,
-          true)));
+        angles.push_back(std::abs(angle_segment(ref_pline[ind_min], ls, true)));
       }
     }
     // If multiple following/previous linestrings are inside the buffer
@@ -788,9 +1572,15 @@ bool cmatching::used_Id(const lanelet::Ids & ids, const lanelet::ConstLanelet &
 /*********************************************
  * Check if a linestring was already used
  **********************************************/
-bool cmatching::used_Id(const lanelet::Ids & ids, const lanelet::ConstLineString3d & ls)
+template <typename IdsT>
+bool cmatching::used_Id(const IdsT & ids, const lanelet::ConstLineString3d & ls)
 {
-  if (std::find(ids.begin(), ids.end(), ls.id()) != ids.end()) {
+  return used_Id(ids, ls.id());
+}
+template <typename IdsT>
+bool cmatching::used_Id(const IdsT & ids, const lanelet::Id id)
+{
+  if (std::find(ids.begin(), ids.end(), id) != ids.end()) {
     return true;
   }
   return false;
@@ -864,30 +1654,32 @@ lanelet::LineString3d cmatching::find_ls(
 /***************************************************************************
  * Find all linestrings that are connected to either the first or second
  * point of another linestring
+ * => segments at the point from the point -> segment adjacency of the table
  ****************************************************************************/
+template <typename LineStringsT>
 void cmatching::find_ls_from_point(
-  lanelet::LineStrings3d & ls_pt, lanelet::LineStrings3d & lss, const lanelet::LineString3d & src,
-  const int pos)
+  LineStringsT & ls_pt, s_seg_view & lss, const lanelet::LineString3d & src, const int pos)
 {
+  if (pos != 0 && pos != 1) {
+    std::cerr << __FUNCTION__ << ": Can only consider segments!" << std::endl;
+    return;
+  }
   // Consider first (pos = 0) or second (pos = 1) point of source linestring
-  if (pos == 0) {
-    for (auto & ls : lss) {
-      if (ls.back().id() == src.front().id()) {
-        ls_pt.push_back(ls);
-      } else if (ls.front().id() == src.front().id()) {
-        ls_pt.push_back(ls.invert());
-      }
-    }
-  } else if (pos == 1) {
-    for (auto & ls : lss) {
-      if (ls.front().id() == src.back().id()) {
-        ls_pt.push_back(ls);
-      } else if (ls.back().id() == src.back().id()) {
-        ls_pt.push_back(ls.invert());
-      }
+  const auto it = lss.t.pt_ind.find((pos == 0) ? src.front().id() : src.back().id());
+  if (it == lss.t.pt_ind.end()) {
+    return;
+  }
+  const uint32_t p = it->second;
+  // Segments continuing in the same direction end (pos = 0) or start (pos = 1) at the point
+  const std::vector<uint32_t> & p_same = (pos == 0) ? lss.t.p1 : lss.t.p0;
+  const std::vector<uint32_t> & p_inv = (pos == 0) ? lss.t.p0 : lss.t.p1;
+  for (uint32_t k = lss.t.pt_seg_off[p]; k < lss.t.pt_seg_off[p + 1]; ++k) {
+    const uint32_t i = lss.t.pt_seg[k];
+    if (p_same[i] == p) {
+      ls_pt.push_back(lss.segment(i));
+    } else if (p_inv[i] == p) {
+      ls_pt.push_back(lss.segment(i).invert());
     }
-  } else {
-    std::cerr << __FUNCTION__ << ": Can only consider segments!" << std::endl;
   }
 }
 
@@ -913,7 +1705,7 @@ void cmatching::connect_ls(
     double x = (pt_pre.x() + pt_fol.x()) / 2.0;
     double y = (pt_pre.y() + pt_fol.y()) / 2.0;
     double z = (pt_pre.z() + pt_fol.z()) / 2.0;
-    lanelet::Point3d pt(lanelet::utils::getId(), x, y, z);
+    lanelet::Point3d pt(next_id(), x, y, z);
     pt.attributes()["connection"] = "yes";
 
     // Insert point into both linestrings
@@ -959,25 +1751,32 @@ bool cmatching::conn_ls(
  * Check if a linestring segment is inside the buffers
  * => check if first && second point is inside buffers
  ***********************************************************/
-bool cmatching::ls_inside_buffer(const lanelet::Areas & buf, const lanelet::LineString3d & ls)
+bool cmatching::ls_inside_buffer(const scratch_points & buf, const lanelet::LineString3d & ls)
 {
-  bool firstPt, secondPt;
-  firstPt = secondPt = false;
   if (ls.size() != 2) {
     std::cerr << __FUNCTION__ << ": Linestring is not a segment !!" << std::endl;
     return false;
   }
+  const lanelet::BasicPoint2d first = lanelet::utils::to2D(ls.front().basicPoint());
+  const lanelet::BasicPoint2d second = lanelet::utils::to2D(ls.back().basicPoint());
+  return ls_inside_buffer(buf, first, second);
+}
+template <typename PointsT, typename PointT>
+bool cmatching::ls_inside_buffer(const PointsT & buf, const PointT & first, const PointT & second)
+{
+  bool firstPt, secondPt;
+  firstPt = secondPt = false;
 
   // Check if first point of segment is inside buffers
-  for (const auto & ar : buf) {
-    if (lanelet::geometry::inside(ar, lanelet::utils::to2D(ls.front().basicPoint()))) {
+  for (size_t k = 0; k < buf.size(); k += buffer_points) {
+    if (inside_polygon(&buf[k], buffer_points, first)) {
       firstPt = true;
       break;
     }
   }
   // Check if second point of segment is inside buffers
-  for (const auto & ar : buf) {
-    if (lanelet::geometry::inside(ar, lanelet::utils::to2D(ls.back().basicPoint()))) {
+  for (size_t k = 0; k < buf.size(); k += buffer_points) {
+    if (inside_polygon(&buf[k], buffer_points, second)) {
       secondPt = true;
       break;
     }
@@ -991,45 +1790,35 @@ bool cmatching::ls_inside_buffer(const lanelet::Areas & buf, const lanelet::Line
 /**************************************************************
  * Calculate angle between first and last point of a polyline
  ***************************************************************/
-double cmatching::angle_diff_pline(
-  const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2)
+template <typename PlineT1, typename PlineT2>
+double cmatching::angle_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2)
 {
-  // Create linestrings consisting of end points of plines
-  lanelet::Point3d ls1_start(
-    lanelet::utils::getId(), ls1.front().front().x(), ls1.front().front().y(),
-    ls1.front().front().z());
-  lanelet::Point3d ls1_end(
-    lanelet::utils::getId(), ls1.back().back().x(), ls1.back().back().y(), ls1.back().back().z());
-  lanelet::Point3d ls2_start(
-    lanelet::utils::getId(), ls2.front().front().x(), ls2.front().front().y(),
-    ls2.front().front().z());
-  lanelet::Point3d ls2_end(
-    lanelet::utils::getId(), ls2.back().back().x(), ls2.back().back().y(), ls2.back().back().z());
-
-  lanelet::LineString3d ls1_(lanelet::utils::getId(), {ls1_start, ls1_end});
-  lanelet::LineString3d ls2_(lanelet::utils::getId(), {ls2_start, ls2_end});
+  // Create linestrings consisting of end points of plines (scratch, no ids)
+  lanelet::Point3d ls1_start(lanelet::InvalId, ls1.front().front().basicPoint());
+  lanelet::Point3d ls1_end(lanelet::InvalId, ls1.back().back().basicPoint());
+  lanelet::Point3d ls2_start(lanelet::InvalId, ls2.front().front().basicPoint());
+  lanelet::Point3d ls2_end(lanelet::InvalId, ls2.back().back().basicPoint());
+
+  lanelet::LineString3d ls1_(lanelet::InvalId, {ls1_start, ls1_end});
+  lanelet::LineString3d ls2_(lanelet::InvalId, {ls2_start, ls2_end});
   return std::abs(angle_segment(ls1_, ls2_, true));
 }
 
 /**************************************************************
  * Calculate length difference between two polylines
  ***************************************************************/
-double cmatching::len_diff_pline(
-  const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2)
+template <typename PlineT1, typename PlineT2>
+double cmatching::len_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2)
 {
-  // Create connected linestring from segments
-  const lanelet::LineString3d ls1_ = ls_seg2string(ls1);
-  const lanelet::LineString3d ls2_ = ls_seg2string(ls2);
-
-  // Return length difference of linestrings
-  return std::abs(lanelet::geometry::length(ls1_) - lanelet::geometry::length(ls2_));
+  // Return length difference of polylines
+  return std::abs(pline_length(ls1) - pline_length(ls2));
 }
 
 /**************************************************************
  * Calculate chord difference between two polylines
  ***************************************************************/
-double cmatching::chord_diff_pline(
-  const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2)
+template <typename PlineT1, typename PlineT2>
+double cmatching::chord_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2)
 {
   double d1 = lanelet::geometry::distance2d(ls1.front().front(), ls1.back().back());
   double d2 = lanelet::geometry::distance2d(ls2.front().front(), ls2.back().back());
@@ -1039,8 +1828,8 @@ double cmatching::chord_diff_pline(
 /************************************************************************************
  * Calculate quotient of area enclosed by two polylines and the sum of their lengths
  *************************************************************************************/
-double cmatching::poly_area_diff_pline(
-  const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2)
+template <typename PlineT1, typename PlineT2>
+double cmatching::poly_area_diff_pline(const PlineT1 & ls1, const PlineT2 & ls2)
 {
   // Calculate polygon out of the two linestrings and divide it by the sum of their lengths
   // Create connected linestring from segments
@@ -1049,7 +1838,7 @@ double cmatching::poly_area_diff_pline(
 
   auto aligned = lanelet::geometry::align(ls1_, ls2_);
 
-  lanelet::Polygon3d poly(lanelet::utils::getId(), {});
+  lanelet::Polygon3d poly(lanelet::InvalId, {});
   for (auto & pt : aligned.first) {
     poly.push_back(pt);
   }
@@ -1061,6 +1850,21 @@ double cmatching::poly_area_diff_pline(
     (lanelet::geometry::length(ls1_) + lanelet::geometry::length(ls2_)));
 }
 
+/***********************************************************************
+ * Calculate length of a polyline (consisting of linestring segments)
+ * => same as the length of the connected linestring (see ls_seg2string)
+ ************************************************************************/
+template <typename PlineT>
+double cmatching::pline_length(const PlineT & pline)
+{
+  double len = 0.0;
+  for (size_t i = 0; i + 1 < pline.size(); ++i) {
+    len += (pline[i + 1].front().basicPoint() - pline[i].front().basicPoint()).norm();
+  }
+  len += (pline.back().back().basicPoint() - pline.back().front().basicPoint()).norm();
+  return len;
+}
+
 /******************************************************
  * Calculate angle between two linestring segments
  *******************************************************/
@@ -1089,48 +1893,110 @@ double cmatching::angle_segment(
 double cmatching::chamfer_distance(
   const lanelet::LineStrings3d & ls1, const lanelet::LineStrings3d & ls2)
 {
-  // Create connected linestring from segments
-  const lanelet::LineString3d ls1_ = ls_seg2string(ls1);
-  const lanelet::LineString3d ls2_ = ls_seg2string(ls2);
-
-  // Distance from ls1 to ls2
-  double cd1 = 0;
-  for (const auto & pt1 : ls1_) {
-    Eigen::Vector2d v1(pt1.x(), pt1.y());
-    std::vector<double> cd1_;
-    for (const auto & pt2 : ls2_) {
-      Eigen::Vector2d v2(pt2.x(), pt2.y());
-      cd1_.push_back((v1 - v2).norm());
-    }
-    cd1 += cd1_[std::distance(cd1_.begin(), std::min_element(cd1_.begin(), cd1_.end()))];
-  }
-  cd1 /= ls1.size();
-
-  // Distance from ls2 to ls1
-  double cd2 = 0;
-  for (const auto & pt2 : ls2_) {
-    Eigen::Vector2d v2(pt2.x(), pt2.y());
-    std::vector<double> cd2_;
-    for (const auto & pt1 : ls1_) {
-      Eigen::Vector2d v1(pt1.x(), pt1.y());
-      cd2_.push_back((v1 - v2).norm());
-    }
-    cd2 += cd2_[std::distance(cd2_.begin(), std::min_element(cd2_.begin(), cd2_.end()))];
+  // Mean distance of the points of one polyline to the closest point of the other one
+  // => distance from ls1 to ls2 and from ls2 to ls1
+  if (this->float_geometry) {
+    const auto pts1 = pline_points<Eigen::Vector2f>(ls1);
+    const auto pts2 = pline_points<Eigen::Vector2f>(ls2);
+    return closest_sum(pts1, pts2) / ls1.size() + closest_sum(pts2, pts1) / ls2.size();
   }
-  cd2 /= ls2.size();
+  const auto pts1 = pline_points<lanelet::BasicPoint2d>(ls1);
+  const auto pts2 = pline_points<lanelet::BasicPoint2d>(ls2);
+  return closest_sum(pts1, pts2) / ls1.size() + closest_sum(pts2, pts1) / ls2.size();
+}
 
-  return cd1 + cd2;
+/*******************************************************************************
+ * Get points of the connected linestring from segments (see ls_seg2string)
+ * relative to the local origin
+ ********************************************************************************/
+template <typename PointT, typename PlineT>
+std::pmr::vector<PointT> cmatching::pline_points(const PlineT & pline)
+{
+  using T = typename PointT::Scalar;
+  std::pmr::vector<PointT> pts(this->arena.get());
+  pts.reserve(pline.size() + 1);
+  for (const auto & seg : pline) {
+    pts.push_back(
+      (lanelet::utils::to2D(seg.front().basicPoint()) - this->origin).template cast<T>());
+  }
+  pts.push_back(
+    (lanelet::utils::to2D(pline.back().back().basicPoint()) - this->origin).template cast<T>());
+  return pts;
+}
+
+/******************************************************************************************
+ * Calculate discrete Frechet distance between two polylines
+ * => second polyline oriented like the first one (openstreetmap-ways are undirected)
+ * => couplings restricted to a band of frechet_band points around the diagonal (0: none)
+ * => abandoned as soon as all couplings of a point exceed thr (returns this lower bound)
+ *******************************************************************************************/
+template <typename PlineT1, typename PlineT2>
+double cmatching::frechet_distance(const PlineT1 & ls1, const PlineT2 & ls2, const double thr)
+{
+  if (this->float_geometry) {
+    return frechet_rows(
+      pline_points<Eigen::Vector2f>(ls1), pline_points<Eigen::Vector2f>(ls2), thr);
+  }
+  return frechet_rows(
+    pline_points<lanelet::BasicPoint2d>(ls1), pline_points<lanelet::BasicPoint2d>(ls2), thr);
 }
 
-/*****************************************
- * Create rotation matrix from angle
- ******************************************/
-Eigen::Matrix2d cmatching::rot(double angle)
+template <typename PointsT>
+double cmatching::frechet_rows(const PointsT & pts1, const PointsT & pts2, const double thr)
 {
-  double angle_rad = angle * std::atan(1.0) * 4 / 180.0;
-  Eigen::Matrix2d mat;
-  mat << std::cos(angle_rad), -std::sin(angle_rad), std::sin(angle_rad), std::cos(angle_rad);
-  return mat;
+  const size_t n = pts1.size();
+  const size_t m = pts2.size();
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // Orientation of the second polyline => reversed if its end points are closer crosswise
+  const bool reverse =
+    (pts1.front() - pts2.back()).norm() + (pts1.back() - pts2.front()).norm() <
+    (pts1.front() - pts2.front()).norm() + (pts1.back() - pts2.back()).norm();
+
+  // Band of columns per row around the diagonal
+  // => at least the slope of the diagonal so that the bands of consecutive rows connect
+  const double slope = (n > 1) ? static_cast<double>(m - 1) / static_cast<double>(n - 1) : 0.0;
+  const size_t band =
+    (this->frechet_band == 0 || n == 1)
+      ? m
+      : std::max(this->frechet_band, static_cast<size_t>(std::ceil(slope)));
+  auto lo = [&](const size_t i) {
+    const size_t c = static_cast<size_t>(std::floor(i * slope));
+    return (c > band) ? c - band : 0;
+  };
+  auto hi = [&](const size_t i) {
+    return std::min(m - 1, static_cast<size_t>(std::ceil(i * slope)) + band);
+  };
+
+  // Coupling distances of the previous and the current row (linear memory)
+  std::pmr::vector<double> prev(m, inf, this->arena.get());
+  std::pmr::vector<double> cur(m, inf, this->arena.get());
+  for (size_t i = 0; i < n; ++i) {
+    double row_min = inf;
+    for (size_t j = lo(i); j <= hi(i); ++j) {
+      const double d = static_cast<double>((pts1[i] - pts2[reverse ? m - 1 - j : j]).norm());
+      double reach;
+      if (i == 0 && j == 0) {
+        reach = d;
+      } else {
+        reach = std::min(
+          {(i > 0) ? prev[j] : inf, (j > 0) ? cur[j - 1] : inf,
+           (i > 0 && j > 0) ? prev[j - 1] : inf});
+      }
+      cur[j] = std::max(d, reach);
+      row_min = std::min(row_min, cur[j]);
+    }
+    // Every coupling passes this row => distance is at least its minimum
+    if (row_min >= thr) {
+      return row_min;
+    }
+    // Reuse the row before as current row (only its band was set)
+    std::swap(prev, cur);
+    if (i > 0) {
+      std::fill(cur.begin() + lo(i - 1), cur.begin() + hi(i - 1) + 1, inf);
+    }
+  }
+  return prev[m - 1];
 }
 
 /**********************************************
@@ -1146,19 +2012,18 @@ void cmatching::set_z_zero(lanelet::LineString3d & ls)
 /*******************************************************************
  * Convert vector of linestring segments to a single linestring
  ********************************************************************/
-lanelet::LineString3d cmatching::ls_seg2string(const lanelet::LineStrings3d & ls)
+template <typename PlineT>
+lanelet::LineString3d cmatching::ls_seg2string(const PlineT & ls)
 {
-  // Create connected linestring from segments
-  lanelet::LineString3d ls_(lanelet::utils::getId(), {});
+  // Create connected linestring from segments (scratch, no ids)
+  lanelet::LineString3d ls_(lanelet::InvalId, {});
 
   // Take first point from segment and add it to linestring
   for (const auto & seg : ls) {
-    ls_.push_back(
-      lanelet::Point3d(lanelet::utils::getId(), seg.front().x(), seg.front().y(), seg.front().z()));
+    ls_.push_back(lanelet::Point3d(lanelet::InvalId, seg.front().basicPoint()));
   }
   // Take last point and add it since it was not considered so far
-  ls_.push_back(lanelet::Point3d(
-    lanelet::utils::getId(), ls.back().back().x(), ls.back().back().y(), ls.back().back().z()));
+  ls_.push_back(lanelet::Point3d(lanelet::InvalId, ls.back().back().basicPoint()));
   return ls_;
 }
 
@@ -1196,3 +2061,14 @@ void cmatching::swap_tags(lanelet::LineString3d & ls)
     ++i;
   }
 }
+
+/***************************************************************************
+ * Explicit instantiations of private steps tested by the unit tests
+ * (see test/test_matching.cpp)
+ ****************************************************************************/
+template bool cmatching::select_candidate<s_param_scoring>(
+  const lanelet::LineStrings3d & ref, const scratch_plines & candidates, size_t & ind,
+  s_measures & measures, const s_param_scoring & scoring);
+template double cmatching::frechet_rows<std::pmr::vector<lanelet::BasicPoint2d>>(
+  const std::pmr::vector<lanelet::BasicPoint2d> & pts1,
+  const std::pmr::vector<lanelet::BasicPoint2d> & pts2, const double thr);
@@ -0,0 +1,173 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "partition.hpp"
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**************/
+/*Constructors*/
+/**************/
+
+cpartition::cpartition()
+{
+}
+
+/****************/
+/*public methods*/
+/****************/
+
+/*****************************************************************************************
+ * Match the reference linestrings against every road class of the openstreetmap-network
+ * in parallel with class-specific buffer parameters and scoring profiles
+ * => reference polylines claimed by multiple classes are assigned to the match with the
+ *    smallest discrete Frechet distance (comparable across the class-specific profiles)
+ ******************************************************************************************/
+bool cpartition::partitioned_matching(
+  rclcpp::Node & node, lanelet::LineStrings3d & src, const lanelet::LineStrings3d & osm,
+  const lanelet::ConstLineStrings3d & motorways, const lanelet::ConstLineStrings3d & highways,
+  const lanelet::ConstLineStrings3d & roads, std::vector<s_match> & matches)
+{
+  // Road classes (order decides ties when merging)
+  std::vector<s_road_class> classes;
+  classes.push_back(create_class(node, "motorway", osm, motorways));
+  classes.push_back(create_class(node, "highway", osm, highways));
+  classes.push_back(create_class(node, "road", osm, roads));
+  for (const auto & cl : classes) {
+    if (cl.profile.empty()) {
+      return false;
+    }
+  }
+
+  // Reference segments are split once and shared by the matchings of all classes
+  // => every class only searches its own (smaller) set of candidate segments
+  cmatching matching;
+  const s_seg_table src_seg = matching.split_lss(node, src);
+  std::cout << "\033[33m~~~~~> Matching road classes (motorway/highway/road: "
+            << classes[0].osm.size() << "/" << classes[1].osm.size() << "/"
+            << classes[2].osm.size() << " linestrings)\033[0m" << std::endl;
+
+  // Match road classes in parallel (one job per class)
+  // => workers only see the cancellation before each class, progress is reported by this thread
+  parallel_for(
+    classes.size(), static_cast<int>(classes.size()),
+    [&](const size_t c) {
+      if (cancelled()) {
+        return;
+      }
+      cmatching worker;
+      const s_seg_table target_seg = worker.split_target(node, classes[c].osm);
+      classes[c].valid = worker.match_segments(
+        node, src_seg, target_seg, classes[c].buffer, classes[c].profile, classes[c].matches);
+    },
+    [&](const size_t done) {
+      update("partitioned_matching", static_cast<double>(done) / classes.size());
+    });
+  if (cancelled()) {
+    std::cout << "\033[33m~~~~~> Partitioned matching cancelled!\033[0m" << std::endl;
+    return false;
+  }
+
+  if (!merge_classes(classes, matches)) {
+    return false;
+  }
+  matching.print_stats(node, matches);
+  return true;
+}
+
+/*****************/
+/*private methods*/
+/*****************/
+
+/************************************************************************
+ * Create road class with the openstreetmap-linestrings contained in
+ * its (const) linestrings and its parameters from the parameter file
+ *************************************************************************/
+s_road_class cpartition::create_class(
+  rclcpp::Node & node, const std::string & name, const lanelet::LineStrings3d & osm,
+  const lanelet::ConstLineStrings3d & class_lss)
+{
+  s_road_class cl;
+  cl.name = name;
+
+  // Buffer parameters [V, P, rad] and scoring profile of the class
+  const std::vector<double> buffer =
+    node.get_parameter("partition_buffer_" + name).as_double_array();
+  if (buffer.size() != 3) {
+    std::cerr << "\033[1;31m!! partition_buffer_" << name
+              << " needs 3 values [buffer_V, buffer_P, buffer_rad] !!\033[0m" << std::endl;
+    return cl;
+  }
+  cl.buffer = {buffer[0], buffer[1], buffer[2]};
+  cl.profile = node.get_parameter("partition_profile_" + name).as_string();
+
+  // Mutable linestrings of the class (segments keep their attributes)
+  std::unordered_set<lanelet::Id> ids;
+  for (const auto & ls : class_lss) {
+    ids.insert(ls.id());
+  }
+  for (const auto & ls : osm) {
+    if (ids.count(ls.id())) {
+      cl.osm.push_back(ls);
+    }
+  }
+  return cl;
+}
+
+/**************************************************************************
+ * Merge matches of the road classes
+ * => reference polylines are the same for all classes (same segments)
+ * => polylines matched in multiple classes keep the match with the smallest
+ *    discrete Frechet distance (first class on a tie: motorway, highway, road)
+ ***************************************************************************/
+bool cpartition::merge_classes(
+  const std::vector<s_road_class> & classes, std::vector<s_match> & matches)
+{
+  for (const auto & cl : classes) {
+    if (!cl.valid || cl.matches.size() != classes.front().matches.size()) {
+      std::cerr << "\033[1;31m" << __FUNCTION__ << ": Matching of road class " << cl.name
+                << " incomplete!\033[0m" << std::endl;
+      return false;
+    }
+  }
+
+  // Keep the match with the smallest Frechet distance of each reference polyline
+  // => scores of different classes are not comparable (class-specific scoring profiles),
+  //    the Frechet distance is set for every match (scored or as additional statistic)
+  // => unmatched polyline if no class found a match
+  for (size_t i = 0; i < classes.front().matches.size(); ++i) {
+    size_t best = 0;
+    bool matched = false;
+    for (size_t c = 0; c < classes.size(); ++c) {
+      const s_match & match = classes[c].matches[i];
+      if (
+        !match.target_pline().empty() &&
+        (!matched || match.d_frechet() < classes[best].matches[i].d_frechet())) {
+        best = c;
+        matched = true;
+      }
+    }
+    matches.push_back(classes[best].matches[i]);
+  }
+  return true;
+}
@@ -0,0 +1,266 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**************/
+/*Constructors*/
+/**************/
+
+csweep::csweep()
+{
+}
+
+/****************/
+/*public methods*/
+/****************/
+
+/*****************************************************************************************
+ * Read parameter sets from a sweep file with lines "param value_1 value_2 ..."
+ * => grid: all combinations of the values, list: i-th values of all lines form set i
+ * => parameters not contained in the file keep the values of the parameter file
+ ******************************************************************************************/
+bool csweep::read_sets(
+  rclcpp::Node & node, const std::string & sweep_path, std::vector<s_sweep_set> & sets)
+{
+  const std::string node_name = node.get_parameter("node_name").as_string();
+  std::ifstream infile(sweep_path);
+  if (!infile.is_open()) {
+    RCLCPP_ERROR(rclcpp::get_logger(node_name), "Couldn't open sweep file!");
+    return false;
+  }
+
+  // Parameter set of the parameter file
+  s_sweep_set base;
+  base.buffer = {
+    node.get_parameter("buffer_V").as_double(), node.get_parameter("buffer_P").as_double(),
+    node.get_parameter("buffer_rad").as_double()};
+  base.profile = s_param_scoring(node).profile();
+
+  // Read swept parameters and their values (lines starting with # are comments)
+  std::vector<std::pair<std::string, std::vector<double>>> values;
+  std::string line;
+  while (std::getline(infile, line)) {
+    std::istringstream iss(line);
+    std::string name, token;
+    if (!(iss >> name) || name.front() == '#') {
+      continue;
+    }
+    if (!set_value(base, name)) {
+      RCLCPP_ERROR(rclcpp::get_logger(node_name), "Parameter %s can't be swept!", name.c_str());
+      return false;
+    }
+    std::vector<double> vals;
+    while (iss >> token) {
+      try {
+        vals.push_back(std::stod(token));
+      } catch (const std::exception &) {
+        RCLCPP_ERROR(rclcpp::get_logger(node_name), "Sweep file in wrong format!");
+        return false;
+      }
+    }
+    if (vals.empty()) {
+      RCLCPP_ERROR(rclcpp::get_logger(node_name), "No values for %s in sweep file!", name.c_str());
+      return false;
+    }
+    values.push_back(std::make_pair(name, vals));
+  }
+
+  const std::string combine = node.get_parameter("sweep_combine").as_string();
+  if (combine == "list") {
+    // i-th values of all parameters form set i
+    const size_t n = values.empty() ? 1 : values.front().second.size();
+    for (const auto & val : values) {
+      if (val.second.size() != n) {
+        RCLCPP_ERROR(rclcpp::get_logger(node_name), "Different numbers of values in sweep list!");
+        return false;
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      s_sweep_set set = base;
+      for (const auto & val : values) {
+        *set_value(set, val.first) = val.second[i];
+      }
+      sets.push_back(set);
+    }
+    return true;
+  }
+  if (combine != "grid") {
+    std::cerr << "\033[1;31m!! Unknown sweep_combine " << combine << " => using grid !!\033[0m"
+              << std::endl;
+  }
+
+  // All combinations of the values (values of the last parameter vary fastest)
+  std::vector<size_t> ind(values.size(), 0);
+  while (true) {
+    s_sweep_set set = base;
+    for (size_t k = 0; k < values.size(); ++k) {
+      *set_value(set, values[k].first) = values[k].second[ind[k]];
+    }
+    sets.push_back(set);
+
+    size_t k = values.size();
+    while (k > 0 && ++ind[k - 1] == values[k - 1].second.size()) {
+      ind[k - 1] = 0;
+      --k;
+    }
+    if (k == 0) {
+      break;
+    }
+  }
+  return true;
+}
+
+/*****************************************************************************************
+ * Collapse the lanelet map and split both networks once and match all parameter sets in
+ * parallel against the shared segment tables
+ * => matching statistics (see cmatching::matching_stats) per set in the order of sets
+ ******************************************************************************************/
+bool csweep::sweep(
+  rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr, const lanelet::LineStrings3d & osm,
+  const std::vector<s_sweep_set> & sets, std::vector<std::vector<double>> & stats)
+{
+  if (!map_ptr) {
+    std::cerr << "\033[1;31m" << __FUNCTION__ << ": No map received!\033[0m" << std::endl;
+    return false;
+  }
+  const int sweep_threads = node.get_parameter("sweep_threads").as_int();
+
+  // Preprocessing independent of the swept parameters
+  // => collapsed lanelet map and segment tables are only read by the matchings
+  cmatching matching;
+  lanelet::LineStrings3d ll_coll;
+  lanelet::LineStrings3d osm_lss = osm;
+  matching.collapse_ll_map(map_ptr, ll_coll);
+  const s_seg_table src_seg = matching.split_lss(node, ll_coll);
+  const s_seg_table target_seg = matching.split_target(node, osm_lss);
+  std::cout << "\033[33m~~~~~> Matching " << sets.size() << " parameter sets ("
+            << src_seg.size() << " reference/" << target_seg.size() << " target segments)\033[0m"
+            << std::endl;
+
+  // Match parameter sets in parallel
+  // => each worker thread reuses its matching (scratch memory) for all of its sets
+  // => workers only see the cancellation before each set, progress is reported by this thread
+  stats.assign(sets.size(), std::vector<double>());
+  parallel_for(
+    sets.size(), sweep_threads,
+    [&](const size_t s) {
+      if (cancelled()) {
+        return;
+      }
+      thread_local cmatching worker;
+      std::vector<s_match> matches;
+      if (worker.match_segments(
+            node, src_seg, target_seg, sets[s].buffer, sets[s].profile, matches)) {
+        stats[s] = worker.matching_stats(node, matches);
+        stats[s].insert(stats[s].begin(), static_cast<double>(matches.size()));
+      }
+    },
+    [&](const size_t done) { update("sweep", static_cast<double>(done) / sets.size()); });
+  if (cancelled()) {
+    std::cout << "\033[33m~~~~~> Sweep cancelled!\033[0m" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/************************************************************************
+ * Write parameter sets and their matching statistics as table in the
+ * format (header line with the column names):
+ * "set buffer_V ... w_frechet n_plines mean_len ... d_frechet\n"
+ *************************************************************************/
+bool csweep::write_table(
+  rclcpp::Node & node, const std::string & table_path, const std::vector<s_sweep_set> & sets,
+  const std::vector<std::vector<double>> & stats)
+{
+  const std::string node_name = node.get_parameter("node_name").as_string();
+  std::ofstream file(table_path);
+  if (!file.is_open()) {
+    RCLCPP_ERROR(rclcpp::get_logger(node_name), "Couldn't open file for sweep table!");
+    return false;
+  }
+  file.precision(10);
+  file << "set buffer_V buffer_P buffer_rad lim_angle lim_length lim_chord lim_poly "
+          "lim_frechet w_angle w_length w_chord w_poly w_frechet n_plines mean_len filtered "
+          "unmatched d_angle d_length d_chord d_poly score precision d_frechet"
+       << std::endl;
+  for (size_t s = 0; s < sets.size(); ++s) {
+    const s_buffer_params & buf = sets[s].buffer;
+    const s_score_profile & p = sets[s].profile;
+    file << s << " " << buf.V << " " << buf.P << " " << buf.rad << " " << p.lim_angle << " "
+         << p.lim_length << " " << p.lim_chord << " " << p.lim_poly << " " << p.lim_frechet << " "
+         << p.w_angle << " " << p.w_len << " " << p.w_chord << " " << p.w_poly << " "
+         << p.w_frechet;
+    for (const auto & val : stats[s]) {
+      file << " " << val;
+    }
+    file << std::endl;
+  }
+  file.close();
+  return true;
+}
+
+/*****************/
+/*private methods*/
+/*****************/
+
+/**************************************************************
+ * Get value of a parameter set by the name of the parameter
+ * => nullptr if the parameter can't be swept
+ ***************************************************************/
+double * csweep::set_value(s_sweep_set & set, const std::string & name)
+{
+  if (name == "buffer_V") {
+    return &set.buffer.V;
+  } else if (name == "buffer_P") {
+    return &set.buffer.P;
+  } else if (name == "buffer_rad") {
+    return &set.buffer.rad;
+  } else if (name == "lim_angle") {
+    return &set.profile.lim_angle;
+  } else if (name == "lim_length") {
+    return &set.profile.lim_length;
+  } else if (name == "lim_chord") {
+    return &set.profile.lim_chord;
+  } else if (name == "lim_poly") {
+    return &set.profile.lim_poly;
+  } else if (name == "w_angle") {
+    return &set.profile.w_angle;
+  } else if (name == "w_length") {
+    return &set.profile.w_len;
+  } else if (name == "w_chord") {
+    return &set.profile.w_chord;
+  } else if (name == "w_poly") {
+    return &set.profile.w_poly;
+  } else if (name == "lim_frechet") {
+    return &set.profile.lim_frechet;
+  } else if (name == "w_frechet") {
+    return &set.profile.w_frechet;
+  }
+  return nullptr;
+}
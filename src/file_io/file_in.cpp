@@ -20,11 +20,17 @@
 //
 #include "file_in.hpp"
 
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 /**************/
@@ -52,7 +58,7 @@ bool cfile_in::read_traj_GPS_from_file(
   const std::string node_name = node.get_parameter("node_name").as_string();
   lanelet::GPSPoint gps_pt;
   lanelet::BasicPoint3d pt_basic;
-  lanelet::LineString3d ls(lanelet::utils::getId(), {});
+  lanelet::LineString3d ls(next_id(), {});
 
   // Read trajectory in GPS format
   double lat, lon;
@@ -77,7 +83,11 @@ bool cfile_in::read_traj_GPS_from_file(
   int num_points = traj_GPS.size();
 
   double orig_lat, orig_lon;
-  if (node.get_parameter("customZeroPoint").as_bool()) {
+  if (node.has_parameter("orig_lat")) {
+    // Keep origin of a previously loaded trajectory (e.g. previous request in service mode)
+    orig_lat = node.get_parameter("orig_lat").as_double();
+    orig_lon = node.get_parameter("orig_lon").as_double();
+  } else if (node.get_parameter("customZeroPoint").as_bool()) {
     orig_lat = node.get_parameter("zeroLat").as_double();
     orig_lon = node.get_parameter("zeroLong").as_double();
   } else {
@@ -94,13 +104,20 @@ bool cfile_in::read_traj_GPS_from_file(
   min_lon = *std::min_element(lon_vec.begin(), lon_vec.end());
   max_lon = *std::max_element(lon_vec.begin(), lon_vec.end());
 
-  node.declare_parameter("orig_lat", orig_lat);
-  node.declare_parameter("orig_lon", orig_lon);
+  if (!node.has_parameter("orig_lat")) {
+    node.declare_parameter("orig_lat", orig_lat);
+    node.declare_parameter("orig_lon", orig_lon);
 
-  node.declare_parameter("min_lat", min_lat);
-  node.declare_parameter("max_lat", max_lat);
-  node.declare_parameter("min_lon", min_lon);
-  node.declare_parameter("max_lon", max_lon);
+    node.declare_parameter("min_lat", min_lat);
+    node.declare_parameter("max_lat", max_lat);
+    node.declare_parameter("min_lon", min_lon);
+    node.declare_parameter("max_lon", max_lon);
+  } else {
+    node.set_parameter(rclcpp::Parameter("min_lat", min_lat));
+    node.set_parameter(rclcpp::Parameter("max_lat", max_lat));
+    node.set_parameter(rclcpp::Parameter("min_lon", min_lon));
+    node.set_parameter(rclcpp::Parameter("max_lon", max_lon));
+  }
 
   // Project trajectory
   lanelet::GPSPoint position{orig_lat, orig_lon};
@@ -110,14 +127,14 @@ bool cfile_in::read_traj_GPS_from_file(
     lanelet::projection::MGRSProjector projector;
     for (int i = 0; i < num_points; i++) {
       pt_basic = projector.forward(traj_GPS[i]);
-      lanelet::Point3d pt(lanelet::utils::getId(), pt_basic.x(), pt_basic.y(), pt_basic.z());
+      lanelet::Point3d pt(next_id(), pt_basic.x(), pt_basic.y(), pt_basic.z());
       ls.push_back(pt);
     }
   } else if (proj_type == "UTM") {
     lanelet::projection::UtmProjector projector{orig};
     for (int i = 0; i < num_points; i++) {
       pt_basic = projector.forward(traj_GPS[i]);
-      lanelet::Point3d pt(lanelet::utils::getId(), pt_basic.x(), pt_basic.y(), pt_basic.z());
+      lanelet::Point3d pt(next_id(), pt_basic.x(), pt_basic.y(), pt_basic.z());
       ls.push_back(pt);
     }
   } else {
@@ -136,7 +153,7 @@ bool cfile_in::read_poses_SLAM_from_file(
   rclcpp::Node & node, const std::string & poses_path, lanelet::ConstLineString3d & poses)
 {
   const std::string node_name = node.get_parameter("node_name").as_string();
-  lanelet::LineString3d ls(lanelet::utils::getId(), {});
+  lanelet::LineString3d ls(next_id(), {});
   // Read poses
   double x, y, z;
   float r1, r2, r3, r4, r5, r6, r7, r8, r9;
@@ -151,7 +168,7 @@ bool cfile_in::read_poses_SLAM_from_file(
       RCLCPP_ERROR(rclcpp::get_logger(node_name), "Poses in wrong format!");
       return false;
     }
-    lanelet::Point3d pt(lanelet::utils::getId(), x, y, z);
+    lanelet::Point3d pt(next_id(), x, y, z);
     ls.push_back(pt);
   }
   poses = ls;
@@ -264,3 +281,131 @@ bool cfile_in::download_osm_file(rclcpp::Node & node, const std::string & file_p
     return false;
   }
 }
+
+/************************************************************************
+ * Read match table of a previous run in the format:
+ * "ll_id_1 ll_id_2 ... ; osm_id_1 osm_id_2 ...\n"
+ *************************************************************************/
+bool cfile_in::read_match_table(
+  rclcpp::Node & node, const std::string & table_path, std::vector<s_match_record> & table)
+{
+  const std::string node_name = node.get_parameter("node_name").as_string();
+  std::ifstream infile(table_path);
+  if (!infile.is_open()) {
+    RCLCPP_ERROR(rclcpp::get_logger(node_name), "Couldn't open match table!");
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(infile, line)) {
+    std::istringstream iss(line);
+    std::string token;
+    s_match_record rec;
+    bool osm = false;
+    while (iss >> token) {
+      if (token == ";") {
+        osm = true;
+        continue;
+      }
+      try {
+        (osm) ? rec.osm_ids.push_back(std::stoll(token)) : rec.ll_ids.push_back(std::stoll(token));
+      } catch (const std::exception &) {
+        RCLCPP_ERROR(rclcpp::get_logger(node_name), "Match table in wrong format!");
+        return false;
+      }
+    }
+    if (!rec.ll_ids.empty()) {
+      table.push_back(rec);
+    }
+  }
+  return true;
+}
+
+/***************************************************************************************
+ * Apply an OsmChange-diff (.osc) to an openstreetmap-excerpt (.osm) and write the
+ * updated excerpt to out_path (input excerpt is kept)
+ * => return ids of all created/modified/deleted ways and of ways with modified nodes
+ ****************************************************************************************/
+bool cfile_in::apply_osm_change(
+  rclcpp::Node & node, const std::string & osm_path, const std::string & osc_path,
+  const std::string & out_path, lanelet::Ids & ways)
+{
+  namespace pt = boost::property_tree;
+  const std::string node_name = node.get_parameter("node_name").as_string();
+
+  pt::ptree osm, osc;
+  try {
+    pt::read_xml(osm_path, osm, pt::xml_parser::trim_whitespace);
+    pt::read_xml(osc_path, osc, pt::xml_parser::trim_whitespace);
+  } catch (const pt::xml_parser_error & e) {
+    RCLCPP_ERROR_STREAM(rclcpp::get_logger(node_name), "Error during diff loading: " << e.what());
+    return false;
+  }
+  if (!osm.get_child_optional("osm") || !osc.get_child_optional("osmChange")) {
+    RCLCPP_ERROR(rclcpp::get_logger(node_name), "Provided files are no .osm/.osc files!");
+    return false;
+  }
+  pt::ptree & root = osm.get_child("osm");
+
+  // Index elements of excerpt by type and id (iterators stay valid on erase of other elements)
+  std::map<std::pair<std::string, lanelet::Id>, pt::ptree::iterator> index;
+  for (auto it = root.begin(); it != root.end(); ++it) {
+    if (it->first == "node" || it->first == "way" || it->first == "relation") {
+      index[{it->first, it->second.get<lanelet::Id>("<xmlattr>.id")}] = it;
+    }
+  }
+
+  // Apply changes
+  std::unordered_set<lanelet::Id> ways_changed, nodes_changed;
+  for (const auto & action : osc.get_child("osmChange")) {
+    if (action.first != "create" && action.first != "modify" && action.first != "delete") {
+      continue;
+    }
+    for (const auto & ele : action.second) {
+      if (ele.first != "node" && ele.first != "way" && ele.first != "relation") {
+        continue;
+      }
+      const lanelet::Id id = ele.second.get<lanelet::Id>("<xmlattr>.id");
+      auto it = index.find({ele.first, id});
+      if (action.first == "delete") {
+        if (it != index.end()) {
+          root.erase(it->second);
+          index.erase(it);
+        }
+      } else if (it != index.end()) {
+        it->second->second = ele.second;
+      } else {
+        index[{ele.first, id}] = root.insert(root.end(), ele);
+      }
+      if (ele.first == "way") {
+        ways_changed.insert(id);
+      } else if (ele.first == "node") {
+        nodes_changed.insert(id);
+      }
+    }
+  }
+
+  // Ways whose geometry changed due to modified nodes
+  for (const auto & ele : root) {
+    if (ele.first != "way") {
+      continue;
+    }
+    for (const auto & nd : ele.second) {
+      if (nd.first == "nd" && nodes_changed.count(nd.second.get<lanelet::Id>("<xmlattr>.ref"))) {
+        ways_changed.insert(ele.second.get<lanelet::Id>("<xmlattr>.id"));
+        break;
+      }
+    }
+  }
+  ways.assign(ways_changed.begin(), ways_changed.end());
+  std::sort(ways.begin(), ways.end());
+
+  // Write updated excerpt => base for the next diff
+  try {
+    pt::write_xml(out_path, osm, std::locale(), pt::xml_writer_make_settings<std::string>(' ', 2));
+  } catch (const pt::xml_parser_error & e) {
+    RCLCPP_ERROR_STREAM(rclcpp::get_logger(node_name), "Error during diff writing: " << e.what());
+    return false;
+  }
+  return true;
+}
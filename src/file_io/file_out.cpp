@@ -19,7 +19,9 @@
 //
 #include "file_out.hpp"
 
+#include <fstream>
 #include <string>
+#include <vector>
 
 /**************/
 /*Constructors*/
@@ -86,3 +88,30 @@ bool cfile_out::write_map_to_path(
   }
   return true;
 }
+
+/************************************************************************
+ * Write match table for incremental updates in the format:
+ * "ll_id_1 ll_id_2 ... ; osm_id_1 osm_id_2 ...\n"
+ *************************************************************************/
+bool cfile_out::write_match_table(
+  rclcpp::Node & node, const std::string & table_path, const std::vector<s_match_record> & table)
+{
+  const std::string node_name = node.get_parameter("node_name").as_string();
+  std::ofstream file(table_path);
+  if (!file.is_open()) {
+    RCLCPP_ERROR(rclcpp::get_logger(node_name), "Couldn't open file for match table!");
+    return false;
+  }
+  for (const auto & rec : table) {
+    for (const auto & id : rec.ll_ids) {
+      file << id << " ";
+    }
+    file << ";";
+    for (const auto & id : rec.osm_ids) {
+      file << " " << id;
+    }
+    file << std::endl;
+  }
+  file.close();
+  return true;
+}
@@ -0,0 +1,81 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include <lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <tum_lanelet2_osm_fusion/srv/fuse_trajectory.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**********************************************************************************
+ * Local client for the fusion service (pipeline_mode: service)
+ * => usage: fuse_client <traj_path> <poses_path> [out_path]
+ ***********************************************************************************/
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  const std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+  if (args.size() < 3) {
+    std::cerr << "Usage: fuse_client <traj_path> <poses_path> [out_path]" << std::endl;
+    rclcpp::shutdown();
+    return 1;
+  }
+  auto node = std::make_shared<rclcpp::Node>("fuse_client");
+  auto client = node->create_client<tum_lanelet2_osm_fusion::srv::FuseTrajectory>("lof/fuse");
+
+  while (!client->wait_for_service(std::chrono::seconds(1))) {
+    if (!rclcpp::ok()) {
+      rclcpp::shutdown();
+      return 1;
+    }
+    std::cout << "\033[33m~~~~~> Waiting for service lof/fuse...\033[0m" << std::endl;
+  }
+
+  auto request = std::make_shared<tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request>();
+  request->traj_path = args[1];
+  request->poses_path = args[2];
+  request->out_path = (args.size() > 3) ? args[3] : "";
+
+  const auto start = std::chrono::steady_clock::now();
+  auto future = client->async_send_request(request);
+  if (rclcpp::spin_until_future_complete(node, future) != rclcpp::FutureReturnCode::SUCCESS) {
+    std::cerr << "\033[1;31m!! Service call failed !!\033[0m" << std::endl;
+    rclcpp::shutdown();
+    return 1;
+  }
+  const auto response = future.get();
+  const double dt =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (response->success) {
+    lanelet::LaneletMapPtr map_ptr = std::make_shared<lanelet::LaneletMap>();
+    lanelet::utils::conversion::fromBinMsg(response->map, map_ptr);
+    std::cout << "\033[1;36m===> " << response->message << " received after " << dt << " s ("
+              << map_ptr->laneletLayer.size() << " lanelets deserialized)\033[0m" << std::endl;
+  } else {
+    std::cerr << "\033[1;31m!! " << response->message << " !!\033[0m" << std::endl;
+  }
+  rclcpp::shutdown();
+  return response->success ? 0 : 1;
+}
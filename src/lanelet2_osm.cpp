@@ -20,8 +20,16 @@
 //
 #include "lanelet2_osm.hpp"
 
+#include <rclcpp_components/register_node_macro.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -31,11 +39,15 @@
 
 /***************************************************************
  * Main constructor to be called after the node was triggered
- * => calls all member functions
+ * => starts the pipeline on a background thread once the
+ *    executor is spinning
+ * => "lanelet2_osm" is only the default name, the name assigned
+ *    by a launch file/container (remapping) is used everywhere
  ****************************************************************/
-clanelet2_osm::clanelet2_osm(const std::string & name) : Node(name)
+clanelet2_osm::clanelet2_osm(const rclcpp::NodeOptions & options) : Node("lanelet2_osm", options)
 {
-  this->node_name = name;
+  // Remapped name of the node (e.g. name of the ComposableNode)
+  this->node_name = this->get_name();
   this->declare_parameter("node_name", node_name);
 
   // Load parameters from command line and config file
@@ -46,53 +58,269 @@ clanelet2_osm::clanelet2_osm(const std::string & name) : Node(name)
   // Initialize publishers
   initialize_publisher();
 
-  // Load trajectory, SLAM poses, ref map and download osm-data
-  load_data();
+  // Analysis data is written on a background thread while the pipeline continues
+  if (this->get_parameter("analysis_async").as_bool()) {
+    m_analysis.start_writer(this->get_parameter("analysis_queue_size").as_int());
+  }
 
-  // Extract road network
-  get_network();
+  // Progress report and cancellation of long running modules
+  m_rubber_sheeting.set_progress(&this->progress);
+  m_matching.set_progress(&this->progress);
+  m_conflation.set_progress(&this->progress);
+  m_tiling.set_progress(&this->progress);
+  m_partition.set_progress(&this->progress);
+  m_incremental.set_progress(&this->progress);
+  m_sweep.set_progress(&this->progress);
 
-  // Align GPS and SLAM trajectory
-  align_traj();
+  // Cancellation in separate callback group => served while the pipeline is running
+  this->cb_group_cancel =
+    this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+  this->srv_cancel = this->create_service<std_srvs::srv::Trigger>(
+    "lof/cancel",
+    std::bind(
+      &clanelet2_osm::cancel_callback, this, std::placeholders::_1, std::placeholders::_2),
+    rmw_qos_profile_services_default, this->cb_group_cancel);
 
-  // Publish trajectory to select control Points for Rubber-Sheeting
-  publish_traj();
+  // Long-lived service => pipeline is executed on request
+  this->pipeline_mode = this->get_parameter("pipeline_mode").as_string();
+  if (this->pipeline_mode == "service") {
+    initialize_service();
+    return;
+  }
 
-  // Perform rubber-sheeting to further transform traj and map
-  rubber_sheeting();
+  // Start pipeline on background thread once the executor is spinning
+  this->start_timer = this->create_wall_timer(std::chrono::milliseconds(0), [this]() {
+    this->start_timer->cancel();
+    this->pipeline_thread = std::thread(&clanelet2_osm::run_pipeline, this);
+  });
+}
 
-  // Publish rubber-sheeting data
-  publish_rs();
+clanelet2_osm::~clanelet2_osm()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->requests_mutex);
+    this->requests_stop = true;
+  }
+  this->requests_cv.notify_all();
+  this->progress.cancel = true;
+  if (this->pipeline_thread.joinable()) {
+    this->pipeline_thread.join();
+  }
+  // Await analysis data staged during the pipeline
+  if (m_analysis.wait() > 0) {
+    std::cout << "\033[1;36m===> Analysis calculations saved in "
+              << this->get_parameter("analysis_output_dir").as_string() << "/ !\033[0m"
+              << std::endl;
+  }
+}
 
-  // Conflation
-  conflation();
+/****************/
+/*public methods*/
+/****************/
 
-  // Publish data
-  publish_map();
+/*****************************************************************
+ * Execute the pipeline of the selected mode stage by stage
+ * => runs on the background thread started by the constructor
+ ******************************************************************/
+void clanelet2_osm::run_pipeline()
+{
+  std::vector<std::pair<std::string, std::function<bool()>>> stages;
+  if (this->pipeline_mode == "osm_update" || this->pipeline_mode == "drive_update") {
+    // Incremental update of a previously fused map from an OsmChange-diff or a new drive
+    if (this->pipeline_mode == "osm_update") {
+      stages.push_back({"osm_update", [this]() { return osm_update(); }});
+    } else {
+      stages.push_back({"drive_update", [this]() { return drive_update(); }});
+    }
+    stages.push_back({"publish_map", [this]() { return publish_map(); }});
+    stages.push_back({"write_map", [this]() { return write_map(); }});
+  } else if (this->pipeline_mode == "sweep") {
+    // Matching statistics of multiple parameter sets (no conflation)
+    stages = {
+      {"load_data", [this]() { return load_data(); }},
+      {"get_network", [this]() { return get_network(); }},
+      {"align_traj", [this]() { return align_traj(); }},
+      {"rubber_sheeting", [this]() { return rubber_sheeting(); }},
+      {"sweep", [this]() { return sweep(); }}};
+  } else {
+    stages = {
+      {"load_data", [this]() { return load_data(); }},
+      {"get_network", [this]() { return get_network(); }},
+      {"align_traj", [this]() { return align_traj(); }},
+      {"publish_traj", [this]() { return publish_traj(); }},
+      {"rubber_sheeting", [this]() { return rubber_sheeting(); }},
+      {"publish_rs", [this]() { return publish_rs(); }},
+      {"conflation", [this]() { return conflation(); }},
+      {"publish_map", [this]() { return publish_map(); }},
+      {"write_map", [this]() { return write_map(); }},
+      {"analysis", [this]() { return analysis(); }}};
+  }
+
+  if (run_stages(stages)) {
+    std::cout << "\033[1;36m===> Done!\033[0m" << std::endl;
+  }
+}
 
-  // Write map to file
-  write_map();
+/**************************************************************************
+ * Execute stages in order, publish progress and check for cancellation
+ * between stages
+ * => stages return false on failure => remaining stages are skipped
+ * => returns false if the pipeline was cancelled or a stage failed
+ ***************************************************************************/
+bool clanelet2_osm::run_stages(
+  const std::vector<std::pair<std::string, std::function<bool()>>> & stages)
+{
+  const size_t n = stages.size();
+  for (size_t i = 0; i < n; ++i) {
+    const std::string & stage = stages[i].first;
+    if (this->progress.cancelled()) {
+      publish_progress(stage, "", i, n, 0.0, tum_lanelet2_osm_fusion::msg::Progress::CANCELLED);
+      std::cout << "\033[33m~~~~~> Pipeline cancelled before " << stage << "!\033[0m"
+                << std::endl;
+      return false;
+    }
+    // Steps reported by the modules are assigned to the current stage
+    this->progress.report = [this, stage, i, n](const std::string & step, const double fraction) {
+      publish_progress(
+        stage, step, i, n, fraction, tum_lanelet2_osm_fusion::msg::Progress::RUNNING);
+    };
+    publish_progress(stage, "", i, n, 0.0, tum_lanelet2_osm_fusion::msg::Progress::RUNNING);
+    // Marker generation outside of the stage waits until the stage released the state
+    this->state_lock = std::unique_lock<std::mutex>(this->state_mutex);
+    const bool success = stages[i].second();
+    this->state_lock.unlock();
+    if (!success && !this->progress.cancelled()) {
+      this->progress.report = nullptr;
+      publish_progress(stage, "", i, n, 0.0, tum_lanelet2_osm_fusion::msg::Progress::FAILED);
+      RCLCPP_ERROR(
+        rclcpp::get_logger(this->node_name), "!! Pipeline stopped after failed stage %s !!",
+        stage.c_str());
+      return false;
+    }
+  }
+  this->progress.report = nullptr;
 
-  // Analysis and save
-  analysis();
-  std::cout << "\033[1;36m===> Done!\033[0m" << std::endl;
+  if (this->progress.cancelled()) {
+    publish_progress(
+      stages.back().first, "", n - 1, n, 1.0, tum_lanelet2_osm_fusion::msg::Progress::CANCELLED);
+    return false;
+  }
+  publish_progress("", "", n, n, 1.0, tum_lanelet2_osm_fusion::msg::Progress::DONE);
+  return true;
 }
 
-clanelet2_osm::~clanelet2_osm()
+/***************************************************************************
+ * Publish marker array as unique pointer and leave message member empty
+ * => no copy of the (multi-MB) marker arrays with intra-process
+ *    communication in a component container
+ ****************************************************************************/
+void clanelet2_osm::publish_markers(
+  const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr & pub,
+  visualization_msgs::msg::MarkerArray & msg)
 {
+  pub->publish(std::make_unique<visualization_msgs::msg::MarkerArray>(std::move(msg)));
+  msg = visualization_msgs::msg::MarkerArray();
 }
 
-/****************/
-/*public methods*/
-/****************/
+/*****************************************************************************
+ * Mark markerarrays of topics as outdated after their data changed and
+ * generate them if requested
+ ******************************************************************************/
+void clanelet2_osm::invalidate_markers(const std::vector<std::string> & topics)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->markers_mutex);
+    for (const auto & topic : topics) {
+      this->marker_topics.at(topic).dirty = true;
+    }
+  }
+  update_markers(false);
+}
+
+/********************************************************************************
+ * Generate and publish outdated markerarrays of topics with subscribers
+ * => force: generate all outdated markerarrays (explicit request)
+ * => volatile topics (intra-process) are regenerated for new subscribers
+ *********************************************************************************/
+void clanelet2_osm::update_markers(const bool force)
+{
+  std::lock_guard<std::mutex> lock(this->markers_mutex);
+  const bool lazy = this->get_parameter("viz_lazy").as_bool();
+  const bool volatile_qos = this->get_node_options().use_intra_process_comms();
+  for (auto & [name, topic] : this->marker_topics) {
+    const size_t subs = topic.pub->get_subscription_count();
+    const bool missed = volatile_qos && subs > topic.subs;
+    topic.subs = subs;
+    if ((!topic.dirty && !missed) || (lazy && !force && subs == 0)) {
+      continue;
+    }
+    *topic.msg = visualization_msgs::msg::MarkerArray();
+    topic.build();
+    publish_markers(topic.pub, *topic.msg);
+    topic.dirty = false;
+  }
+}
+
+/*****************************************************************
+ * Generate all outdated markerarrays on request
+ ******************************************************************/
+void clanelet2_osm::markers_callback(
+  const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+  std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+{
+  (void)request;
+  std::unique_lock<std::mutex> lock(this->state_mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    response->success = false;
+    response->message = "Pipeline stage running, markers are published after the stage";
+    return;
+  }
+  update_markers(true);
+  response->success = true;
+  response->message = "Markers published";
+}
+
+/*****************************************************************
+ * Publish progress event of the pipeline on lof/progress
+ ******************************************************************/
+void clanelet2_osm::publish_progress(
+  const std::string & stage, const std::string & step, const size_t stage_index,
+  const size_t num_stages, const double fraction, const uint8_t state)
+{
+  tum_lanelet2_osm_fusion::msg::Progress msg;
+  msg.stage = stage;
+  msg.step = step;
+  msg.stage_index = stage_index;
+  msg.num_stages = num_stages;
+  msg.fraction = fraction;
+  msg.state = state;
+  this->pub_progress->publish(msg);
+}
+
+/********************************************************************
+ * Request cooperative cancellation of the running pipeline
+ *********************************************************************/
+void clanelet2_osm::cancel_callback(
+  const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+  std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+{
+  (void)request;
+  this->progress.cancel = true;
+  response->success = true;
+  response->message = "Cancellation requested";
+  std::cout << "\033[33m~~~~~> Cancellation of pipeline requested!\033[0m" << std::endl;
+}
 
 /**************************************************************
  * initialize publishers for visualization in RVIZ
  ***************************************************************/
 void clanelet2_osm::initialize_publisher()
 {
+  // Transient local durability is not supported with intra-process communication
   rclcpp::QoS durable_qos_pub{1};
-  durable_qos_pub.transient_local();
+  if (!this->get_node_options().use_intra_process_comms()) {
+    durable_qos_pub.transient_local();
+  }
 
   this->pub_traj_master_markers = this->create_publisher<visualization_msgs::msg::MarkerArray>(
     "lof/traj/traj_master_markers", durable_qos_pub);
@@ -112,6 +340,108 @@ void clanelet2_osm::initialize_publisher()
     "lof/map/ll_map_new_markers", durable_qos_pub);
   this->pub_osm_map_markers = this->create_publisher<visualization_msgs::msg::MarkerArray>(
     "lof/map/osm_map_markers", durable_qos_pub);
+  this->pub_progress =
+    this->create_publisher<tum_lanelet2_osm_fusion::msg::Progress>("lof/progress", 10);
+
+  // Generation of markerarrays (on demand)
+  // => closures read the pipeline state, only called by a stage or under state_mutex
+  this->marker_topics["traj_master"] = {
+    this->pub_traj_master_markers, &this->msg_traj_master_markers, [this]() {
+      m_msgs.linestring2marker_msg(
+        this->traj_master, this->msg_traj_master_markers, "WEBGreen", "Trajectory", 1);
+    }};
+  this->marker_topics["traj_target"] = {
+    this->pub_traj_target_markers, &this->msg_traj_target_markers, [this]() {
+      m_msgs.linestring2marker_msg(
+        this->traj_target, this->msg_traj_target_markers, "Black", "Poses", 1);
+    }};
+  this->marker_topics["traj_align"] = {
+    this->pub_traj_align_markers, &this->msg_traj_align_markers, [this]() {
+      m_msgs.linestring2marker_msg(
+        this->traj_align, this->msg_traj_align_markers, "WEBBlueDark", "Poses_align", 1);
+    }};
+  this->marker_topics["rs_geom"] = {
+    this->pub_rs_geom_markers, &this->msg_rs_geom_markers, [this]() {
+      m_msgs.rs2marker_msg(this->triangles, this->control_points, this->msg_rs_geom_markers);
+    }};
+  this->marker_topics["traj_rs"] = {
+    this->pub_traj_rs_markers, &this->msg_traj_rs_markers, [this]() {
+      m_msgs.linestring2marker_msg(
+        this->traj_rs, this->msg_traj_rs_markers, "WEBBlueBright", "traj_rubber_sheeted", 1);
+    }};
+  this->marker_topics["confl_geom"] = {
+    this->pub_confl_geom_markers, &this->msg_confl_geom_markers, [this]() {
+      m_msgs.confl2marker_msg(this->ll_collapsed, this->matches, this->msg_confl_geom_markers);
+    }};
+  this->marker_topics["ll_map"] = {
+    this->pub_ll_map_markers, &this->msg_ll_map_markers, [this]() {
+      if (this->get_parameter("viz_lod").as_bool()) {
+        m_msgs.lod_map_net2marker_msg(
+          *this, this->ll_lanelets, this->ll_regular_cols, "ll_map", this->msg_ll_map_markers);
+      } else {
+        m_msgs.col_map_net2marker_msg(
+          *this, this->ll_lanelets, this->ll_regular_lanelets, this->ll_shoulder_lanelets,
+          this->ll_stop_lines, this->ll_regular_cols, this->msg_ll_map_markers);
+      }
+    }};
+  this->marker_topics["ll_map_new"] = {
+    this->pub_ll_map_new_markers, &this->msg_ll_map_new_markers, [this]() {
+      if (this->get_parameter("viz_lod").as_bool()) {
+        m_msgs.lod_map_net2marker_msg(
+          *this, this->ll_lanelets_new, {}, "ll_map_new", this->msg_ll_map_new_markers);
+      } else {
+        m_msgs.map_net2marker_msg(
+          *this, this->ll_lanelets_new, this->ll_regular_lanelets_new,
+          this->ll_shoulder_lanelets_new, this->ll_stop_lines_new, this->msg_ll_map_new_markers);
+      }
+    }};
+  this->marker_topics["osm_map"] = {
+    this->pub_osm_map_markers, &this->msg_osm_map_markers, [this]() {
+      if (this->get_parameter("viz_lod").as_bool()) {
+        lanelet::ConstLineStrings3d osm_lss = this->osm_motorway_linestrings;
+        osm_lss.insert(
+          osm_lss.end(), this->osm_highway_linestrings.begin(),
+          this->osm_highway_linestrings.end());
+        osm_lss.insert(
+          osm_lss.end(), this->osm_road_linestrings.begin(), this->osm_road_linestrings.end());
+        m_msgs.lod_osm_net2marker_msg(*this, osm_lss, "osm", this->msg_osm_map_markers);
+      } else {
+        m_msgs.osm_net2marker_msg(
+          this->osm_motorway_linestrings, this->osm_highway_linestrings,
+          this->osm_road_linestrings, this->msg_osm_map_markers);
+      }
+    }};
+
+  // Check for subscribers of outdated markerarrays
+  // => also for new subscribers of volatile topics (no transient local with intra-process)
+  if (
+    this->get_parameter("viz_lazy").as_bool() ||
+    this->get_node_options().use_intra_process_comms()) {
+    this->markers_timer = this->create_wall_timer(
+      std::chrono::duration<double>(this->get_parameter("viz_check_period").as_double()),
+      [this]() {
+        // Skip check while a stage modifies the pipeline state (markers follow the stage)
+        std::unique_lock<std::mutex> lock(this->state_mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+          update_markers(false);
+        }
+      });
+  }
+  this->srv_markers = this->create_service<std_srvs::srv::Trigger>(
+    "lof/publish_markers", std::bind(
+                             &clanelet2_osm::markers_callback, this, std::placeholders::_1,
+                             std::placeholders::_2));
+
+  // Binary map => always transient local (latched for late joining consumers)
+  rclcpp::QoS map_qos_pub{1};
+  map_qos_pub.transient_local();
+  rclcpp::PublisherOptions map_pub_options;
+  map_pub_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+  this->pub_ll_map_new_bin = this->create_publisher<autoware_auto_mapping_msgs::msg::HADMapBin>(
+    "lof/map/ll_map_new_bin", map_qos_pub, map_pub_options);
+  this->pub_ll_map_new_bin_comp =
+    this->create_publisher<tum_lanelet2_osm_fusion::msg::CompressedMapBin>(
+      "lof/map/ll_map_new_bin_compressed", map_qos_pub, map_pub_options);
 }
 
 /********************************************************************
@@ -122,7 +452,7 @@ void clanelet2_osm::initialize_publisher()
  * Set reference and target map (defined by user as parameter)
  * => paths to files specified in command-line or launch-file
  *********************************************************************/
-void clanelet2_osm::load_data()
+bool clanelet2_osm::load_data()
 {
   lanelet::ConstLineString3d traj_GPS_proj;
   lanelet::ConstLineString3d traj_SLAM;
@@ -136,6 +466,7 @@ void clanelet2_osm::load_data()
     //  this->get_parameter("orig_lon").as_double() << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Trajectory loading !!");
+    return false;
   }
 
   // SLAM poses
@@ -144,6 +475,7 @@ void clanelet2_osm::load_data()
               << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Pose loading !!");
+    return false;
   }
 
   // Reference map
@@ -152,6 +484,7 @@ void clanelet2_osm::load_data()
     std::cout << "\033[1;36m===> Lanelet2 Map: Loaded!\033[0m" << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map loading !!");
+    return false;
   }
 
   // OSM excerpt
@@ -160,15 +493,26 @@ void clanelet2_osm::load_data()
               << "\033[0m" << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map download !!");
+    return false;
   }
   if (m_file_loader.read_map_from_file(
         *this, this->osm_path, this->proj_type, this->osm_map_lanelet_ptr)) {
     std::cout << "\033[1;36m===> OSM Map: Loaded!\033[0m" << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during OSM-map loading !!");
+    return false;
   }
 
   // Set source and target traj depending on parameter
+  return set_master(traj_GPS_proj, traj_SLAM);
+}
+
+/***********************************************************************
+ * Set master and target trajectory/map depending on master parameter
+ ************************************************************************/
+bool clanelet2_osm::set_master(
+  const lanelet::ConstLineString3d & traj_GPS_proj, const lanelet::ConstLineString3d & traj_SLAM)
+{
   if (this->get_parameter("master").as_string() == "GPS") {
     this->traj_master = traj_GPS_proj;
     this->traj_target = traj_SLAM;
@@ -183,27 +527,31 @@ void clanelet2_osm::load_data()
     this->target_map_lanelet_ptr = osm_map_lanelet_ptr;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Specify a correct master parameter !!");
+    return false;
   }
+  return true;
 }
 
 /**********************************************************************
  * Extract road networks from openstreetmap-data
  ***********************************************************************/
-void clanelet2_osm::get_network()
+bool clanelet2_osm::get_network()
 {
   if (!m_extract.osm_map_extract(
         this->osm_map_lanelet_ptr, this->osm_all_linestrings, this->osm_motorway_linestrings,
         this->osm_highway_linestrings, this->osm_road_linestrings)) {
     RCLCPP_ERROR(
       rclcpp::get_logger(this->node_name), "!! Error during road network extraction of osm map !!");
+    return false;
   }
+  return true;
 }
 
 /***********************************************************
  * Align GPS and SLAM trajectory (target to reference)
  * => use Umeyama-algorithm or ICP
  ************************************************************/
-void clanelet2_osm::align_traj()
+bool clanelet2_osm::align_traj()
 {
   // Calculate transformation
   bool btrans_al = m_align.get_transformation(
@@ -219,27 +567,24 @@ void clanelet2_osm::align_traj()
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during trajectory alignment !!");
   }
+
+  // Stage trajectories for analysis
+  if (stage_analysis("analysis_traj_matching")) {
+    std::vector<double> diff_al;
+    m_analysis.traj_alignment(
+      *this, this->traj_master, this->traj_target, this->traj_align, diff_al);
+  }
+  return btrans_al;
 }
 
 /*****************************************************************************
  * Publish reference and aligned target trajectory to select
  * control Points for Rubber-Sheeting
  ******************************************************************************/
-void clanelet2_osm::publish_traj()
+bool clanelet2_osm::publish_traj()
 {
-  // Trajectory
-  m_msgs.linestring2marker_msg(
-    this->traj_master, this->msg_traj_master_markers, "WEBGreen", "Trajectory", 1);
-  // Poses
-  m_msgs.linestring2marker_msg(
-    this->traj_target, this->msg_traj_target_markers, "Black", "Poses", 1);
-  m_msgs.linestring2marker_msg(
-    this->traj_align, this->msg_traj_align_markers, "WEBBlueDark", "Poses_align", 1);
-
-  // Publish messages on topics
-  this->pub_traj_master_markers->publish(this->msg_traj_master_markers);
-  this->pub_traj_target_markers->publish(this->msg_traj_target_markers);
-  this->pub_traj_align_markers->publish(this->msg_traj_align_markers);
+  invalidate_markers({"traj_master", "traj_target", "traj_align"});
+  return true;
 }
 
 /*************************************************************************
@@ -247,11 +592,20 @@ void clanelet2_osm::publish_traj()
  * to reference
  * => also transform corresponding map and (point cloud if desired)
  **************************************************************************/
-void clanelet2_osm::rubber_sheeting()
+bool clanelet2_osm::rubber_sheeting()
 {
-  // Get controlpoints from RVIZ
-  m_rubber_sheeting.select_control_points(
-    *this, this->traj_master, this->traj_align, this->control_points);
+  // Get controlpoints from RVIZ (set by the request in service mode)
+  // => state released while waiting for the user, so that markers are served meanwhile
+  if (this->pipeline_mode != "service") {
+    std::vector<s_control_point> cps;
+    this->state_lock.unlock();
+    m_rubber_sheeting.select_control_points(*this, this->traj_master, this->traj_align, cps);
+    this->state_lock.lock();
+    this->control_points = cps;
+  }
+  if (this->progress.cancelled()) {
+    return false;
+  }
   // Calculate triangulation and transformation matrices
   bool btrans_rs = m_rubber_sheeting.get_transformation(
     *this, this->traj_align, this->control_points, this->triangles, this->trans_rs);
@@ -272,36 +626,69 @@ void clanelet2_osm::rubber_sheeting()
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Rubber-Sheeting !!");
   }
+
+  // Stage rubber-sheeting results for analysis
+  if (stage_analysis("analysis_traj_matching")) {
+    std::vector<double> diff_rs;
+    m_analysis.traj_rubber_sheeting(
+      *this, this->traj_master, this->traj_rs, this->triangles, this->control_points, diff_rs);
+  }
+  return btrans_rs;
 }
 
 /***********************************************
  * Publish Rubber-sheeting results
  ************************************************/
-void clanelet2_osm::publish_rs()
+bool clanelet2_osm::publish_rs()
 {
-  // Create messages
-  // RS Geometry
-  m_msgs.rs2marker_msg(this->triangles, this->control_points, this->msg_rs_geom_markers);
-
-  // Transformed trajectory
-  m_msgs.linestring2marker_msg(
-    this->traj_rs, this->msg_traj_rs_markers, "WEBBlueBright", "traj_rubber_sheeted", 1);
-
-  // Publish on topics
-  this->pub_rs_geom_markers->publish(this->msg_rs_geom_markers);
-  this->pub_traj_rs_markers->publish(this->msg_traj_rs_markers);
+  invalidate_markers({"rs_geom", "traj_rs"});
+  return true;
 }
 
 /*********************************************************************
  * Perform conflation from openstreetmap to lanelet-map
  **********************************************************************/
-void clanelet2_osm::conflation()
+bool clanelet2_osm::conflation()
 {
   // Matching
   lanelet::LineStrings3d ll_coll;
-  bool coll = m_matching.collapse_ll_map(this->ll_map_lanelet_ptr, ll_coll);
+  bool coll, bG;
+  if (this->get_parameter("tiling").as_bool()) {
+    // Collapse and match spatial tiles in parallel
+    coll = bG = m_tiling.tiled_matching(
+      *this, this->ll_map_lanelet_ptr, this->osm_all_linestrings, ll_coll, this->matches);
+  } else {
+    if (!this->ll_coll_cache.empty()) {
+      // Collapsed lanelet map of a previous request (service mode, lanelet map is master)
+      ll_coll = this->ll_coll_cache;
+      coll = true;
+    } else {
+      coll = m_matching.collapse_ll_map(this->ll_map_lanelet_ptr, ll_coll);
+      if (
+        this->pipeline_mode == "service" && this->get_parameter("master").as_string() == "SLAM") {
+        this->ll_coll_cache = ll_coll;
+      }
+    }
 
-  bool bG = m_matching.buffer_growing(*this, ll_coll, this->osm_all_linestrings, this->matches);
+    if (this->get_parameter("partitioning").as_bool()) {
+      // Match road classes of openstreetmap in parallel with class-specific parameters
+      bG = m_partition.partitioned_matching(
+        *this, ll_coll, this->osm_all_linestrings, this->osm_motorway_linestrings,
+        this->osm_highway_linestrings, this->osm_road_linestrings, this->matches);
+    } else {
+      // Split and indexed segments of a cached excerpt (service mode, GPS is master)
+      m_matching.set_target_cache(this->osm_seg_cache);
+      bG = m_matching.buffer_growing(*this, ll_coll, this->osm_all_linestrings, this->matches);
+      m_matching.set_target_cache(nullptr);
+    }
+  }
+  if (this->progress.cancelled()) {
+    return false;
+  }
+  // Stage matches for analysis
+  if (stage_analysis("analysis_matching")) {
+    m_analysis.matching_results(*this, this->matches, this->osm_all_linestrings);
+  }
 
   // Conflation
   bool rmT = m_conflation.remove_tags(this->ll_map_lanelet_ptr);
@@ -315,26 +702,266 @@ void clanelet2_osm::conflation()
     std::cout << "\033[1;36m===> Finished conflation!\033[0m" << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Conflation !!");
+    return false;
   }
 
   for (const auto & ls : ll_coll) {
     this->ll_collapsed.push_back(ls);
   }
+  // Match table for later incremental updates
+  this->match_table = m_incremental.match_records(this->matches);
+  return true;
+}
+
+/*************************************************************************************
+ * Match all parameter sets of the sweep file against the once preprocessed networks
+ * and write their matching statistics as table (sweep mode)
+ **************************************************************************************/
+bool clanelet2_osm::sweep()
+{
+  std::vector<s_sweep_set> sets;
+  if (!m_sweep.read_sets(*this, this->get_parameter("sweep_path").as_string(), sets)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during reading of sweep file !!");
+    return false;
+  }
+  std::vector<std::vector<double>> stats;
+  if (!m_sweep.sweep(*this, this->ll_map_lanelet_ptr, this->osm_all_linestrings, sets, stats)) {
+    if (!this->progress.cancelled()) {
+      RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during parameter sweep !!");
+    }
+    return false;
+  }
+  const std::string table_path = this->get_parameter("sweep_table_path").as_string();
+  if (m_sweep.write_table(*this, table_path, sets, stats)) {
+    std::cout << "\033[1;36m===> Matching statistics of " << sets.size()
+              << " parameter sets written to " << table_path << "\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during sweep table writing !!");
+    return false;
+  }
+  return true;
+}
+
+/*************************************************************************************
+ * Re-conflate regions of a previously fused lanelet-map that are affected by an
+ * OsmChange-diff
+ * => match table of the previous run identifies the impacted reference polylines
+ **************************************************************************************/
+bool clanelet2_osm::osm_update()
+{
+  if (this->get_parameter("master").as_string() != "GPS") {
+    RCLCPP_ERROR(
+      rclcpp::get_logger(this->node_name), "!! osm_update requires GPS as master parameter !!");
+    return false;
+  }
+  // GPS trajectory (only origin of projection)
+  lanelet::ConstLineString3d traj_GPS_proj;
+  if (!m_file_loader.read_traj_GPS_from_file(
+        *this, this->traj_path, this->proj_type, this->traj_GPS, traj_GPS_proj)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Trajectory loading !!");
+    return false;
+  }
+
+  // Previously fused map and match table
+  if (!load_fused_map()) {
+    return false;
+  }
+
+  // Apply diff to openstreetmap-excerpt of the previous run and load it
+  lanelet::Ids ways;
+  const std::string osc_path = this->get_parameter("osc_path").as_string();
+  const std::string osc_out_path = this->get_parameter("osc_out_path").as_string();
+  if (m_file_loader.apply_osm_change(*this, this->osm_path, osc_path, osc_out_path, ways)) {
+    std::cout << "\033[33m~~~~~> OsmChange applied to " << this->osm_path << " => "
+              << osc_out_path << "\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during OsmChange loading !!");
+    return false;
+  }
+  if (m_file_loader.read_map_from_file(
+        *this, osc_out_path, this->proj_type, this->osm_map_lanelet_ptr)) {
+    std::cout << "\033[1;36m===> OSM Map: Loaded!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during OSM-map loading !!");
+    return false;
+  }
+  if (!get_network()) {
+    return false;
+  }
+
+  // Re-match and re-conflate impacted region only
+  lanelet::Lanelets region;
+  lanelet::LineStrings3d ll_coll;
+  bool reg = m_incremental.impacted_region(
+    *this, this->match_table, ways, this->osm_all_linestrings, this->ll_map_lanelet_ptr, region);
+  bool rmT = m_conflation.remove_tags(this->ll_map_lanelet_ptr);
+  bool clT = m_conflation.clear_conflated_tags(region, this->ll_regular_cols);
+  bool bG =
+    m_incremental.rematch_region(*this, region, this->osm_all_linestrings, ll_coll, this->matches);
+  if (this->progress.cancelled()) {
+    return false;
+  }
+  bool confl = m_conflation.conflate_lanelet_OSM(
+    this->ll_map_lanelet_ptr, this->matches, this->ll_regular_cols, this->to_be_deleted);
+  this->ll_map_new = std::make_shared<lanelet::LaneletMap>();
+  bool nM = m_conflation.create_updated_map(
+    this->ll_map_lanelet_ptr, this->ll_map_new, this->to_be_deleted);
+
+  if (reg && rmT && clT && bG && confl && nM) {
+    std::cout << "\033[1;36m===> Finished incremental conflation!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during incremental Conflation !!");
+    return false;
+  }
+
+  for (const auto & ls : ll_coll) {
+    this->ll_collapsed.push_back(ls);
+  }
+  m_incremental.update_table(this->match_table, region, this->matches);
+  return true;
+}
+
+/*************************************************************************************
+ * Update a previously fused lanelet-map with a new drive
+ * => check alignment residuals of the new drive, re-match and re-conflate only the
+ *    lanelets inside the corridor of the new trajectory
+ **************************************************************************************/
+bool clanelet2_osm::drive_update()
+{
+  if (this->get_parameter("master").as_string() != "GPS") {
+    RCLCPP_ERROR(
+      rclcpp::get_logger(this->node_name), "!! drive_update requires GPS as master parameter !!");
+    return false;
+  }
+  // New drive (GPS trajectory and SLAM poses)
+  lanelet::ConstLineString3d traj_GPS_proj;
+  lanelet::ConstLineString3d traj_SLAM;
+  if (!m_file_loader.read_traj_GPS_from_file(
+        *this, this->traj_path, this->proj_type, this->traj_GPS, traj_GPS_proj)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Trajectory loading !!");
+    return false;
+  }
+  if (!m_file_loader.read_poses_SLAM_from_file(*this, this->poses_path, traj_SLAM)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Pose loading !!");
+    return false;
+  }
+  this->traj_master = traj_GPS_proj;
+  this->traj_target = traj_SLAM;
+
+  // Previously fused map and match table
+  if (!load_fused_map()) {
+    return false;
+  }
+
+  // Alignment residual check of the new drive
+  std::vector<double> res;
+  if (!m_align.get_transformation(
+        *this, this->traj_master, this->traj_target, this->trans_al, this->align_type)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during trajectory alignment !!");
+    return false;
+  }
+  m_align.transform_ls(this->traj_target, this->traj_align, this->trans_al);
+  if (!m_align.residuals(this->traj_master, this->traj_align, res)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during residual calculation !!");
+    return false;
+  }
+  const double mean_res = std::accumulate(res.begin(), res.end(), 0.0) / res.size();
+  const double max_res = *std::max_element(res.begin(), res.end());
+  std::cout << "\033[33m~~~~~> Alignment residuals of new drive: mean " << mean_res << " m, max "
+            << max_res << " m\033[0m" << std::endl;
+  if (mean_res > this->get_parameter("drive_max_residual").as_double()) {
+    RCLCPP_ERROR(
+      rclcpp::get_logger(this->node_name),
+      "!! Residuals of new drive exceed drive_max_residual => run full pipeline !!");
+    return false;
+  }
+
+  // Openstreetmap-data around the new drive
+  if (m_file_loader.download_osm_file(*this, this->osm_path)) {
+    std::cout << "\033[33m~~~~~> OpenStreetMap-Download successful to " << this->osm_path
+              << "\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map download !!");
+    return false;
+  }
+  if (m_file_loader.read_map_from_file(
+        *this, this->osm_path, this->proj_type, this->osm_map_lanelet_ptr)) {
+    std::cout << "\033[1;36m===> OSM Map: Loaded!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during OSM-map loading !!");
+    return false;
+  }
+  if (!get_network()) {
+    return false;
+  }
+
+  // Re-match and re-conflate corridor only (results outside are kept from the match table)
+  lanelet::Lanelets region;
+  lanelet::LineStrings3d ll_coll;
+  bool reg = m_incremental.corridor_region(
+    *this, this->traj_master, this->match_table, this->ll_map_lanelet_ptr, region);
+  bool rmT = m_conflation.remove_tags(this->ll_map_lanelet_ptr);
+  bool clT = m_conflation.clear_conflated_tags(region, this->ll_regular_cols);
+  bool bG =
+    m_incremental.rematch_region(*this, region, this->osm_all_linestrings, ll_coll, this->matches);
+  if (this->progress.cancelled()) {
+    return false;
+  }
+  bool confl = m_conflation.conflate_lanelet_OSM(
+    this->ll_map_lanelet_ptr, this->matches, this->ll_regular_cols, this->to_be_deleted);
+  this->ll_map_new = std::make_shared<lanelet::LaneletMap>();
+  bool nM = m_conflation.create_updated_map(
+    this->ll_map_lanelet_ptr, this->ll_map_new, this->to_be_deleted);
+
+  if (reg && rmT && clT && bG && confl && nM) {
+    std::cout << "\033[1;36m===> Finished incremental conflation!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during incremental Conflation !!");
+    return false;
+  }
+
+  for (const auto & ls : ll_coll) {
+    this->ll_collapsed.push_back(ls);
+  }
+  m_incremental.update_table(this->match_table, region, this->matches);
+  return true;
+}
+
+/*********************************************************************
+ * Load previously fused lanelet-map and match table of previous run
+ **********************************************************************/
+bool clanelet2_osm::load_fused_map()
+{
+  if (m_file_loader.read_map_from_file(
+        *this, this->map_path, this->proj_type, this->ll_map_lanelet_ptr)) {
+    std::cout << "\033[1;36m===> Fused Lanelet2 Map: Loaded!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map loading !!");
+    return false;
+  }
+  const std::string table_path = this->get_parameter("match_table_path").as_string();
+  if (m_file_loader.read_match_table(*this, table_path, this->match_table)) {
+    std::cout << "\033[1;36m===> Match table with " << this->match_table.size()
+              << " entries: Loaded!\033[0m" << std::endl;
+  } else {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during match table loading !!");
+    return false;
+  }
+  return true;
 }
 
 /************************************************************************************
  * Publish conflation geometry, lanelet-map and openstreetmap-road network
  *************************************************************************************/
-void clanelet2_osm::publish_map()
+bool clanelet2_osm::publish_map()
 {
-  m_msgs.confl2marker_msg(this->ll_collapsed, this->matches, this->msg_confl_geom_markers);
-
   if (!m_extract.ll_map_extract(
         this->ll_map_lanelet_ptr, this->ll_lanelets, this->ll_regular_lanelets,
         this->ll_shoulder_lanelets, this->ll_stop_lines)) {
     RCLCPP_ERROR(
       rclcpp::get_logger(this->node_name),
       "!! Error during road network extraction of original lanelet map !!");
+    return false;
   }
   if (!m_extract.ll_map_extract(
         this->ll_map_new, this->ll_lanelets_new, this->ll_regular_lanelets_new,
@@ -342,78 +969,336 @@ void clanelet2_osm::publish_map()
     RCLCPP_ERROR(
       rclcpp::get_logger(this->node_name),
       "!! Error during road network extraction of updated lanelet map !!");
+    return false;
   }
-  // Lanelet map
-  m_msgs.col_map_net2marker_msg(
-    *this, this->ll_lanelets, this->ll_regular_lanelets, this->ll_shoulder_lanelets,
-    this->ll_stop_lines, this->ll_regular_cols, this->msg_ll_map_markers);
+  invalidate_markers({"confl_geom", "ll_map", "ll_map_new", "osm_map"});
 
-  m_msgs.map_net2marker_msg(
-    *this, this->ll_lanelets_new, this->ll_regular_lanelets_new, this->ll_shoulder_lanelets_new,
-    this->ll_stop_lines_new, this->msg_ll_map_new_markers);
+  // Binary map for downstream consumers
+  publish_map_bin();
+  std::cout << "\033[1;36m===> Data published!\033[0m" << std::endl;
+  return true;
+}
 
-  // OSM map
-  m_msgs.osm_net2marker_msg(
-    this->osm_motorway_linestrings, this->osm_highway_linestrings, this->osm_road_linestrings,
-    this->msg_osm_map_markers);
+/*****************************************************************************
+ * Publish updated lanelet-map as binary map message (optionally compressed)
+ ******************************************************************************/
+void clanelet2_osm::publish_map_bin()
+{
+  if (!this->get_parameter("map_bin").as_bool() || !this->ll_map_new) {
+    return;
+  }
+  autoware_auto_mapping_msgs::msg::HADMapBin msg;
+  m_msgs.map2bin_msg(*this, this->ll_map_new, msg);
 
-  // Publish messages
-  this->pub_confl_geom_markers->publish(this->msg_confl_geom_markers);
-  this->pub_ll_map_markers->publish(this->msg_ll_map_markers);
-  this->pub_ll_map_new_markers->publish(this->msg_ll_map_new_markers);
-  this->pub_osm_map_markers->publish(this->msg_osm_map_markers);
-  std::cout << "\033[1;36m===> Data published as MarkerArray!\033[0m" << std::endl;
+  if (this->get_parameter("map_bin_compressed").as_bool()) {
+    tum_lanelet2_osm_fusion::msg::CompressedMapBin msg_comp;
+    if (m_msgs.compress_bin_msg(msg, this->get_parameter("map_bin_level").as_int(), msg_comp)) {
+      std::cout << "\033[33m~~~~~> Binary map compressed from " << msg.data.size() << " to "
+                << msg_comp.data.size() << " bytes\033[0m" << std::endl;
+      this->pub_ll_map_new_bin_comp->publish(msg_comp);
+    } else {
+      RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during map compression !!");
+    }
+  }
+  this->pub_ll_map_new_bin->publish(msg);
 }
 
 /***********************************************************
  * Write conflated lanelet-map to file
  ************************************************************/
-void clanelet2_osm::write_map()
+bool clanelet2_osm::write_map()
 {
   if (m_file_writer.write_map_to_path(*this, this->out_path, this->proj_type, this->ll_map_new)) {
     std::cout << "\033[1;36m===> Lanelet2 Map written to " << out_path << "\033[0m" << std::endl;
   } else {
     RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map writing !!");
+    return false;
+  }
+  const std::string table_path = this->get_parameter("match_table_path").as_string();
+  if (!table_path.empty()) {
+    if (m_file_writer.write_match_table(*this, table_path, this->match_table)) {
+      std::cout << "\033[1;36m===> Match table written to " << table_path << "\033[0m"
+                << std::endl;
+    } else {
+      RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during match table writing !!");
+      return false;
+    }
   }
+  return true;
 }
 
-/******************************************************************************************
- * Perform analysis calculations and save all desired data to txt-files for later
- * visualization with python
- *******************************************************************************************/
-void clanelet2_osm::analysis()
+/**************************************************************************
+ * Initialize fusion service (service mode)
+ * => maps, projection origin, openstreetmap-excerpts and the collapsed
+ *    lanelet map are kept in memory between requests
+ * => requests are executed on the pipeline thread
+ ***************************************************************************/
+void clanelet2_osm::initialize_service()
 {
-  const std::string path = this->get_parameter("analysis_output_dir").as_string();
-  bool btraj_matching, bmatching;
-  btraj_matching = bmatching = false;
+  this->srv_fuse = this->create_service<tum_lanelet2_osm_fusion::srv::FuseTrajectory>(
+    "lof/fuse", std::bind(
+                  &clanelet2_osm::fuse_callback, this, std::placeholders::_1,
+                  std::placeholders::_2));
+  this->pipeline_thread = std::thread(&clanelet2_osm::serve_requests, this);
+  std::cout << "\033[1;36m===> Fusion service ready on lof/fuse!\033[0m" << std::endl;
+}
 
-  if (this->get_parameter("analysis_traj_matching").as_bool()) {
-    std::vector<double> diff_al;
-    std::vector<double> diff_rs;
-    btraj_matching = m_analysis.traj_matching(
-      *this, this->traj_master, this->traj_target, this->traj_align, this->traj_rs, this->triangles,
-      this->control_points, diff_al, diff_rs);
+/**************************************************************************
+ * Queue a trajectory submitted to the service for the pipeline thread
+ * => response is sent after the pipeline (progress on lof/progress), the
+ *    executor is not blocked by the request
+ ***************************************************************************/
+void clanelet2_osm::fuse_callback(
+  const std::shared_ptr<rmw_request_id_t> header,
+  const std::shared_ptr<tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request> request)
+{
+  if (request->cp_master.size() != request->cp_target.size()) {
+    tum_lanelet2_osm_fusion::srv::FuseTrajectory::Response response;
+    response.success = false;
+    response.message = "Number of control points on master and target trajectory differs!";
+    this->srv_fuse->send_response(*header, response);
+    return;
   }
-  if (this->get_parameter("analysis_matching").as_bool()) {
-    bmatching = m_analysis.matching(
-      *this, this->matches, this->osm_all_linestrings, this->ll_lanelets, this->ll_regular_cols,
-      this->ll_lanelets_new);
+  size_t queued;
+  {
+    std::lock_guard<std::mutex> lock(this->requests_mutex);
+    this->requests.push_back({header, request});
+    queued = this->requests.size();
+  }
+  this->requests_cv.notify_one();
+  std::cout << "\033[33m~~~~~> Request queued (" << queued << " waiting)\033[0m" << std::endl;
+}
+
+/*******************************************************************
+ * Execute queued service requests one after another
+ * => runs on the pipeline thread started by initialize_service
+ ********************************************************************/
+void clanelet2_osm::serve_requests()
+{
+  while (true) {
+    s_fuse_request req;
+    {
+      std::unique_lock<std::mutex> lock(this->requests_mutex);
+      this->requests_cv.wait(
+        lock, [this]() { return this->requests_stop || !this->requests.empty(); });
+      if (this->requests_stop) {
+        return;
+      }
+      req = this->requests.front();
+      this->requests.pop_front();
+      // Cancellation of a previous request does not apply (stop sets it afterwards)
+      this->progress.cancel = false;
+    }
+    tum_lanelet2_osm_fusion::srv::FuseTrajectory::Response response;
+    fuse_request(*req.request, response);
+    this->srv_fuse->send_response(*req.header, response);
   }
+}
 
-  if (btraj_matching || bmatching) {
-    std::cout << "\033[1;36m===> Analysis calculations saved in " << path << "/ !\033[0m"
+/*********************************************************************
+ * Execute fusion pipeline for a trajectory submitted to the service
+ **********************************************************************/
+void clanelet2_osm::fuse_request(
+  const tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request & request,
+  tum_lanelet2_osm_fusion::srv::FuseTrajectory::Response & response)
+{
+  // Pipeline (without interactive control point selection and analysis)
+  std::vector<std::pair<std::string, std::function<bool()>>> stages = {
+    {"load_request", [this, &request]() { return load_request_data(request); }},
+    {"get_network", [this]() { return get_network(); }},
+    {"align_traj", [this]() { return align_traj(); }},
+    {"publish_traj", [this]() { return publish_traj(); }},
+    {"rubber_sheeting", [this]() { return rubber_sheeting(); }},
+    {"publish_rs", [this]() { return publish_rs(); }},
+    {"conflation", [this]() { return conflation(); }},
+    {"publish_map", [this]() { return publish_map(); }}};
+  if (!request.out_path.empty()) {
+    stages.push_back({"write_map", [this]() { return write_map(); }});
+  }
+  if (!run_stages(stages)) {
+    response.success = false;
+    response.message = this->progress.cancelled() ? "Request cancelled!" : "Request failed!";
+    return;
+  }
+
+  m_msgs.map2bin_msg(*this, this->ll_map_new, response.map);
+  response.success = true;
+  response.message = "Fused map with " + std::to_string(this->ll_map_new->laneletLayer.size()) +
+                     " lanelets";
+  std::cout << "\033[1;36m===> Request done!\033[0m" << std::endl;
+}
+
+/******************************************************************************
+ * Load data of a service request
+ * => reference map is only loaded from file for the first request and copied
+ *    from an in-memory snapshot afterwards
+ * => openstreetmap-excerpts are cached per bounding box (snapped to a grid), the
+ *    least recently used excerpt is evicted from memory above osm_cache_size
+ *******************************************************************************/
+bool clanelet2_osm::load_request_data(
+  const tum_lanelet2_osm_fusion::srv::FuseTrajectory::Request & request)
+{
+  // Reset results of the previous request
+  reset_state();
+  this->traj_path = request.traj_path;
+  this->poses_path = request.poses_path;
+  this->out_path = request.out_path;
+  for (size_t i = 0; i < request.cp_master.size(); ++i) {
+    this->control_points.push_back(s_control_point(
+      request.cp_master[i].x, request.cp_master[i].y, request.cp_target[i].x,
+      request.cp_target[i].y));
+  }
+
+  lanelet::ConstLineString3d traj_GPS_proj;
+  lanelet::ConstLineString3d traj_SLAM;
+  if (!m_file_loader.read_traj_GPS_from_file(
+        *this, this->traj_path, this->proj_type, this->traj_GPS, traj_GPS_proj)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Trajectory loading !!");
+    return false;
+  }
+  if (!m_file_loader.read_poses_SLAM_from_file(*this, this->poses_path, traj_SLAM)) {
+    RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Pose loading !!");
+    return false;
+  }
+
+  // Reference map
+  if (this->ll_map_snapshot.data.empty()) {
+    if (!m_file_loader.read_map_from_file(
+          *this, this->map_path, this->proj_type, this->ll_map_lanelet_ptr)) {
+      RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map loading !!");
+      return false;
+    }
+    lanelet::utils::conversion::toBinMsg(this->ll_map_lanelet_ptr, &this->ll_map_snapshot);
+    std::cout << "\033[1;36m===> Lanelet2 Map: Loaded!\033[0m" << std::endl;
+  } else {
+    this->ll_map_lanelet_ptr = std::make_shared<lanelet::LaneletMap>();
+    lanelet::utils::conversion::fromBinMsg(this->ll_map_snapshot, this->ll_map_lanelet_ptr);
+    std::cout << "\033[1;36m===> Lanelet2 Map: Restored from memory!\033[0m" << std::endl;
+  }
+
+  // OSM excerpt => snap bounding box of trajectory to grid to reuse excerpts
+  const double res = this->get_parameter("osm_cache_res").as_double();
+  const double min_lat = std::floor(this->get_parameter("min_lat").as_double() / res) * res;
+  const double min_lon = std::floor(this->get_parameter("min_lon").as_double() / res) * res;
+  const double max_lat = std::ceil(this->get_parameter("max_lat").as_double() / res) * res;
+  const double max_lon = std::ceil(this->get_parameter("max_lon").as_double() / res) * res;
+  this->set_parameter(rclcpp::Parameter("min_lat", min_lat));
+  this->set_parameter(rclcpp::Parameter("min_lon", min_lon));
+  this->set_parameter(rclcpp::Parameter("max_lat", max_lat));
+  this->set_parameter(rclcpp::Parameter("max_lon", max_lon));
+  const std::string key = std::to_string(min_lat) + "_" + std::to_string(min_lon) + "_" +
+                          std::to_string(max_lat) + "_" + std::to_string(max_lon);
+
+  auto it = this->osm_cache.find(key);
+  if (it != this->osm_cache.end()) {
+    this->osm_map_lanelet_ptr = std::make_shared<lanelet::LaneletMap>();
+    lanelet::utils::conversion::fromBinMsg(it->second.map, this->osm_map_lanelet_ptr);
+    this->osm_cache_lru.remove(key);
+    this->osm_cache_lru.push_front(key);
+    std::cout << "\033[1;36m===> OSM Map: Restored from memory!\033[0m" << std::endl;
+  } else {
+    const std::string cache_dir = this->get_parameter("osm_cache_dir").as_string();
+    if (!std::filesystem::is_directory(cache_dir)) {
+      std::filesystem::create_directories(cache_dir);
+    }
+    this->osm_path = cache_dir + "/map_osm_" + key + ".osm";
+    if (!std::filesystem::exists(this->osm_path)) {
+      if (!m_file_loader.download_osm_file(*this, this->osm_path)) {
+        RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during Map download !!");
+        std::filesystem::remove(this->osm_path);
+        return false;
+      }
+    }
+    if (!m_file_loader.read_map_from_file(
+          *this, this->osm_path, this->proj_type, this->osm_map_lanelet_ptr)) {
+      RCLCPP_ERROR(rclcpp::get_logger(this->node_name), "!! Error during OSM-map loading !!");
+      return false;
+    }
+    lanelet::utils::conversion::toBinMsg(this->osm_map_lanelet_ptr, &this->osm_cache[key].map);
+    this->osm_cache_lru.push_front(key);
+    const size_t cache_size = this->get_parameter("osm_cache_size").as_int();
+    while (this->osm_cache_lru.size() > cache_size) {
+      this->osm_cache.erase(this->osm_cache_lru.back());
+      this->osm_cache_lru.pop_back();
+    }
+    std::cout << "\033[1;36m===> OSM Map: Loaded!\033[0m" << std::endl;
+  }
+  // Segments of the excerpt are only reused if it is not transformed (GPS is master)
+  if (this->get_parameter("master").as_string() == "GPS") {
+    this->osm_seg_cache = this->osm_cache.at(key).seg;
+  }
+
+  return set_master(traj_GPS_proj, traj_SLAM);
+}
+
+/**********************************************************************
+ * Reset results of a previous request (service mode)
+ ***********************************************************************/
+void clanelet2_osm::reset_state()
+{
+  this->osm_seg_cache = nullptr;
+  this->traj_GPS.clear();
+  this->control_points.clear();
+  this->triangles.clear();
+  this->trans_rs.clear();
+  this->matches.clear();
+  this->match_table.clear();
+  this->ll_regular_cols.clear();
+  this->to_be_deleted.clear();
+  this->ll_collapsed.clear();
+  this->ll_lanelets.clear();
+  this->ll_regular_lanelets.clear();
+  this->ll_shoulder_lanelets.clear();
+  this->ll_stop_lines.clear();
+  this->ll_lanelets_new.clear();
+  this->ll_regular_lanelets_new.clear();
+  this->ll_shoulder_lanelets_new.clear();
+  this->ll_stop_lines_new.clear();
+  this->osm_all_linestrings.clear();
+  this->osm_motorway_linestrings.clear();
+  this->osm_highway_linestrings.clear();
+  this->osm_road_linestrings.clear();
+  this->msg_traj_master_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_traj_target_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_traj_align_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_traj_rs_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_rs_geom_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_confl_geom_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_ll_map_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_ll_map_new_markers = visualization_msgs::msg::MarkerArray();
+  this->msg_osm_map_markers = visualization_msgs::msg::MarkerArray();
+}
+
+/******************************************************************************************
+ * Stage remaining analysis data (lanelets of the conflated map) to be saved in txt-files
+ * for later visualization with python
+ * => trajectories and matches are staged by the stages producing them
+ *******************************************************************************************/
+bool clanelet2_osm::analysis()
+{
+  if (stage_analysis("analysis_matching")) {
+    m_analysis.matching_lanelets(
+      *this, this->ll_lanelets, this->ll_regular_cols, this->ll_lanelets_new);
+  }
+
+  if (stage_analysis("analysis_traj_matching") || stage_analysis("analysis_matching")) {
+    std::cout << "\033[1;36m===> Analysis calculations staged, saving in "
+              << this->get_parameter("analysis_output_dir").as_string() << "/ !\033[0m"
               << std::endl;
   }
+  return true;
 }
 
-/************
- * main
- *************/
-int main(int argc, char ** argv)
+/*********************************************************************
+ * Check if analysis data of a pipeline stage is to be staged
+ * => not available in service mode
+ **********************************************************************/
+bool clanelet2_osm::stage_analysis(const std::string & param)
 {
-  // Init
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<clanelet2_osm>("lanelet2_osm"));
-  rclcpp::shutdown();
-  return 0;
+  return this->pipeline_mode != "service" && this->get_parameter(param).as_bool();
 }
+
+/************************************
+ * Register as composable node
+ *************************************/
+RCLCPP_COMPONENTS_REGISTER_NODE(clanelet2_osm)
@@ -76,18 +76,35 @@ bool calign::transform_ls(
   lanelet::ConstLineString3d & ls, lanelet::ConstLineString3d & ls_trans,
   const Eigen::Matrix3d & trans)
 {
-  lanelet::LineString3d ls_t(lanelet::utils::getId(), {});
+  lanelet::LineString3d ls_t(next_id(), {});
   // Transform geometry
   for (auto & pt : ls) {
     const Eigen::Vector3d point(pt.x(), pt.y(), 1.0);
     const Eigen::Vector3d pt_trans = trans.inverse() * point;
-    lanelet::Point3d pt_t(lanelet::utils::getId(), {pt_trans(0), pt_trans(1), 0.0});
+    lanelet::Point3d pt_t(next_id(), {pt_trans(0), pt_trans(1), 0.0});
     ls_t.push_back(pt_t);
   }
   ls_trans = ls_t;
   return true;
 }
 
+/****************************************************************************
+ * Calculate residuals between reference and aligned linestring
+ * => 2D distance of every point of the aligned linestring to the reference
+ *****************************************************************************/
+bool calign::residuals(
+  const lanelet::ConstLineString3d & ref, const lanelet::ConstLineString3d & ls,
+  std::vector<double> & res)
+{
+  if (ref.size() < 2 || ls.empty()) {
+    return false;
+  }
+  for (const auto & pt : ls) {
+    res.push_back(lanelet::geometry::distance2d(ref, pt));
+  }
+  return true;
+}
+
 /*****************/
 /*private methods*/
 /*****************/
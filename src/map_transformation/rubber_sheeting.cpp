@@ -22,6 +22,7 @@
 #include "rubber_sheeting.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -71,12 +72,26 @@ bool crubber_sheeting::select_control_points(
     }
 
     // Create subscription and wait for point message
+    // => callback group not added to an executor so that the message is not taken by a
+    //    spinning executor
+    rclcpp::SubscriptionOptions options;
+    options.callback_group =
+      node.create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive, false);
     auto sub = node.create_subscription<geometry_msgs::msg::PointStamped>(
-      "clicked_point", 1, [](const std::shared_ptr<geometry_msgs::msg::PointStamped>) {});
-    bool received_msg = rclcpp::wait_for_message(msg, sub, node.get_node_options().context());
+      "clicked_point", 1, [](const std::shared_ptr<geometry_msgs::msg::PointStamped>) {},
+      options);
+    bool received_msg = false;
+    while (!received_msg && rclcpp::ok()) {
+      if (cancelled()) {
+        std::cout << "\033[33m~~~~~> Control point selection cancelled!\033[0m" << std::endl;
+        return false;
+      }
+      received_msg = rclcpp::wait_for_message(
+        msg, sub, node.get_node_options().context(), std::chrono::seconds(1));
+    }
 
     // Convert message to lanelet point and write in array
-    lanelet::Point3d pt(lanelet::utils::getId(), msg.point.x, msg.point.y, 0.0);
+    lanelet::Point3d pt(next_id(), msg.point.x, msg.point.y, 0.0);
 
     // Find closest point on corresponding trajectory
     if (cp_inter.size() == 0) {
@@ -162,7 +177,7 @@ bool crubber_sheeting::transform_ls(
   const lanelet::Areas & tri, const std::vector<Eigen::Matrix3d> & trans)
 {
   // Initialize output linestring to be filled -> non-const
-  lanelet::LineString3d ls_t(lanelet::utils::getId(), {});
+  lanelet::LineString3d ls_t(next_id(), {});
 
   // Transform geometry
   for (auto & pt : ls) {
@@ -172,7 +187,7 @@ bool crubber_sheeting::transform_ls(
       if (lanelet::geometry::inside(triangle, lanelet::utils::to2D(pt).basicPoint())) {
         const Eigen::Vector3d point(pt.x(), pt.y(), 1.0);
         const Eigen::Vector3d pt_trans = trans[i] * point;
-        lanelet::Point3d pt_t(lanelet::utils::getId(), {pt_trans(0), pt_trans(1), 0.0});
+        lanelet::Point3d pt_t(next_id(), {pt_trans(0), pt_trans(1), 0.0});
         ls_t.push_back(pt_t);
         break;
       }
@@ -210,29 +225,34 @@ bool crubber_sheeting::transform_pcd(
   cloud_out.points.resize(cloud_out.width * cloud_out.height);
 
   // Transform points and write into output cloud
-  int ind_pt = 0;
-  for (const auto & point : *cloud) {
-    // Align point with alignment transformation matrix
-    int i = 0;
-    const Eigen::Vector3d pt_(point.x, point.y, 1.0);
-    const Eigen::Vector3d pt_al = trans_al.inverse() * pt_;
-
-    // Create new, aligned point
-    lanelet::Point3d pt(lanelet::utils::getId(), pt_al(0), pt_al(1), 1.0);
-
-    // Find area the point is in
-    for (auto & triangle : tri) {
-      if (lanelet::geometry::inside(triangle, lanelet::utils::to2D(pt).basicPoint())) {
-        // Rubber-sheet point
-        const Eigen::Vector3d pt_rs = trans[i] * pt_al;
-        cloud_out[ind_pt].x = pt_rs(0);
-        cloud_out[ind_pt].y = pt_rs(1);
-        cloud_out[ind_pt].z = point.z;
-        break;
+  const Eigen::Matrix3d trans_al_inv = trans_al.inverse();
+  if (node.get_parameter("float_geometry").as_bool()) {
+    transform_pcd_local(*cloud, cloud_out, tri, trans, trans_al_inv);
+  } else {
+    int ind_pt = 0;
+    for (const auto & point : *cloud) {
+      // Align point with alignment transformation matrix
+      int i = 0;
+      const Eigen::Vector3d pt_(point.x, point.y, 1.0);
+      const Eigen::Vector3d pt_al = trans_al_inv * pt_;
+
+      // Aligned point (2D, scratch)
+      const lanelet::BasicPoint2d pt(pt_al(0), pt_al(1));
+
+      // Find area the point is in
+      for (auto & triangle : tri) {
+        if (lanelet::geometry::inside(triangle, pt)) {
+          // Rubber-sheet point
+          const Eigen::Vector3d pt_rs = trans[i] * pt_al;
+          cloud_out[ind_pt].x = pt_rs(0);
+          cloud_out[ind_pt].y = pt_rs(1);
+          cloud_out[ind_pt].z = point.z;
+          break;
+        }
+        ++i;
       }
-      ++i;
+      ++ind_pt;
     }
-    ++ind_pt;
   }
 
   // write to file
@@ -249,6 +269,65 @@ bool crubber_sheeting::transform_pcd(
 /*private methods*/
 /*****************/
 
+/*******************************************************************************
+ * Transform point cloud in float32 relative to a local origin (center of the
+ * triangles) => accurate to millimetres, half the memory of double geometry
+ ********************************************************************************/
+void crubber_sheeting::transform_pcd_local(
+  const pcl::PointCloud<pcl::PointXYZ> & cloud, pcl::PointCloud<pcl::PointXYZ> & cloud_out,
+  const lanelet::Areas & tri, const std::vector<Eigen::Matrix3d> & trans,
+  const Eigen::Matrix3d & trans_al_inv)
+{
+  // Local origin => center of the triangles
+  Eigen::AlignedBox2d box;
+  for (const auto & triangle : tri) {
+    for (const auto & pt : triangle.outerBoundPolygon()) {
+      box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+    }
+  }
+  const Eigen::Vector2d origin = box.center();
+
+  // Triangles (consecutive points, starting index per triangle) and transformations in
+  // local coordinates
+  std::vector<Eigen::Vector2f> tri_pts;
+  std::vector<size_t> tri_ind;
+  std::vector<Eigen::Matrix3f> trans_loc;
+  for (size_t i = 0; i < tri.size(); ++i) {
+    tri_ind.push_back(tri_pts.size());
+    for (const auto & pt : tri[i].outerBoundPolygon()) {
+      tri_pts.push_back((Eigen::Vector2d(pt.x(), pt.y()) - origin).cast<float>());
+    }
+    trans_loc.push_back(local_transform<float>(trans[i], origin));
+  }
+  tri_ind.push_back(tri_pts.size());
+
+  // Alignment from point cloud to local coordinates
+  Eigen::Matrix3d shift_inv = Eigen::Matrix3d::Identity();
+  shift_inv.block<2, 1>(0, 2) = -origin;
+  const Eigen::Matrix3f trans_al_loc = (shift_inv * trans_al_inv).cast<float>();
+
+  // Transform points and write into output cloud
+  size_t ind_pt = 0;
+  for (const auto & point : cloud) {
+    // Aligned point in local coordinates
+    const Eigen::Vector3f pt_al = trans_al_loc * Eigen::Vector3f(point.x, point.y, 1.0f);
+    const Eigen::Vector2f pt = pt_al.head<2>();
+
+    // Find area the point is in
+    for (size_t i = 0; i < trans_loc.size(); ++i) {
+      if (inside_polygon(&tri_pts[tri_ind[i]], tri_ind[i + 1] - tri_ind[i], pt)) {
+        // Rubber-sheet point and shift back to global coordinates
+        const Eigen::Vector3f pt_rs = trans_loc[i] * pt_al;
+        cloud_out[ind_pt].x = static_cast<float>(origin.x() + pt_rs(0));
+        cloud_out[ind_pt].y = static_cast<float>(origin.y() + pt_rs(1));
+        cloud_out[ind_pt].z = point.z;
+        break;
+      }
+    }
+    ++ind_pt;
+  }
+}
+
 /**************************************************************
  * Find closest point on given linestring for given point
  ***************************************************************/
@@ -290,17 +369,17 @@ lanelet::Area crubber_sheeting::enclosing_rectangle(const lanelet::ConstLineStri
   dy = 0.05 * std::abs(max_y - min_y);
 
   // Define area
-  lanelet::Point3d bottom_left{lanelet::utils::getId(), min_x - dx, min_y - dy, 0.0};
-  lanelet::Point3d top_left{lanelet::utils::getId(), min_x - dx, max_y + dy, 0.0};
-  lanelet::Point3d top_right{lanelet::utils::getId(), max_x + dx, max_y + dy, 0.0};
-  lanelet::Point3d bottom_right{lanelet::utils::getId(), max_x + dx, min_y - dy, 0.0};
+  lanelet::Point3d bottom_left{lanelet::InvalId, min_x - dx, min_y - dy, 0.0};
+  lanelet::Point3d top_left{lanelet::InvalId, min_x - dx, max_y + dy, 0.0};
+  lanelet::Point3d top_right{lanelet::InvalId, max_x + dx, max_y + dy, 0.0};
+  lanelet::Point3d bottom_right{lanelet::InvalId, max_x + dx, min_y - dy, 0.0};
 
-  lanelet::LineString3d ls1(lanelet::utils::getId(), {bottom_left, top_left});
-  lanelet::LineString3d ls2(lanelet::utils::getId(), {top_left, top_right});
-  lanelet::LineString3d ls3(lanelet::utils::getId(), {top_right, bottom_right});
-  lanelet::LineString3d ls4(lanelet::utils::getId(), {bottom_right, bottom_left});
+  lanelet::LineString3d ls1(lanelet::InvalId, {bottom_left, top_left});
+  lanelet::LineString3d ls2(lanelet::InvalId, {top_left, top_right});
+  lanelet::LineString3d ls3(lanelet::InvalId, {top_right, bottom_right});
+  lanelet::LineString3d ls4(lanelet::InvalId, {bottom_right, bottom_left});
 
-  lanelet::Area ar(lanelet::utils::getId(), {ls1, ls2, ls3, ls4});
+  lanelet::Area ar(lanelet::InvalId, {ls1, ls2, ls3, ls4});
   return ar;
 }
 
@@ -318,21 +397,21 @@ lanelet::Area crubber_sheeting::src_rectangle(
     for (auto & cpt : cps) {
       vx.push_back(ls[0].x() + cpt.get_source_point().x() - cpt.get_target_point().x());
       vy.push_back(ls[0].y() + cpt.get_source_point().y() - cpt.get_target_point().y());
-      lanelet::Point3d pt(lanelet::utils::getId(), vx.back(), vy.back(), 0.0);
+      lanelet::Point3d pt(lanelet::InvalId, vx.back(), vy.back(), 0.0);
 
       d.push_back(std::abs(lanelet::geometry::distance2d(pt, cpt.get_source_point())));
     }
     const int ind = std::distance(d.begin(), std::min_element(d.begin(), d.end()));
-    lanelet::Point3d pt_rec(lanelet::utils::getId(), vx[ind], vy[ind], 0.0);
+    lanelet::Point3d pt_rec(lanelet::InvalId, vx[ind], vy[ind], 0.0);
     pts.push_back(pt_rec);
   }
 
   // Construct area
-  lanelet::LineString3d ls1(lanelet::utils::getId(), {pts[0], pts[1]});
-  lanelet::LineString3d ls2(lanelet::utils::getId(), {pts[1], pts[2]});
-  lanelet::LineString3d ls3(lanelet::utils::getId(), {pts[2], pts[3]});
-  lanelet::LineString3d ls4(lanelet::utils::getId(), {pts[3], pts[0]});
-  lanelet::Area ar(lanelet::utils::getId(), {ls1, ls2, ls3, ls4});
+  lanelet::LineString3d ls1(lanelet::InvalId, {pts[0], pts[1]});
+  lanelet::LineString3d ls2(lanelet::InvalId, {pts[1], pts[2]});
+  lanelet::LineString3d ls3(lanelet::InvalId, {pts[2], pts[3]});
+  lanelet::LineString3d ls4(lanelet::InvalId, {pts[3], pts[0]});
+  lanelet::Area ar(lanelet::InvalId, {ls1, ls2, ls3, ls4});
   return ar;
 }
 
@@ -364,15 +443,15 @@ void crubber_sheeting::triangulation(const std::vector<s_control_point> & cps, l
   lanelet::Point3d top_right = (cps.end() - 2)->get_target_point();
   lanelet::Point3d bottom_right = (cps.end() - 1)->get_target_point();
 
-  lanelet::LineString3d ls11(lanelet::utils::getId(), {bottom_left, top_left});
-  lanelet::LineString3d ls12(lanelet::utils::getId(), {top_left, top_right});
-  lanelet::LineString3d ls13(lanelet::utils::getId(), {top_right, bottom_left});
-  lanelet::Area delta_1(lanelet::utils::getId(), {ls11, ls12, ls13});
+  lanelet::LineString3d ls11(lanelet::InvalId, {bottom_left, top_left});
+  lanelet::LineString3d ls12(lanelet::InvalId, {top_left, top_right});
+  lanelet::LineString3d ls13(lanelet::InvalId, {top_right, bottom_left});
+  lanelet::Area delta_1(lanelet::InvalId, {ls11, ls12, ls13});
 
-  lanelet::LineString3d ls21(lanelet::utils::getId(), {bottom_left, top_right});
-  lanelet::LineString3d ls22(lanelet::utils::getId(), {top_right, bottom_right});
-  lanelet::LineString3d ls23(lanelet::utils::getId(), {bottom_right, bottom_left});
-  lanelet::Area delta_2(lanelet::utils::getId(), {ls21, ls22, ls23});
+  lanelet::LineString3d ls21(lanelet::InvalId, {bottom_left, top_right});
+  lanelet::LineString3d ls22(lanelet::InvalId, {top_right, bottom_right});
+  lanelet::LineString3d ls23(lanelet::InvalId, {bottom_right, bottom_left});
+  lanelet::Area delta_2(lanelet::InvalId, {ls21, ls22, ls23});
 
   tri.push_back(delta_1);
   tri.push_back(delta_2);
@@ -392,10 +471,10 @@ void crubber_sheeting::triangulation(const std::vector<s_control_point> & cps, l
 
         // Create 3 new areas and add them to triangles
         for (auto & ls : outer) {
-          lanelet::LineString3d ls2(lanelet::utils::getId(), {ls[1], pt});
-          lanelet::LineString3d ls3(lanelet::utils::getId(), {pt, ls[0]});
+          lanelet::LineString3d ls2(lanelet::InvalId, {ls[1], pt});
+          lanelet::LineString3d ls3(lanelet::InvalId, {pt, ls[0]});
 
-          lanelet::Area ar(lanelet::utils::getId(), {ls, ls2, ls3});
+          lanelet::Area ar(lanelet::InvalId, {ls, ls2, ls3});
           tri.push_back(ar);
         }
         ind_tri = j;
@@ -476,7 +555,7 @@ void crubber_sheeting::quadrilateral_test(lanelet::Areas & tri)
         }
         // Construct new diagonal and potential new triangles
         ls_adj.erase(ls_adj.begin() + ind_common);
-        lanelet::LineString3d diag_2(lanelet::utils::getId(), {});
+        lanelet::LineString3d diag_2(lanelet::InvalId, {});
         lanelet::LineStrings3d ls_new1;
         lanelet::LineStrings3d ls_new2;
 
@@ -500,8 +579,8 @@ void crubber_sheeting::quadrilateral_test(lanelet::Areas & tri)
           ls_new2.push_back(diag_2);
         }
 
-        lanelet::Area tri_new1(lanelet::utils::getId(), ls_new1);
-        lanelet::Area tri_new2(lanelet::utils::getId(), ls_new2);
+        lanelet::Area tri_new1(lanelet::InvalId, ls_new1);
+        lanelet::Area tri_new2(lanelet::InvalId, ls_new2);
         // Check if quadrilateral is convex (= diagonals intersect)
         if (lanelet::geometry::intersects3d(diag_1, diag_2, 0.1)) {
           double h1 = std::min(triangle_height(tri_new1), triangle_height(tri_new2));
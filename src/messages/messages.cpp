@@ -20,8 +20,12 @@
 //
 #include "messages.hpp"
 
+#include <zlib.h>
+
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <map>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -119,11 +123,11 @@ void cmessages::map_net2marker_msg(
 void cmessages::col_map_net2marker_msg(
   rclcpp::Node & node, lanelet::ConstLanelets & all, lanelet::ConstLanelets & regular,
   lanelet::ConstLanelets & shoulder, std::vector<lanelet::ConstLineString3d> & stop_lines,
-  const std::vector<std::pair<lanelet::Id, std::string>> & cols,
-  visualization_msgs::msg::MarkerArray & map_marker_msg)
+  const s_color_table & cols, visualization_msgs::msg::MarkerArray & map_marker_msg)
 {
   (void)all;
   bool viz_lanelet_centerline = node.get_parameter("viz_lanelet_centerline").as_bool();
+  const int viz_threads = node.get_parameter("viz_threads").as_int();
 
   // Set colors of elements
   std_msgs::msg::ColorRGBA color_reg, color_shoulder, color_lanelet_id, color_lanelet_borders,
@@ -161,7 +165,8 @@ void cmessages::col_map_net2marker_msg(
     &map_marker_msg, lanelet::visualization::laneletsBoundaryAsMarkerArray(
                        regular, color_lanelet_borders, viz_lanelet_centerline));
   insert_marker_array(
-    &map_marker_msg, colored_lanelets2marker_msg("regular_lanelets", regular, cols));
+    &map_marker_msg,
+    colored_lanelets2marker_msg("regular_lanelets", regular, cols, viz_threads));
   // Conflated tags of lanelets
   insert_marker_array(
     &map_marker_msg, tags2marker_msg(
@@ -265,6 +270,223 @@ void cmessages::confl2marker_msg(
   insert_marker_array(&msg, match2marker_msg(matches, "Blue", "Matches", 0.2));
 }
 
+/**************************************************************************
+ * Serialize lanelet map into binary map message (lanelet2 boost
+ * serialization) => no xml-parsing and projection for consumers
+ ***************************************************************************/
+void cmessages::map2bin_msg(
+  rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr,
+  autoware_auto_mapping_msgs::msg::HADMapBin & msg)
+{
+  lanelet::utils::conversion::toBinMsg(map_ptr, &msg);
+  msg.header.stamp = node.now();
+  msg.header.frame_id = "map";
+}
+
+/****************************************************************************
+ * Compress data of a binary map message with zlib (level 1 - 9)
+ *****************************************************************************/
+bool cmessages::compress_bin_msg(
+  const autoware_auto_mapping_msgs::msg::HADMapBin & msg, const int level,
+  tum_lanelet2_osm_fusion::msg::CompressedMapBin & msg_comp)
+{
+  uLongf len = compressBound(msg.data.size());
+  msg_comp.data.resize(len);
+  if (
+    compress2(
+      msg_comp.data.data(), &len, msg.data.data(), msg.data.size(),
+      std::clamp(level, 1, 9)) != Z_OK) {
+    std::cerr << "\033[31m" << __FUNCTION__ << ": Compression failed!\033[0m" << std::endl;
+    return false;
+  }
+  msg_comp.data.resize(len);
+  msg_comp.header = msg.header;
+  msg_comp.format_version = msg.format_version;
+  msg_comp.map_format_version = msg.map_format_version;
+  msg_comp.map_version = msg.map_version;
+  msg_comp.size = msg.data.size();
+  return true;
+}
+
+/****************************************************************************
+ * Decompress a compressed binary map message (for consumers)
+ *****************************************************************************/
+bool cmessages::decompress_bin_msg(
+  const tum_lanelet2_osm_fusion::msg::CompressedMapBin & msg_comp,
+  autoware_auto_mapping_msgs::msg::HADMapBin & msg)
+{
+  uLongf len = msg_comp.size;
+  msg.data.resize(len);
+  if (
+    uncompress(msg.data.data(), &len, msg_comp.data.data(), msg_comp.data.size()) != Z_OK ||
+    len != msg_comp.size) {
+    std::cerr << "\033[31m" << __FUNCTION__ << ": Decompression failed!\033[0m" << std::endl;
+    return false;
+  }
+  msg.header = msg_comp.header;
+  msg.format_version = msg_comp.format_version;
+  msg.map_format_version = msg_comp.map_format_version;
+  msg.map_version = msg_comp.map_version;
+  return true;
+}
+
+/***************************************************************************************
+ * Insert lanelets into marker array with level of detail (visualization of large maps)
+ * => markers split into namespaces of spatial tiles that are built in parallel
+ * => one level per tile: finest Douglas-Peucker tolerance whose markers fit into the
+ *    point budget (markers of the coarsest level are split if they still exceed it)
+ * => lanelets colored based on color code from conflation if given
+ ****************************************************************************************/
+void cmessages::lod_map_net2marker_msg(
+  rclcpp::Node & node, const lanelet::ConstLanelets & lls, const s_color_table & cols,
+  const std::string & ns, visualization_msgs::msg::MarkerArray & map_marker_msg)
+{
+  std::vector<double> tols = node.get_parameter("viz_lod_tolerances").as_double_array();
+  std::sort(tols.begin(), tols.end());
+  const double tile_size = node.get_parameter("viz_tile_size").as_double();
+  const size_t budget = node.get_parameter("viz_point_budget").as_int();
+  const int threads = node.get_parameter("viz_threads").as_int();
+
+  // Assign lanelets to tiles (by middle point of left bound)
+  std::map<std::pair<int, int>, lanelet::ConstLanelets> tile_map;
+  for (const auto & ll : lls) {
+    const auto & lb = ll.leftBound();
+    if (!lb.empty()) {
+      tile_map[viz_tile(lb[lb.size() / 2], tile_size)].push_back(ll);
+    }
+  }
+  std::vector<std::pair<std::pair<int, int>, lanelet::ConstLanelets>> tiles(
+    tile_map.begin(), tile_map.end());
+
+  // Set colors of elements
+  std_msgs::msg::ColorRGBA color_reg, color_borders, color_none;
+  set_color(&color_reg, "WEBBlueLight", 0.5);
+  set_color(&color_borders, "Gray3", 0.999);
+  set_color(&color_none, "", 0.5);
+  const std::vector<std_msgs::msg::ColorRGBA> pal = palette(cols, 0.5);
+
+  auto build = [&](const size_t i, visualization_msgs::msg::MarkerArray & msg) {
+    const std::string tile_ns =
+      std::to_string(tiles[i].first.first) + "_" + std::to_string(tiles[i].first.second);
+    for (size_t k = 0; k < tols.size(); ++k) {
+      const std::string lod_ns = ns + "/" + tile_ns;
+      visualization_msgs::msg::Marker bounds, surface;
+      lanelet::visualization::initLineStringMarker(
+        &bounds, "map", lod_ns + "/boundaries", color_borders);
+      bounds.type = visualization_msgs::msg::Marker::LINE_LIST;
+      bounds.scale.x = 0.1;
+      lanelet::visualization::initLineStringMarker(
+        &surface, "map", lod_ns + "/lanelets", color_reg);
+      surface.type = visualization_msgs::msg::Marker::TRIANGLE_LIST;
+      surface.scale.x = surface.scale.y = surface.scale.z = 1.0;
+
+      for (const auto & ll : tiles[i].second) {
+        const std::vector<lanelet::BasicPoint3d> left = simplify(ll.leftBound(), tols[k]);
+        const std::vector<lanelet::BasicPoint3d> right = simplify(ll.rightBound(), tols[k]);
+        for (const auto * bound : {&left, &right}) {
+          for (size_t j = 1; j < bound->size(); ++j) {
+            for (const auto & pt : {(*bound)[j - 1], (*bound)[j]}) {
+              geometry_msgs::msg::Point p;
+              lanelet::utils::conversion::toGeomMsgPt(pt, &p);
+              bounds.points.push_back(p);
+            }
+          }
+        }
+
+        // Surface from polygon of simplified bounds
+        const int ind = cols.index(ll.id());
+        const std_msgs::msg::ColorRGBA & c =
+          (cols.empty()) ? color_reg : ((ind >= 0) ? pal[ind] : color_none);
+        geometry_msgs::msg::Polygon poly;
+        for (const auto & pt : left) {
+          geometry_msgs::msg::Point32 pt32;
+          lanelet::utils::conversion::toGeomMsgPt32(pt, &pt32);
+          poly.points.push_back(pt32);
+        }
+        for (auto it = right.rbegin(); it != right.rend(); ++it) {
+          geometry_msgs::msg::Point32 pt32;
+          lanelet::utils::conversion::toGeomMsgPt32(*it, &pt32);
+          poly.points.push_back(pt32);
+        }
+        std::vector<geometry_msgs::msg::Polygon> triangles;
+        lanelet::visualization::polygon2Triangle(poly, &triangles);
+        for (const auto & tri : triangles) {
+          for (int j = 0; j < 3; j++) {
+            geometry_msgs::msg::Point p;
+            lanelet::utils::conversion::toGeomMsgPt(tri.points[j], &p);
+            surface.points.push_back(p);
+            surface.colors.push_back(c);
+          }
+        }
+      }
+      // Finest level within the point budget
+      if (
+        std::max(bounds.points.size(), surface.points.size()) <= budget ||
+        k + 1 == tols.size()) {
+        insert_marker_budget(bounds, budget, &msg);
+        insert_marker_budget(surface, budget, &msg);
+        break;
+      }
+    }
+  };
+  build_tiles(tiles.size(), threads, build, map_marker_msg);
+}
+
+/*****************************************************************************************
+ * Insert linestrings of an openstreetmap-file with level of detail into a markerarray
+ * => same tiling and choice of the level per tile as for lanelets
+ ******************************************************************************************/
+void cmessages::lod_osm_net2marker_msg(
+  rclcpp::Node & node, const lanelet::ConstLineStrings3d & lss, const std::string & ns,
+  visualization_msgs::msg::MarkerArray & map_marker_msg)
+{
+  std::vector<double> tols = node.get_parameter("viz_lod_tolerances").as_double_array();
+  std::sort(tols.begin(), tols.end());
+  const double tile_size = node.get_parameter("viz_tile_size").as_double();
+  const size_t budget = node.get_parameter("viz_point_budget").as_int();
+  const int threads = node.get_parameter("viz_threads").as_int();
+
+  // Assign linestrings to tiles (by middle point)
+  std::map<std::pair<int, int>, lanelet::ConstLineStrings3d> tile_map;
+  for (const auto & ls : lss) {
+    if (!ls.empty()) {
+      tile_map[viz_tile(ls[ls.size() / 2], tile_size)].push_back(ls);
+    }
+  }
+  std::vector<std::pair<std::pair<int, int>, lanelet::ConstLineStrings3d>> tiles(
+    tile_map.begin(), tile_map.end());
+
+  std_msgs::msg::ColorRGBA color_roads;
+  set_color(&color_roads, "Orange", 0.99);
+
+  auto build = [&](const size_t i, visualization_msgs::msg::MarkerArray & msg) {
+    const std::string tile_ns =
+      std::to_string(tiles[i].first.first) + "_" + std::to_string(tiles[i].first.second);
+    for (size_t k = 0; k < tols.size(); ++k) {
+      visualization_msgs::msg::Marker roads;
+      lanelet::visualization::initLineStringMarker(&roads, "map", ns + "/" + tile_ns, color_roads);
+      roads.type = visualization_msgs::msg::Marker::LINE_LIST;
+      roads.scale.x = 0.5;
+      for (const auto & ls : tiles[i].second) {
+        const std::vector<lanelet::BasicPoint3d> pts = simplify(ls, tols[k]);
+        for (size_t j = 1; j < pts.size(); ++j) {
+          for (const auto & pt : {pts[j - 1], pts[j]}) {
+            geometry_msgs::msg::Point p;
+            lanelet::utils::conversion::toGeomMsgPt(pt, &p);
+            roads.points.push_back(p);
+          }
+        }
+      }
+      // Finest level within the point budget
+      if (roads.points.size() <= budget || k + 1 == tols.size()) {
+        insert_marker_budget(roads, budget, &msg);
+        break;
+      }
+    }
+  };
+  build_tiles(tiles.size(), threads, build, map_marker_msg);
+}
+
 /*****************/
 /*private methods*/
 /*****************/
@@ -307,8 +529,7 @@ visualization_msgs::msg::MarkerArray cmessages::controlpoints2marker_msg(
   int i = 1;
   for (auto & cpt : cps) {
     std::string ns_ind = ns + "_" + std::to_string(i);
-    lanelet::LineString3d ls(
-      lanelet::utils::getId(), {cpt.get_source_point(), cpt.get_target_point()});
+    lanelet::LineString3d ls(lanelet::InvalId, {cpt.get_source_point(), cpt.get_target_point()});
     lanelet::ConstLineString3d ls_const = ls;
     insert_marker_array(&msg, linestring2marker_msg(ls, ns_ind, col, thickness));
     i += 1;
@@ -320,8 +541,8 @@ visualization_msgs::msg::MarkerArray cmessages::controlpoints2marker_msg(
  * Convert lanelets into colored triangle based on color code from conflation
  **********************************************************************************/
 visualization_msgs::msg::MarkerArray cmessages::colored_lanelets2marker_msg(
-  const std::string & ns_base, const lanelet::ConstLanelets & lls,
-  const std::vector<std::pair<lanelet::Id, std::string>> & cols)
+  const std::string & ns_base, const lanelet::ConstLanelets & lls, const s_color_table & cols,
+  const int threads)
 {
   visualization_msgs::msg::MarkerArray marker_array;
   visualization_msgs::msg::Marker marker;
@@ -352,25 +573,31 @@ visualization_msgs::msg::MarkerArray cmessages::colored_lanelets2marker_msg(
   marker.color.b = 1.0f;
   marker.color.a = 0.999;
 
-  int indLl = 0;
-  for (const auto & ll : lls) {
+  // Colors of color codes precomputed once
+  const std::vector<std_msgs::msg::ColorRGBA> pal = palette(cols, 0.5);
+  std_msgs::msg::ColorRGBA col_none;
+  set_color(&col_none, "", 0.5);
+
+  // Triangulate lanelets in parallel, insert in order of lanelets
+  std::vector<std::vector<geometry_msgs::msg::Point>> pts(lls.size());
+  std::vector<const std_msgs::msg::ColorRGBA *> c(lls.size());
+  parallel_for(lls.size(), threads, [&](const size_t ind) {
     std::vector<geometry_msgs::msg::Polygon> triangles;
-    lanelet::visualization::lanelet2Triangle(ll, &triangles);
-    std_msgs::msg::ColorRGBA c;
-    std::string col_code = id2col(cols, ll.id());
-    set_color(&c, col_code, 0.5);
+    lanelet::visualization::lanelet2Triangle(lls[ind], &triangles);
+    const int col_ind = cols.index(lls[ind].id());
+    c[ind] = (col_ind >= 0) ? &pal[col_ind] : &col_none;
 
     for (const auto & tri : triangles) {
-      geometry_msgs::msg::Point tri0[3];
-
       for (int i = 0; i < 3; i++) {
-        lanelet::utils::conversion::toGeomMsgPt(tri.points[i], &tri0[i]);
-
-        marker.points.push_back(tri0[i]);
-        marker.colors.push_back(c);
+        geometry_msgs::msg::Point pt;
+        lanelet::utils::conversion::toGeomMsgPt(tri.points[i], &pt);
+        pts[ind].push_back(pt);
       }
     }
-    ++indLl;
+  });
+  for (size_t i = 0; i < lls.size(); ++i) {
+    marker.points.insert(marker.points.end(), pts[i].begin(), pts[i].end());
+    marker.colors.insert(marker.colors.end(), pts[i].size(), *c[i]);
   }
   if (!marker.points.empty()) {
     marker_array.markers.push_back(marker);
@@ -497,20 +724,15 @@ visualization_msgs::msg::MarkerArray cmessages::match2marker_msg(
   if (matches.empty()) {
     return marker_array;
   }
-  std::unordered_set<lanelet::Id> added;
   visualization_msgs::msg::Marker plineMarker;
   lanelet::visualization::initArrowsMarker(&plineMarker, "map", ns, col);
 
+  // Connection lines are created per target linestring of a match (all with InvalId)
+  // => unique by construction, no deduplication by id
   for (const auto & matchEl : matches) {
-    lanelet::ConstLineStrings3d matchConnections = matchEl.match_conn();
-    if (!matchConnections.empty()) {
-      for (const auto & ls : matchConnections) {
-        if (added.find(ls.id()) == added.end()) {
-          lanelet::visualization::pushArrowsMarker(&plineMarker, ls, col);
-          lanelet::visualization::pushLineStringMarker(&plineMarker, ls, col, thickness);
-          added.insert(ls.id());
-        }
-      }
+    for (const auto & ls : matchEl.match_conn()) {
+      lanelet::visualization::pushArrowsMarker(&plineMarker, ls, col);
+      lanelet::visualization::pushLineStringMarker(&plineMarker, ls, col, thickness);
     }
   }
   marker_array.markers.push_back(plineMarker);
@@ -786,16 +1008,90 @@ lanelet::ConstLineStrings3d cmessages::to_const(const lanelet::LineStrings3d & l
   return out;
 }
 
-/**********************************************************************
- * Get color code of a lanelet from conflation based on its id
- ***********************************************************************/
-std::string cmessages::id2col(
-  const std::vector<std::pair<lanelet::Id, std::string>> & cols, const lanelet::Id & id)
+/***************************************************************************
+ * Get precomputed colors of the color codes of a color table
+ ****************************************************************************/
+std::vector<std_msgs::msg::ColorRGBA> cmessages::palette(const s_color_table & cols, const double a)
 {
-  for (const auto & el : cols) {
-    if (el.first == id) {
-      return el.second;
+  std::vector<std_msgs::msg::ColorRGBA> pal(cols.codes().size());
+  for (size_t i = 0; i < pal.size(); ++i) {
+    set_color(&pal[i], cols.codes()[i], a);
+  }
+  return pal;
+}
+
+/*****************************************************************************
+ * Simplify linestring with Douglas-Peucker (2D)
+ * => all points are kept for a tolerance <= 0
+ ******************************************************************************/
+std::vector<lanelet::BasicPoint3d> cmessages::simplify(
+  const lanelet::ConstLineString3d & ls, const double tol)
+{
+  std::vector<lanelet::BasicPoint3d> pts;
+  const std::vector<bool> keep = douglas_peucker(ls, tol);
+  for (size_t i = 0; i < ls.size(); ++i) {
+    if (keep[i]) {
+      pts.push_back(ls[i].basicPoint());
+    }
+  }
+  return pts;
+}
+
+/*****************************************************************************
+ * Get index of the visualization tile of a point
+ ******************************************************************************/
+std::pair<int, int> cmessages::viz_tile(const lanelet::ConstPoint3d & pt, const double tile_size)
+{
+  if (tile_size <= 0.0) {
+    return {0, 0};
+  }
+  return {
+    static_cast<int>(std::floor(pt.x() / tile_size)),
+    static_cast<int>(std::floor(pt.y() / tile_size))};
+}
+
+/*******************************************************************************
+ * Build markerarrays of tiles in parallel
+ * => build(i) fills the markerarray of tile i, results inserted in tile order
+ ********************************************************************************/
+void cmessages::build_tiles(
+  const size_t num_tiles, const int threads,
+  const std::function<void(const size_t, visualization_msgs::msg::MarkerArray &)> & build,
+  visualization_msgs::msg::MarkerArray & msg)
+{
+  std::vector<visualization_msgs::msg::MarkerArray> tile_msgs(num_tiles);
+  parallel_for(num_tiles, threads, [&](const size_t i) { build(i, tile_msgs[i]); });
+  for (const auto & tile_msg : tile_msgs) {
+    insert_marker_array(&msg, tile_msg);
+  }
+}
+
+/******************************************************************************
+ * Insert marker into markerarray, split into several markers (consecutive
+ * ids) if the number of points exceeds the budget
+ *******************************************************************************/
+void cmessages::insert_marker_budget(
+  const visualization_msgs::msg::Marker & marker, const size_t budget,
+  visualization_msgs::msg::MarkerArray * arr_src)
+{
+  if (marker.points.empty()) {
+    return;
+  }
+  // Keep complete primitives (lines/triangles) in one marker
+  const size_t prim = (marker.type == visualization_msgs::msg::Marker::TRIANGLE_LIST) ? 3 : 2;
+  const size_t chunk = (budget >= prim) ? budget - budget % prim : marker.points.size();
+  visualization_msgs::msg::Marker base = marker;
+  base.points.clear();
+  base.colors.clear();
+  int id = marker.id;
+  for (size_t i = 0; i < marker.points.size(); i += chunk) {
+    const size_t end = std::min(marker.points.size(), i + chunk);
+    visualization_msgs::msg::Marker part = base;
+    part.id = id++;
+    part.points.assign(marker.points.begin() + i, marker.points.begin() + end);
+    if (marker.colors.size() == marker.points.size()) {
+      part.colors.assign(marker.colors.begin() + i, marker.colors.begin() + end);
     }
+    arr_src->markers.push_back(part);
   }
-  return "";
 }
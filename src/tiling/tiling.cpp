@@ -0,0 +1,425 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "tiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**************/
+/*Constructors*/
+/**************/
+
+ctiling::ctiling()
+{
+}
+
+/****************/
+/*public methods*/
+/****************/
+
+/*****************************************************************************************
+ * Partition lanelet map and openstreetmap-network into spatial tiles with an overlap
+ * margin, collapse and match every tile independently in parallel and stitch the results
+ ******************************************************************************************/
+bool ctiling::tiled_matching(
+  rclcpp::Node & node, const lanelet::LaneletMapPtr & map_ptr, const lanelet::LineStrings3d & osm,
+  lanelet::LineStrings3d & ll_coll, std::vector<s_match> & matches)
+{
+  if (!map_ptr) {
+    std::cerr << "\033[1;31m" << __FUNCTION__ << ": No map received!\033[0m" << std::endl;
+    return false;
+  }
+  const double tile_size = node.get_parameter("tile_size").as_double();
+  const double overlap = node.get_parameter("tile_overlap").as_double();
+  const int tile_threads = node.get_parameter("tile_threads").as_int();
+  if (tile_size <= 0.0 || overlap < 0.0) {
+    std::cerr << "\033[1;31m" << __FUNCTION__ << ": Invalid tile_size/tile_overlap!\033[0m"
+              << std::endl;
+    return false;
+  }
+
+  lanelet::Lanelets lls;
+  for (const auto & ll : map_ptr->laneletLayer) {
+    lls.push_back(ll);
+  }
+
+  // Grid of tiles (lanelets and openstreetmap-linestrings are assigned by the workers)
+  Eigen::AlignedBox2d extent;
+  int nx, ny;
+  std::vector<s_tile> tiles = create_tiles(lls, osm, tile_size, overlap, extent, nx, ny);
+  std::cout << "\033[33m~~~~~> Processing " << tiles.size() << " tiles (" << nx << " x " << ny
+            << ")\033[0m" << std::endl;
+
+  // Collapse and match tiles in parallel
+  // => each worker fetches the next unprocessed tile, at most one tile per worker is in memory
+  // => workers only see the cancellation before each tile, progress is reported by this thread
+  parallel_for(
+    tiles.size(), tile_threads,
+    [&](const size_t t) {
+      if (cancelled()) {
+        return;
+      }
+      fill_tile(tiles[t], lls, osm);
+      process_tile(node, tiles[t], extent, tile_size, nx, ny);
+    },
+    [&](const size_t done) {
+      update("tiled_matching", static_cast<double>(done) / tiles.size());
+    });
+  if (cancelled()) {
+    std::cout << "\033[33m~~~~~> Tiled matching cancelled!\033[0m" << std::endl;
+    return false;
+  }
+
+  // Stitch results in tile order (independent of the scheduling of the workers)
+  for (auto & tile : tiles) {
+    ll_coll.insert(ll_coll.end(), tile.coll.begin(), tile.coll.end());
+    matches.insert(matches.end(), tile.matches.begin(), tile.matches.end());
+  }
+  resolve_claims(matches);
+
+  cmatching matching;
+  matching.print_stats(node, matches);
+  return true;
+}
+
+/*****************/
+/*private methods*/
+/*****************/
+
+/*****************************************************************************
+ * Create tiles covering the lanelet map with the indices of the lanelets and
+ * openstreetmap-linestrings intersecting them (see fill_tile)
+ * => bounding boxes bucketed into the tiles of their cell range in one pass
+ ******************************************************************************/
+std::vector<s_tile> ctiling::create_tiles(
+  const lanelet::Lanelets & lls, const lanelet::LineStrings3d & osm, const double tile_size,
+  const double overlap, Eigen::AlignedBox2d & extent, int & nx, int & ny)
+{
+  std::vector<s_tile> tiles;
+  extent.setEmpty();
+
+  // Bounding boxes of lanelets and linestrings
+  std::vector<Eigen::AlignedBox2d> ll_boxes, osm_boxes;
+  for (const auto & ll : lls) {
+    Eigen::AlignedBox2d box;
+    for (const auto & pt : ll.leftBound()) {
+      box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+    }
+    for (const auto & pt : ll.rightBound()) {
+      box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+    }
+    extent.extend(box);
+    ll_boxes.push_back(box);
+  }
+  for (const auto & ls : osm) {
+    Eigen::AlignedBox2d box;
+    for (const auto & pt : ls) {
+      box.extend(Eigen::Vector2d(pt.x(), pt.y()));
+    }
+    osm_boxes.push_back(box);
+  }
+  if (extent.isEmpty()) {
+    nx = ny = 0;
+    return tiles;
+  }
+
+  // Grid of tiles over the extent of the lanelet map
+  nx = std::max(1, static_cast<int>(std::ceil(extent.sizes().x() / tile_size)));
+  ny = std::max(1, static_cast<int>(std::ceil(extent.sizes().y() / tile_size)));
+  const Eigen::Vector2d margin(overlap, overlap);
+  std::vector<s_tile> grid(static_cast<size_t>(nx) * ny);
+  for (int iy = 0; iy < ny; ++iy) {
+    for (int ix = 0; ix < nx; ++ix) {
+      s_tile & tile = grid[iy * nx + ix];
+      tile.ix = ix;
+      tile.iy = iy;
+      const Eigen::Vector2d min = extent.min() + Eigen::Vector2d(ix, iy) * tile_size;
+      tile.ext =
+        Eigen::AlignedBox2d(min - margin, min + Eigen::Vector2d(tile_size, tile_size) + margin);
+    }
+  }
+
+  // Bucket every box into the tiles whose extended extent it intersects
+  // => range of tiles from the box extended by the overlap margin (clamped to the grid)
+  auto bucket = [&](const std::vector<Eigen::AlignedBox2d> & boxes, const bool lanelets) {
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+      const Eigen::Vector2d lo = (boxes[i].min() - margin - extent.min()) / tile_size;
+      const Eigen::Vector2d hi = (boxes[i].max() + margin - extent.min()) / tile_size;
+      const int ix0 = std::max(0, static_cast<int>(std::ceil(lo.x())) - 1);
+      const int iy0 = std::max(0, static_cast<int>(std::ceil(lo.y())) - 1);
+      const int ix1 = std::min(nx - 1, static_cast<int>(std::floor(hi.x())));
+      const int iy1 = std::min(ny - 1, static_cast<int>(std::floor(hi.y())));
+      for (int iy = iy0; iy <= iy1; ++iy) {
+        for (int ix = ix0; ix <= ix1; ++ix) {
+          s_tile & tile = grid[iy * nx + ix];
+          if (tile.ext.intersects(boxes[i])) {
+            (lanelets ? tile.ll_ind : tile.osm_ind).push_back(i);
+          }
+        }
+      }
+    }
+  };
+  bucket(ll_boxes, true);
+  bucket(osm_boxes, false);
+
+  // Skip tiles without lanelets
+  for (auto & tile : grid) {
+    if (!tile.ll_ind.empty()) {
+      tiles.push_back(std::move(tile));
+    }
+  }
+  return tiles;
+}
+
+/*************************************************************************
+ * Assign lanelets and openstreetmap-linestrings intersecting the
+ * extended tile extent to a tile (right before it is processed)
+ **************************************************************************/
+void ctiling::fill_tile(
+  s_tile & tile, const lanelet::Lanelets & lls, const lanelet::LineStrings3d & osm)
+{
+  for (const uint32_t i : tile.ll_ind) {
+    tile.lls.push_back(lls[i]);
+  }
+  for (const uint32_t i : tile.osm_ind) {
+    tile.osm.push_back(osm[i]);
+  }
+}
+
+/*****************************************************************
+ * Collapse and match a single tile and keep owned results only
+ ******************************************************************/
+void ctiling::process_tile(
+  rclcpp::Node & node, s_tile & tile, const Eigen::AlignedBox2d & extent, const double tile_size,
+  const int nx, const int ny)
+{
+  cmatching matching;
+  lanelet::LineStrings3d coll;
+  std::vector<s_match> matches;
+
+  matching.collapse_ll_map(tile.lls, coll);
+  if (!coll.empty()) {
+    matching.buffer_growing(node, coll, tile.osm, matches, false);
+  }
+
+  // Keep centerlines that are owned by the tile
+  // => elements inside the overlap margin are owned by the neighboring tile
+  lanelet::Ids owned_ids;
+  for (const auto & ls : coll) {
+    if (owned(ls, tile, extent, tile_size, nx, ny)) {
+      tile.coll.push_back(ls);
+      const lanelet::Ids ids = ref_ids(ls);
+      owned_ids.insert(owned_ids.end(), ids.begin(), ids.end());
+    }
+  }
+  // Keep matches whose reference polyline lies on the owned centerlines
+  std::sort(owned_ids.begin(), owned_ids.end());
+  for (const auto & match : matches) {
+    if (owned(match.ref_pline(), owned_ids, tile, extent, tile_size, nx, ny)) {
+      tile.matches.push_back(match);
+    }
+  }
+
+  // Release input of tile
+  tile.lls = lanelet::Lanelets();
+  tile.osm = lanelet::LineStrings3d();
+}
+
+/************************************************************************************
+ * Resolve lanelets that are claimed by matches of multiple tiles
+ * => lanelet assigned to the match with the highest score (tie: lower tile index)
+ *************************************************************************************/
+void ctiling::resolve_claims(std::vector<s_match> & matches)
+{
+  // Find owning match for each lanelet
+  std::vector<lanelet::Ids> claims;
+  std::unordered_map<lanelet::Id, size_t> owner;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    lanelet::Ids ids;
+    for (const auto & seg : matches[i].ref_pline()) {
+      for (const auto & id : ref_ids(seg)) {
+        if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+          ids.push_back(id);
+        }
+      }
+    }
+    for (const auto & id : ids) {
+      auto it = owner.find(id);
+      if (it == owner.end()) {
+        owner[id] = i;
+      } else if (matches[i].score() > matches[it->second].score()) {
+        it->second = i;
+      }
+    }
+    claims.push_back(ids);
+  }
+
+  // Remove lanelets from matches that lost the claim and drop matches without lanelets
+  std::vector<s_match> resolved;
+  int removed = 0;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    lanelet::Ids lost;
+    for (const auto & id : claims[i]) {
+      if (owner[id] != i) {
+        lost.push_back(id);
+      }
+    }
+    if (!lost.empty()) {
+      // Segments share their data with the reference polyline of the match
+      for (auto & seg : matches[i].ref_pline()) {
+        remove_ref_ids(seg, lost);
+      }
+    }
+    if (claims[i].empty() || lost.size() < claims[i].size()) {
+      resolved.push_back(matches[i]);
+    } else {
+      ++removed;
+    }
+  }
+  matches = resolved;
+  std::cout << "\033[33m~~~~~> Removed " << removed
+            << " duplicate matches at tile boundaries!\033[0m" << std::endl;
+}
+
+/***************************************************************************************
+ * Check if a reference polyline is owned by the tile
+ * => segment closest to the middle that represents lanelets is owned if its lanelets
+ *    are represented by owned centerlines (owned_ids, sorted)
+ * => by the midpoint of its middle segment if no segment represents lanelets
+ ****************************************************************************************/
+bool ctiling::owned(
+  const lanelet::LineStrings3d & pline, const lanelet::Ids & owned_ids, const s_tile & tile,
+  const Eigen::AlignedBox2d & extent, const double tile_size, const int nx, const int ny)
+{
+  if (pline.empty()) {
+    return false;
+  }
+  const size_t mid = pline.size() / 2;
+  for (size_t k = 0; k < 2 * pline.size(); ++k) {
+    // Alternate around the middle segment: mid, mid + 1, mid - 1, ...
+    const size_t i = (k % 2 == 0) ? mid - k / 2 : mid + (k + 1) / 2;
+    if (i >= pline.size()) {
+      continue;
+    }
+    const lanelet::Ids ids = ref_ids(pline[i]);
+    if (!ids.empty()) {
+      return std::all_of(ids.begin(), ids.end(), [&](const lanelet::Id id) {
+        return std::binary_search(owned_ids.begin(), owned_ids.end(), id);
+      });
+    }
+  }
+  const lanelet::LineString3d & seg = pline[mid];
+  int ix, iy;
+  tile_index(
+    (seg.front().x() + seg.back().x()) / 2.0, (seg.front().y() + seg.back().y()) / 2.0, extent,
+    tile_size, nx, ny, ix, iy);
+  return ix == tile.ix && iy == tile.iy;
+}
+
+/*****************************************************************
+ * Check if a linestring (by its middle point) is owned by tile
+ ******************************************************************/
+bool ctiling::owned(
+  const lanelet::LineString3d & ls, const s_tile & tile, const Eigen::AlignedBox2d & extent,
+  const double tile_size, const int nx, const int ny)
+{
+  if (ls.empty()) {
+    return false;
+  }
+  int ix, iy;
+  tile_index(ls[ls.size() / 2].x(), ls[ls.size() / 2].y(), extent, tile_size, nx, ny, ix, iy);
+  return ix == tile.ix && iy == tile.iy;
+}
+
+/********************************************************************
+ * Get tile index of a point (clamped to the tiles of the extent)
+ *********************************************************************/
+void ctiling::tile_index(
+  const double x, const double y, const Eigen::AlignedBox2d & extent, const double tile_size,
+  const int nx, const int ny, int & ix, int & iy)
+{
+  ix = static_cast<int>(std::floor((x - extent.min().x()) / tile_size));
+  iy = static_cast<int>(std::floor((y - extent.min().y()) / tile_size));
+  ix = std::clamp(ix, 0, nx - 1);
+  iy = std::clamp(iy, 0, ny - 1);
+}
+
+/*******************************************************************
+ * Get lanelet ids a reference polyline segment is representing
+ ********************************************************************/
+lanelet::Ids ctiling::ref_ids(const lanelet::LineString3d & seg)
+{
+  lanelet::Ids ids;
+  for (const auto & att : seg.attributes()) {
+    if (
+      att.first.find("ll_id_forward_") != std::string::npos ||
+      att.first.find("ll_id_backward_") != std::string::npos) {
+      ids.push_back(*att.second.asId());
+    }
+  }
+  return ids;
+}
+
+/***************************************************************************
+ * Remove lanelet ids from a reference polyline segment and re-index the
+ * remaining forward/backward attributes
+ ****************************************************************************/
+void ctiling::remove_ref_ids(lanelet::LineString3d & seg, const lanelet::Ids & ids)
+{
+  lanelet::Ids forward_Ids, backward_Ids;
+  std::vector<std::string> keys;
+  for (const auto & att : seg.attributes()) {
+    const bool forward = att.first.find("ll_id_forward_") != std::string::npos;
+    const bool backward = att.first.find("ll_id_backward_") != std::string::npos;
+    if (!forward && !backward) {
+      continue;
+    }
+    keys.push_back(att.first);
+    const lanelet::Id id = *att.second.asId();
+    if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+      (forward) ? forward_Ids.push_back(id) : backward_Ids.push_back(id);
+    }
+  }
+  // Delete current attributes
+  auto & attr = seg.attributes();
+  for (const auto & key : keys) {
+    auto it = attr.find(key);
+    if (it != attr.end()) {
+      attr.erase(it);
+    }
+  }
+  // Re-index remaining ids
+  int i = 1;
+  for (const auto & id : forward_Ids) {
+    attr["ll_id_forward_" + std::to_string(i)] = id;
+    ++i;
+  }
+  i = 1;
+  for (const auto & id : backward_Ids) {
+    attr["ll_id_backward_" + std::to_string(i)] = id;
+    ++i;
+  }
+}
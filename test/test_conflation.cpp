@@ -0,0 +1,76 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "conflation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+/*******************************************************************************
+ * Create lanelet between two parallel boundaries carrying the tags a previous
+ * conflation transferred from openstreetmap
+ ********************************************************************************/
+lanelet::Lanelet create_conflated_ll()
+{
+  lanelet::LineString3d left(
+    next_id(), {lanelet::Point3d(next_id(), 0.0, 3.0, 0.0),
+                lanelet::Point3d(next_id(), 10.0, 3.0, 0.0)});
+  lanelet::LineString3d right(
+    next_id(), {lanelet::Point3d(next_id(), 0.0, 0.0, 0.0),
+                lanelet::Point3d(next_id(), 10.0, 0.0, 0.0)});
+  lanelet::Lanelet ll(next_id(), left, right);
+  ll.attributes()["subtype"] = "road";
+  ll.attributes()["location"] = "urban";
+  ll.attributes()["speed_limit"] = "50";
+  ll.attributes()["road_name"] = "Arcisstraße";
+  ll.attributes()["one_way"] = "no";
+  ll.attributes()["road_surface"] = "asphalt";
+  ll.attributes()["lane_markings"] = "yes";
+  return ll;
+}
+
+/***********************************************************************
+ * Incremental update: tags and color codes of a previous conflation are
+ * removed from the region (a way without maxspeed leaves no speed_limit)
+ * => subtype/location and lanelets outside of the region are kept
+ ************************************************************************/
+TEST(conflation_test, clear_conflated_tags)
+{
+  lanelet::Lanelets region = {create_conflated_ll()};
+  const lanelet::Lanelet outside = create_conflated_ll();
+  s_color_table cols;
+  cols.insert(region.front().id(), "r");
+  cols.insert(outside.id(), "r");
+
+  cconflation conflation;
+  ASSERT_TRUE(conflation.clear_conflated_tags(region, cols));
+
+  const lanelet::Lanelet & ll = region.front();
+  for (const std::string key :
+       {"speed_limit", "road_name", "one_way", "road_surface", "lane_markings"}) {
+    EXPECT_FALSE(ll.hasAttribute(key)) << key;
+    EXPECT_TRUE(outside.hasAttribute(key)) << key;
+  }
+  EXPECT_EQ(ll.attribute("subtype").value(), "road");
+  EXPECT_EQ(ll.attribute("location").value(), "urban");
+  EXPECT_FALSE(cols.contains(ll.id()));
+  EXPECT_EQ(cols.code(outside.id()), "r");
+}
@@ -0,0 +1,206 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "file_in.hpp"
+#include "file_out.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Node providing the node_name parameter read by the file modules
+ * and temporary directory for the written files
+ ********************************************************************/
+class file_io_test : public ::testing::Test
+{
+protected:
+  static void SetUpTestSuite() { rclcpp::init(0, nullptr); }
+  static void TearDownTestSuite() { rclcpp::shutdown(); }
+
+  void SetUp() override
+  {
+    this->node = std::make_shared<rclcpp::Node>("test_file_io");
+    this->node->declare_parameter("node_name", std::string("test_file_io"));
+    this->dir = std::filesystem::temp_directory_path() / "test_file_io";
+    std::filesystem::create_directories(this->dir);
+  }
+  void TearDown() override { std::filesystem::remove_all(this->dir); }
+
+  // Write content to file in temporary directory and return its path
+  std::string write_file(const std::string & name, const std::string & content)
+  {
+    const std::string path = (this->dir / name).string();
+    std::ofstream file(path);
+    file << content;
+    return path;
+  }
+
+  std::shared_ptr<rclcpp::Node> node;
+  std::filesystem::path dir;
+  cfile_in file_in;
+  cfile_out file_out;
+};
+
+/****************************************************************
+ * Match table: records survive a write/read round trip
+ * => records without lanelets are dropped, unmatched are kept
+ *****************************************************************/
+TEST_F(file_io_test, match_table_round_trip)
+{
+  std::vector<s_match_record> table(3);
+  table[0].ll_ids = {1001, 1002};
+  table[0].osm_ids = {-42, 7};
+  table[1].ll_ids = {1003};
+  table[2].osm_ids = {8};
+
+  const std::string path = (this->dir / "table.txt").string();
+  ASSERT_TRUE(file_out.write_match_table(*node, path, table));
+  std::vector<s_match_record> read;
+  ASSERT_TRUE(file_in.read_match_table(*node, path, read));
+
+  ASSERT_EQ(read.size(), 2u);
+  EXPECT_EQ(read[0].ll_ids, table[0].ll_ids);
+  EXPECT_EQ(read[0].osm_ids, table[0].osm_ids);
+  EXPECT_EQ(read[1].ll_ids, table[1].ll_ids);
+  EXPECT_TRUE(read[1].osm_ids.empty());
+}
+
+/****************************************************************
+ * Match table: malformed ids and missing files are rejected
+ *****************************************************************/
+TEST_F(file_io_test, match_table_errors)
+{
+  std::vector<s_match_record> read;
+  const std::string path = write_file("table.txt", "1001 1002 ; 42\n1003 ; abc\n");
+  EXPECT_FALSE(file_in.read_match_table(*node, path, read));
+  EXPECT_FALSE(file_in.read_match_table(*node, (this->dir / "missing.txt").string(), read));
+}
+
+/***********************************************************************
+ * OsmChange: created, modified and deleted ways and ways of modified
+ * nodes are reported and the diff is applied to the excerpt
+ ************************************************************************/
+TEST_F(file_io_test, osm_change_apply)
+{
+  const std::string osm_path = write_file(
+    "map.osm",
+    "<osm version=\"0.6\">\n"
+    "  <node id=\"1\" lat=\"48.0\" lon=\"11.0\"/>\n"
+    "  <node id=\"2\" lat=\"48.1\" lon=\"11.0\"/>\n"
+    "  <node id=\"3\" lat=\"48.2\" lon=\"11.0\"/>\n"
+    "  <node id=\"4\" lat=\"48.3\" lon=\"11.0\"/>\n"
+    "  <way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/></way>\n"
+    "  <way id=\"11\"><nd ref=\"2\"/><nd ref=\"3\"/></way>\n"
+    "  <way id=\"12\"><nd ref=\"3\"/><nd ref=\"4\"/></way>\n"
+    "</osm>\n");
+  const std::string osc_path = write_file(
+    "diff.osc",
+    "<osmChange version=\"0.6\">\n"
+    "  <modify><node id=\"1\" lat=\"48.05\" lon=\"11.0\"/></modify>\n"
+    "  <delete><way id=\"11\"/></delete>\n"
+    "  <create><way id=\"13\"><nd ref=\"4\"/><nd ref=\"1\"/></way></create>\n"
+    "</osmChange>\n");
+
+  const std::string out_path = (this->dir / "map_updated.osm").string();
+  lanelet::Ids ways;
+  ASSERT_TRUE(file_in.apply_osm_change(*node, osm_path, osc_path, out_path, ways));
+  // Way 10 by its modified node, 12 is untouched
+  EXPECT_EQ(ways, (lanelet::Ids{10, 11, 13}));
+
+  boost::property_tree::ptree osm;
+  boost::property_tree::read_xml(out_path, osm);
+  lanelet::Ids way_ids;
+  double lat_1 = 0.0;
+  for (const auto & ele : osm.get_child("osm")) {
+    if (ele.first == "way") {
+      way_ids.push_back(ele.second.get<lanelet::Id>("<xmlattr>.id"));
+    } else if (ele.first == "node" && ele.second.get<lanelet::Id>("<xmlattr>.id") == 1) {
+      lat_1 = ele.second.get<double>("<xmlattr>.lat");
+    }
+  }
+  EXPECT_EQ(way_ids, (lanelet::Ids{10, 12, 13}));
+  EXPECT_DOUBLE_EQ(lat_1, 48.05);
+
+  // Input excerpt is kept
+  boost::property_tree::ptree osm_in;
+  boost::property_tree::read_xml(osm_path, osm_in);
+  EXPECT_EQ(osm_in.get_child("osm").count("way"), 3u);
+}
+
+/***********************************************************************
+ * OsmChange: a modified way without a tag replaces the tagged way
+ * => removed tag does not survive in the updated excerpt
+ ************************************************************************/
+TEST_F(file_io_test, osm_change_delete_tag)
+{
+  const std::string osm_path = write_file(
+    "map.osm",
+    "<osm version=\"0.6\">\n"
+    "  <node id=\"1\" lat=\"48.0\" lon=\"11.0\"/>\n"
+    "  <node id=\"2\" lat=\"48.1\" lon=\"11.0\"/>\n"
+    "  <way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/>"
+    "<tag k=\"highway\" v=\"primary\"/><tag k=\"maxspeed\" v=\"50\"/></way>\n"
+    "</osm>\n");
+  const std::string osc_path = write_file(
+    "diff.osc",
+    "<osmChange version=\"0.6\">\n"
+    "  <modify><way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/>"
+    "<tag k=\"highway\" v=\"primary\"/></way></modify>\n"
+    "</osmChange>\n");
+
+  const std::string out_path = (this->dir / "map_updated.osm").string();
+  lanelet::Ids ways;
+  ASSERT_TRUE(file_in.apply_osm_change(*node, osm_path, osc_path, out_path, ways));
+  EXPECT_EQ(ways, (lanelet::Ids{10}));
+
+  boost::property_tree::ptree osm;
+  boost::property_tree::read_xml(out_path, osm);
+  std::vector<std::string> keys;
+  for (const auto & ele : osm.get_child("osm.way")) {
+    if (ele.first == "tag") {
+      keys.push_back(ele.second.get<std::string>("<xmlattr>.k"));
+    }
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"highway"}));
+}
+
+/****************************************************************
+ * OsmChange: files of other formats are rejected
+ *****************************************************************/
+TEST_F(file_io_test, osm_change_wrong_format)
+{
+  const std::string osm_path = write_file("map.osm", "<osm version=\"0.6\"/>\n");
+  const std::string osc_path = write_file("diff.osc", "<osm version=\"0.6\"/>\n");
+  const std::string out_path = (this->dir / "map_updated.osm").string();
+  lanelet::Ids ways;
+  EXPECT_FALSE(file_in.apply_osm_change(*node, osm_path, osc_path, out_path, ways));
+  EXPECT_FALSE(file_in.apply_osm_change(
+    *node, osm_path, (this->dir / "missing.osc").string(), out_path, ways));
+  EXPECT_FALSE(std::filesystem::exists(out_path));
+}
@@ -0,0 +1,447 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "matching.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+/*******************************************************************
+ * Access to the private steps of the matching
+ ********************************************************************/
+struct s_matching_test
+{
+  static bool select_candidate(
+    cmatching & matching, const lanelet::LineStrings3d & ref, const scratch_plines & candidates,
+    size_t & ind, s_measures & measures, const s_param_scoring & scoring)
+  {
+    return matching.select_candidate(ref, candidates, ind, measures, scoring);
+  }
+  static const s_eval_stats & eval_stats(const cmatching & matching)
+  {
+    return matching.eval_stats;
+  }
+  static double frechet_rows(
+    cmatching & matching, const std::pmr::vector<lanelet::BasicPoint2d> & pts1,
+    const std::pmr::vector<lanelet::BasicPoint2d> & pts2, const size_t band, const double thr)
+  {
+    matching.frechet_band = band;
+    return matching.frechet_rows(pts1, pts2, thr);
+  }
+  static std::vector<lanelet::Ids> matching_candidates(
+    cmatching & matching, const lanelet::LineStrings3d & ref_pline, const scratch_points & buffers,
+    const s_seg_table & seg, const bool heading_filter)
+  {
+    matching.arena.reset();
+    matching.heading_filter = heading_filter;
+    matching.heading_tol = std::atan(1.0);
+    s_seg_view view(seg);
+    std::vector<lanelet::Ids> ids;
+    for (const auto & candidate : matching.matching_candidates(ref_pline, buffers, view)) {
+      ids.emplace_back();
+      for (const auto & ls : candidate) {
+        ids.back().push_back(ls.id());
+      }
+    }
+    return ids;
+  }
+};
+
+/*******************************************************************************
+ * Create polyline of segments (2 points) through the given points
+ ********************************************************************************/
+lanelet::LineStrings3d create_pline(const std::vector<Eigen::Vector2d> & pts)
+{
+  lanelet::LineStrings3d pline;
+  lanelet::Point3d pt(lanelet::InvalId, pts.front().x(), pts.front().y(), 0.0);
+  for (size_t i = 1; i < pts.size(); ++i) {
+    lanelet::Point3d pt_(lanelet::InvalId, pts[i].x(), pts[i].y(), 0.0);
+    pline.push_back(lanelet::LineString3d(lanelet::InvalId, {pt, pt_}));
+    pt = pt_;
+  }
+  return pline;
+}
+
+/*******************************************************************************
+ * Create random candidate along the reference points (offset, noise, shortened
+ * ends and different number of points)
+ ********************************************************************************/
+std::vector<Eigen::Vector2d> create_candidate(
+  const std::vector<Eigen::Vector2d> & ref, std::mt19937 & gen)
+{
+  std::uniform_real_distribution<double> offset(-6.0, 6.0);
+  std::uniform_real_distribution<double> cut(0.0, 0.2);
+  std::uniform_int_distribution<size_t> num(3, 15);
+  std::normal_distribution<double> noise(0.0, 1.5);
+  const Eigen::Vector2d shift(offset(gen), offset(gen));
+  const double t0 = cut(gen);
+  const double t1 = 1.0 - cut(gen);
+  const size_t n = num(gen);
+  std::vector<Eigen::Vector2d> pts;
+  for (size_t i = 0; i < n; ++i) {
+    // Interpolate the reference points at the relative position
+    const double t = (t0 + (t1 - t0) * i / (n - 1)) * (ref.size() - 1);
+    const size_t k = std::min(static_cast<size_t>(t), ref.size() - 2);
+    const Eigen::Vector2d pt = ref[k] + (t - k) * (ref[k + 1] - ref[k]);
+    pts.push_back(pt + shift + Eigen::Vector2d(noise(gen), noise(gen)));
+  }
+  return pts;
+}
+
+/*******************************************************************************
+ * Weighted score of the measures of a candidate with all measures calculated
+ ********************************************************************************/
+double full_score(const s_measures & m, const s_score_profile & p)
+{
+  const double lim_angle = p.lim_angle * std::atan(1.0) * 4 / 180.0;
+  return (p.use_angle ? p.w_angle * (1.0 - m.d_ang / lim_angle) : 0.0) +
+         (p.use_length ? p.w_len * (1.0 - m.d_len / p.lim_length) : 0.0) +
+         (p.use_chord ? p.w_chord * (1.0 - m.d_chord / p.lim_chord) : 0.0) +
+         (p.use_poly ? p.w_poly * (1.0 - m.d_poly / p.lim_poly) : 0.0) +
+         (p.use_frechet ? p.w_frechet * (1.0 - m.d_frechet / p.lim_frechet) : 0.0);
+}
+
+/*******************************************************************************
+ * Bounded search selects the same candidate (with the same measures) as scoring
+ * every candidate completely
+ ********************************************************************************/
+void expect_exhaustive_selection(const s_score_profile & profile)
+{
+  std::mt19937 gen(42);
+  std::normal_distribution<double> noise(0.0, 0.3);
+  const s_param_scoring scoring(profile);
+  cmatching bounded;
+  size_t measures_exhaustive = 0;
+  for (size_t trial = 0; trial < 200; ++trial) {
+    // Reference polyline (random heading walk)
+    std::vector<Eigen::Vector2d> ref_pts{Eigen::Vector2d::Zero()};
+    double heading = 0.0;
+    for (size_t i = 0; i < 10; ++i) {
+      heading += noise(gen);
+      const Eigen::Vector2d dir(std::cos(heading), std::sin(heading));
+      ref_pts.push_back(ref_pts.back() + 8.0 * dir);
+    }
+    const lanelet::LineStrings3d ref = create_pline(ref_pts);
+    std::vector<lanelet::LineStrings3d> plines;
+    scratch_plines candidates;
+    for (size_t i = 0; i < 8; ++i) {
+      plines.push_back(create_pline(create_candidate(ref_pts, gen)));
+      candidates.emplace_back(plines.back().begin(), plines.back().end());
+    }
+
+    // Exhaustive => every candidate on its own (all measures unless rejected by a limit)
+    bool found_exhaustive = false;
+    size_t ind_exhaustive = 0;
+    s_measures m_exhaustive;
+    double score_max = 0.0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      cmatching single;
+      scratch_plines candidate{candidates[i]};
+      size_t ind = 0;
+      s_measures m;
+      const bool found = s_matching_test::select_candidate(single, ref, candidate, ind, m, scoring);
+      measures_exhaustive += s_matching_test::eval_stats(single).measures;
+      if (!found) {
+        continue;
+      }
+      const double score = full_score(m, profile);
+      if (!found_exhaustive || score > score_max) {
+        found_exhaustive = true;
+        ind_exhaustive = i;
+        m_exhaustive = m;
+        score_max = score;
+      }
+    }
+
+    // Bounded search over all candidates
+    size_t ind = 0;
+    s_measures m;
+    const bool found = s_matching_test::select_candidate(bounded, ref, candidates, ind, m, scoring);
+    ASSERT_EQ(found, found_exhaustive) << "trial " << trial;
+    if (found) {
+      EXPECT_EQ(ind, ind_exhaustive) << "trial " << trial;
+      EXPECT_NEAR(m.d_ang, m_exhaustive.d_ang, 1e-9);
+      EXPECT_NEAR(m.d_len, m_exhaustive.d_len, 1e-9);
+      EXPECT_NEAR(m.d_chord, m_exhaustive.d_chord, 1e-9);
+      EXPECT_NEAR(m.d_poly, m_exhaustive.d_poly, 1e-9);
+      EXPECT_NEAR(m.d_frechet, m_exhaustive.d_frechet, 1e-9);
+    }
+  }
+  // Bounded search saves measures by pruning
+  EXPECT_GT(s_matching_test::eval_stats(bounded).pruned, 0u);
+  EXPECT_LT(s_matching_test::eval_stats(bounded).measures, measures_exhaustive);
+}
+
+TEST(matching_test, bounded_selection_all_measures)
+{
+  expect_exhaustive_selection(
+    {true, true, true, true, true, 20.0, 20.0, 15.0, 10.0, 10.0, 0.3, 0.2, 0.3, 0.1, 0.1});
+}
+
+TEST(matching_test, bounded_selection_fixed_profiles)
+{
+  expect_exhaustive_selection(profile_motorway);
+  expect_exhaustive_selection(profile_urban);
+}
+
+/*******************************************************************************
+ * Random heading walk and a noisy copy with a different number of points
+ ********************************************************************************/
+void create_points(
+  std::mt19937 & gen, std::pmr::vector<lanelet::BasicPoint2d> & pts1,
+  std::pmr::vector<lanelet::BasicPoint2d> & pts2)
+{
+  std::normal_distribution<double> noise(0.0, 0.3);
+  std::uniform_int_distribution<size_t> num(2, 30);
+  std::vector<Eigen::Vector2d> ref{Eigen::Vector2d::Zero()};
+  double heading = 0.0;
+  for (size_t i = 0; i < 10; ++i) {
+    heading += noise(gen);
+    ref.push_back(ref.back() + 8.0 * Eigen::Vector2d(std::cos(heading), std::sin(heading)));
+  }
+  pts1.clear();
+  pts2.clear();
+  for (const auto & pts : {&pts1, &pts2}) {
+    const size_t n = num(gen);
+    for (size_t i = 0; i < n; ++i) {
+      const double t = static_cast<double>(i) / (n - 1) * (ref.size() - 1);
+      const size_t k = std::min(static_cast<size_t>(t), ref.size() - 2);
+      const Eigen::Vector2d pt = ref[k] + (t - k) * (ref[k + 1] - ref[k]);
+      pts->push_back(pt + 5.0 * Eigen::Vector2d(noise(gen), noise(gen)));
+    }
+  }
+}
+
+/*******************************************************************************
+ * Discrete Frechet distance by the full dynamic programming table
+ ********************************************************************************/
+double frechet_table(
+  const std::pmr::vector<lanelet::BasicPoint2d> & pts1,
+  const std::pmr::vector<lanelet::BasicPoint2d> & pts2)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> c(pts1.size(), std::vector<double>(pts2.size(), inf));
+  for (size_t i = 0; i < pts1.size(); ++i) {
+    for (size_t j = 0; j < pts2.size(); ++j) {
+      const double d = (pts1[i] - pts2[j]).norm();
+      if (i == 0 && j == 0) {
+        c[i][j] = d;
+        continue;
+      }
+      const double reach = std::min(
+        {(i > 0) ? c[i - 1][j] : inf, (j > 0) ? c[i][j - 1] : inf,
+         (i > 0 && j > 0) ? c[i - 1][j - 1] : inf});
+      c[i][j] = std::max(d, reach);
+    }
+  }
+  return c.back().back();
+}
+
+/****************************************************************
+ * Without band and threshold => distance of the full table
+ *****************************************************************/
+TEST(matching_test, frechet_exact)
+{
+  std::mt19937 gen(42);
+  cmatching matching;
+  std::pmr::vector<lanelet::BasicPoint2d> pts1, pts2;
+  const double inf = std::numeric_limits<double>::infinity();
+  for (size_t trial = 0; trial < 200; ++trial) {
+    create_points(gen, pts1, pts2);
+    EXPECT_NEAR(
+      s_matching_test::frechet_rows(matching, pts1, pts2, 0, inf), frechet_table(pts1, pts2),
+      1e-9);
+  }
+}
+
+/************************************************************************
+ * Band restricts the couplings => upper bound of the distance, exact if
+ * the band covers the whole table
+ *************************************************************************/
+TEST(matching_test, frechet_band)
+{
+  std::mt19937 gen(42);
+  cmatching matching;
+  std::pmr::vector<lanelet::BasicPoint2d> pts1, pts2;
+  const double inf = std::numeric_limits<double>::infinity();
+  for (size_t trial = 0; trial < 200; ++trial) {
+    create_points(gen, pts1, pts2);
+    const double exact = frechet_table(pts1, pts2);
+    for (const size_t band : {1, 2, 5}) {
+      const double d = s_matching_test::frechet_rows(matching, pts1, pts2, band, inf);
+      EXPECT_GE(d, exact - 1e-9);
+      EXPECT_LT(d, inf);
+    }
+    const size_t band = std::max(pts1.size(), pts2.size());
+    EXPECT_NEAR(s_matching_test::frechet_rows(matching, pts1, pts2, band, inf), exact, 1e-9);
+  }
+}
+
+/************************************************************************
+ * Early abandon => lower bound of at least the threshold if the distance
+ * exceeds it, otherwise exact
+ *************************************************************************/
+TEST(matching_test, frechet_early_abandon)
+{
+  std::mt19937 gen(42);
+  cmatching matching;
+  std::pmr::vector<lanelet::BasicPoint2d> pts1, pts2;
+  for (size_t trial = 0; trial < 200; ++trial) {
+    create_points(gen, pts1, pts2);
+    const double exact = frechet_table(pts1, pts2);
+    const double below = s_matching_test::frechet_rows(matching, pts1, pts2, 0, 0.5 * exact);
+    EXPECT_GE(below, 0.5 * exact);
+    EXPECT_LE(below, exact + 1e-9);
+    EXPECT_NEAR(s_matching_test::frechet_rows(matching, pts1, pts2, 0, 2.0 * exact), exact, 1e-9);
+  }
+}
+
+/************************************************************************
+ * Reversed second polyline (undirected openstreetmap-ways) => same
+ * distance as in the direction of the first polyline
+ *************************************************************************/
+TEST(matching_test, frechet_reversed)
+{
+  std::mt19937 gen(42);
+  cmatching matching;
+  std::pmr::vector<lanelet::BasicPoint2d> pts1, pts2;
+  const double inf = std::numeric_limits<double>::infinity();
+  for (size_t trial = 0; trial < 200; ++trial) {
+    create_points(gen, pts1, pts2);
+    std::pmr::vector<lanelet::BasicPoint2d> pts2_rev(pts2.rbegin(), pts2.rend());
+    for (const size_t band : {0, 2}) {
+      EXPECT_NEAR(
+        s_matching_test::frechet_rows(matching, pts1, pts2_rev, band, inf),
+        s_matching_test::frechet_rows(matching, pts1, pts2, band, inf), 1e-9);
+    }
+    EXPECT_NEAR(
+      s_matching_test::frechet_rows(matching, pts1, pts2_rev, 0, inf), frechet_table(pts1, pts2),
+      1e-9);
+  }
+}
+
+/************************************************************************
+ * Point -> segment adjacency of the split table equals a scan of all
+ * segments (junctions, interpolated points, segments in both directions)
+ *************************************************************************/
+TEST(matching_test, point_adjacency)
+{
+  auto pt = [](const double x, const double y) {
+    return lanelet::Point3d(next_id(), x, y, 0.0);
+  };
+  const lanelet::Point3d a = pt(0.0, 0.0), b = pt(20.0, 0.0), c = pt(40.0, 5.0);
+  const lanelet::Point3d d = pt(20.0, 30.0), e = pt(-10.0, -10.0);
+  const lanelet::LineStrings3d lss = {
+    lanelet::LineString3d(next_id(), {a, b, c}), lanelet::LineString3d(next_id(), {d, b}),
+    lanelet::LineString3d(next_id(), {b, e, a})};
+
+  cmatching matching;
+  const s_seg_table seg = matching.split_lss(lss, 7.0);
+  ASSERT_EQ(seg.pt_seg_off.size(), seg.pts.size() + 1);
+  for (uint32_t p = 0; p < seg.pts.size(); ++p) {
+    std::vector<uint32_t> scan;
+    for (uint32_t i = 0; i < seg.size(); ++i) {
+      if (seg.p0[i] == p || seg.p1[i] == p) {
+        scan.push_back(i);
+      }
+    }
+    const std::vector<uint32_t> adj(
+      seg.pt_seg.begin() + seg.pt_seg_off[p], seg.pt_seg.begin() + seg.pt_seg_off[p + 1]);
+    EXPECT_EQ(adj, scan) << "point " << p;
+  }
+  // Junction point b: two segments of the first, one of the second and third linestring
+  EXPECT_EQ(seg.pt_seg_off[seg.pt_ind.at(b.id()) + 1] - seg.pt_seg_off[seg.pt_ind.at(b.id())], 4u);
+}
+
+/************************************************************************
+ * Heading-binned index without heading filter returns the same candidates
+ * as testing all segments (random network with junctions), the heading
+ * filter only drops candidates
+ *************************************************************************/
+TEST(matching_test, heading_index_lossless)
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> pos(0.0, 300.0);
+  std::uniform_real_distribution<double> turn(-0.8, 0.8);
+  std::uniform_real_distribution<double> step(5.0, 25.0);
+
+  // Random walks, most of them starting at a point of a previous walk (junction)
+  lanelet::LineStrings3d lss;
+  lanelet::Points3d starts;
+  for (size_t k = 0; k < 40; ++k) {
+    lanelet::Point3d pt = (starts.empty() || gen() % 4 == 0)
+                            ? lanelet::Point3d(next_id(), pos(gen), pos(gen), 0.0)
+                            : starts[gen() % starts.size()];
+    double h = turn(gen) * 4;
+    lanelet::LineString3d ls(next_id(), {pt});
+    for (size_t j = 0; j < 8; ++j) {
+      h += turn(gen);
+      const double len = step(gen);
+      ls.push_back(
+        lanelet::Point3d(next_id(), ls.back().x() + len * std::cos(h),
+                         ls.back().y() + len * std::sin(h), 0.0));
+      starts.push_back(ls.back());
+    }
+    lss.push_back(ls);
+  }
+
+  cmatching matching;
+  s_seg_table seg = matching.split_lss(lss, 10.0);
+  s_seg_table indexed = seg;
+  seg.index_headings(50.0, 0);
+  indexed.index_headings(50.0, 16);
+
+  // Reference polylines along the walks with an offset (and random ones)
+  std::normal_distribution<double> noise(0.0, 2.0);
+  size_t found = 0;
+  for (size_t trial = 0; trial < 200; ++trial) {
+    std::vector<Eigen::Vector2d> ref;
+    if (trial % 4 == 0) {
+      ref = {Eigen::Vector2d(pos(gen), pos(gen)), Eigen::Vector2d(pos(gen), pos(gen))};
+    } else {
+      const lanelet::LineString3d & ls = lss[gen() % lss.size()];
+      const size_t j0 = gen() % (ls.size() - 2);
+      for (size_t j = j0; j < std::min(j0 + 4, ls.size()); ++j) {
+        ref.emplace_back(ls[j].x() + noise(gen), ls[j].y() + noise(gen));
+      }
+    }
+    const lanelet::LineStrings3d ref_pline = create_pline(ref);
+    scratch_points buffers;
+    buffer_polygons(ref_pline, 8.0, 10.0, 2.0, buffers);
+
+    const auto all = s_matching_test::matching_candidates(matching, ref_pline, buffers, seg, false);
+    const auto index =
+      s_matching_test::matching_candidates(matching, ref_pline, buffers, indexed, false);
+    EXPECT_EQ(index, all) << "trial " << trial;
+    found += all.empty() ? 0 : 1;
+
+    const auto filter =
+      s_matching_test::matching_candidates(matching, ref_pline, buffers, indexed, true);
+    EXPECT_LE(filter.size(), all.size()) << "trial " << trial;
+  }
+  // Test is not vacuous
+  EXPECT_GT(found, 50u);
+}
@@ -0,0 +1,77 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "messages.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+/*********************************************************************
+ * Binary map message with repetitive data (compressible)
+ **********************************************************************/
+autoware_auto_mapping_msgs::msg::HADMapBin create_bin_msg()
+{
+  autoware_auto_mapping_msgs::msg::HADMapBin msg;
+  msg.header.frame_id = "map";
+  msg.format_version = "1";
+  msg.map_format_version = "2";
+  msg.map_version = "3";
+  for (size_t i = 0; i < 10000; ++i) {
+    msg.data.push_back(static_cast<uint8_t>(i % 7));
+  }
+  return msg;
+}
+
+/****************************************************************
+ * Compressed binary map is restored by consumers unchanged
+ *****************************************************************/
+TEST(messages_test, bin_msg_compression_round_trip)
+{
+  cmessages msgs;
+  const autoware_auto_mapping_msgs::msg::HADMapBin msg = create_bin_msg();
+  tum_lanelet2_osm_fusion::msg::CompressedMapBin msg_comp;
+  ASSERT_TRUE(msgs.compress_bin_msg(msg, 6, msg_comp));
+  EXPECT_LT(msg_comp.data.size(), msg.data.size());
+  EXPECT_EQ(msg_comp.size, msg.data.size());
+
+  autoware_auto_mapping_msgs::msg::HADMapBin msg_out;
+  ASSERT_TRUE(msgs.decompress_bin_msg(msg_comp, msg_out));
+  EXPECT_EQ(msg_out, msg);
+}
+
+/****************************************************************
+ * Corrupted data or a wrong size is rejected by consumers
+ *****************************************************************/
+TEST(messages_test, bin_msg_decompression_errors)
+{
+  cmessages msgs;
+  tum_lanelet2_osm_fusion::msg::CompressedMapBin msg_comp;
+  ASSERT_TRUE(msgs.compress_bin_msg(create_bin_msg(), 6, msg_comp));
+  autoware_auto_mapping_msgs::msg::HADMapBin msg_out;
+
+  tum_lanelet2_osm_fusion::msg::CompressedMapBin msg_size = msg_comp;
+  msg_size.size -= 1;
+  EXPECT_FALSE(msgs.decompress_bin_msg(msg_size, msg_out));
+
+  tum_lanelet2_osm_fusion::msg::CompressedMapBin msg_data = msg_comp;
+  msg_data.data.resize(msg_data.data.size() / 2);
+  EXPECT_FALSE(msgs.decompress_bin_msg(msg_data, msg_out));
+}
@@ -0,0 +1,137 @@
+// Copyright 2023 Maximilian Leitenstern
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ========================================== //
+// Author: Maximilian Leitenstern (TUM)
+// Date: 17.10.2026
+// ========================================== //
+//
+//
+#include "partition.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+/*******************************************************************
+ * Access to the private steps of the partitioned matching
+ ********************************************************************/
+struct s_partition_test
+{
+  static bool merge_classes(
+    cpartition & partition, const std::vector<s_road_class> & classes,
+    std::vector<s_match> & matches)
+  {
+    return partition.merge_classes(classes, matches);
+  }
+};
+
+/*******************************************************************************
+ * Create straight polyline of one segment at the given lateral offset
+ ********************************************************************************/
+lanelet::LineStrings3d create_pline(const double offset)
+{
+  return {lanelet::LineString3d(
+    next_id(), {lanelet::Point3d(next_id(), 0.0, offset, 0.0),
+                lanelet::Point3d(next_id(), 50.0, offset, 0.0)})};
+}
+
+/*******************************************************************************
+ * Create match of a reference polyline (unmatched if target is empty) with its
+ * Frechet distance and a score that is only comparable within its class
+ ********************************************************************************/
+s_match create_match(
+  const lanelet::LineStrings3d & ref, const lanelet::LineStrings3d & target,
+  const double d_frechet, const double score)
+{
+  s_match match(ref, target, 5.0, 5.0, 1.0);
+  match.set_geo_measures(0.0, 0.0, 0.0, 0.0, d_frechet, d_frechet, 50.0, score);
+  return match;
+}
+
+/*******************************************************************************
+ * Create valid road class with the given matches
+ ********************************************************************************/
+s_road_class create_class(const std::string & name, const std::vector<s_match> & matches)
+{
+  s_road_class cl;
+  cl.name = name;
+  cl.matches = matches;
+  cl.valid = true;
+  return cl;
+}
+
+/************************************************************************
+ * Reference polylines matched in multiple classes keep the match with
+ * the smallest Frechet distance, regardless of class order and score
+ * => unmatched classes are skipped, ties keep the first class
+ *************************************************************************/
+TEST(partition_test, merge_by_frechet_distance)
+{
+  const std::vector<lanelet::LineStrings3d> refs = {
+    create_pline(0.0), create_pline(20.0), create_pline(40.0), create_pline(60.0)};
+  const lanelet::LineStrings3d motorway = create_pline(-6.0);
+  const lanelet::LineStrings3d road = create_pline(1.5);
+  const lanelet::LineStrings3d empty;
+
+  // 0: motorway far, road close | 1: motorway close, road far | 2: only road | 3: tie
+  const std::vector<s_match> m_motorway = {
+    create_match(refs[0], motorway, 6.0, 0.1), create_match(refs[1], motorway, 1.0, 0.9),
+    create_match(refs[2], empty, 0.0, 0.0), create_match(refs[3], motorway, 2.0, 0.5)};
+  const std::vector<s_match> m_highway = {
+    create_match(refs[0], empty, 0.0, 0.0), create_match(refs[1], empty, 0.0, 0.0),
+    create_match(refs[2], empty, 0.0, 0.0), create_match(refs[3], empty, 0.0, 0.0)};
+  const std::vector<s_match> m_road = {
+    create_match(refs[0], road, 1.5, 0.9), create_match(refs[1], road, 3.0, 0.1),
+    create_match(refs[2], road, 4.0, 0.5), create_match(refs[3], road, 2.0, 0.5)};
+  const std::vector<s_road_class> classes = {
+    create_class("motorway", m_motorway), create_class("highway", m_highway),
+    create_class("road", m_road)};
+
+  cpartition partition;
+  std::vector<s_match> matches;
+  ASSERT_TRUE(s_partition_test::merge_classes(partition, classes, matches));
+  ASSERT_EQ(matches.size(), refs.size());
+  EXPECT_EQ(matches[0].target_pline().front().id(), road.front().id());
+  EXPECT_EQ(matches[1].target_pline().front().id(), motorway.front().id());
+  EXPECT_EQ(matches[2].target_pline().front().id(), road.front().id());
+  EXPECT_EQ(matches[3].target_pline().front().id(), motorway.front().id());
+  for (size_t i = 0; i < refs.size(); ++i) {
+    EXPECT_EQ(matches[i].ref_pline().front().id(), refs[i].front().id());
+  }
+}
+
+/************************************************************************
+ * Polylines unmatched in every class stay unmatched, incomplete classes
+ * are rejected
+ *************************************************************************/
+TEST(partition_test, merge_unmatched_and_incomplete)
+{
+  const lanelet::LineStrings3d ref = create_pline(0.0);
+  const lanelet::LineStrings3d empty;
+  std::vector<s_road_class> classes = {
+    create_class("motorway", {create_match(ref, empty, 0.0, 0.0)}),
+    create_class("road", {create_match(ref, empty, 0.0, 0.0)})};
+
+  cpartition partition;
+  std::vector<s_match> matches;
+  ASSERT_TRUE(s_partition_test::merge_classes(partition, classes, matches));
+  ASSERT_EQ(matches.size(), 1u);
+  EXPECT_TRUE(matches[0].target_pline().empty());
+
+  classes[1].valid = false;
+  matches.clear();
+  EXPECT_FALSE(s_partition_test::merge_classes(partition, classes, matches));
+}